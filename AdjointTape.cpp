@@ -0,0 +1,83 @@
+#include "AdjointTape.h"
+#include <algorithm>
+#include <cmath>
+
+thread_local AdjointTape* AdjointTape::current_ = nullptr;
+
+AdjointTape::AdjointTape() :size_(0) {}
+
+AdjointTape& AdjointTape::local()
+{
+	thread_local AdjointTape tape;
+	current_ = &tape;
+	return tape;
+}
+
+ADouble AdjointTape::variable(double value)
+{
+	return ADouble(value, record(noNode, 0.0));
+}
+
+void AdjointTape::rewind(std::size_t mark)
+{
+	size_ = std::min(mark, size_);
+}
+
+void AdjointTape::propagate(const ADouble& output)
+{
+	adjoints_.assign(size_, 0.0);
+	if (output.node() == noNode)
+	{
+		return;
+	}
+
+	adjoints_[output.node()] = 1.0;
+	for (std::size_t n = output.node() + 1; n-- > 0; )
+	{
+		const double adjoint = adjoints_[n];
+		if (adjoint == 0.0)
+		{
+			continue;
+		}
+		const Entry& entry = blocks_[n / blockSize_][n % blockSize_];
+		for (int k = 0; k < 2; ++k)
+		{
+			if (entry.argument[k] != noNode)
+			{
+				adjoints_[entry.argument[k]] += adjoint * entry.partial[k];
+			}
+		}
+	}
+}
+
+double AdjointTape::adjoint(const ADouble& x) const
+{
+	return (x.node() < adjoints_.size()) ? adjoints_[x.node()] : 0.0;
+}
+
+std::size_t AdjointTape::size() const
+{
+	return size_;
+}
+
+std::size_t AdjointTape::capacity() const
+{
+	return blocks_.size() * blockSize_;
+}
+
+ADouble exp(const ADouble& a)
+{
+	const double e = std::exp(a.value());
+	return unaryResult(a, e, e);
+}
+
+ADouble log(const ADouble& a)
+{
+	return unaryResult(a, std::log(a.value()), 1.0 / a.value());
+}
+
+ADouble sqrt(const ADouble& a)
+{
+	const double s = std::sqrt(a.value());
+	return unaryResult(a, s, 0.5 / s);
+}
@@ -0,0 +1,182 @@
+#ifndef ADJOINT_TAPE_H
+#define ADJOINT_TAPE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class ADouble;
+
+// Tape for reverse-mode (adjoint) differentiation.  Every operation on an ADouble that depends on
+// an input appends a node:  the operation's one or two arguments and its partial derivatives with
+// respect to them.  One backward sweep from an output then gives its derivative with respect to
+// every input, at a cost that does not grow with the number of inputs.
+//
+// The nodes live in an arena of fixed-size blocks that is never given back:  rewind(.) drops the
+// nodes recorded since a mark in constant time, so a tape reused path after path allocates only
+// while it grows to the longest path.  Each thread records on its own tape (local()).
+class AdjointTape
+{
+public:
+	typedef std::uint32_t Node;
+	static const Node noNode = 0xFFFFFFFFu;	// A constant:  not on the tape
+
+	AdjointTape();
+
+	// This thread's tape
+	static AdjointTape& local();
+
+	// The tape the operations on ADouble record on:  this thread's, made by local() on the thread's
+	// first call.  Inline, unlike local(), as it is called per operation; after the first call it is
+	// one well-predicted test.
+	static AdjointTape& current()
+	{
+		return (current_ != nullptr) ? *current_ : local();
+	}
+
+	// An input (a node with no arguments)
+	ADouble variable(double value);
+
+	// Appends the result of an operation on a (and b), with partial derivatives da (and db)
+	Node record(Node a, double da)
+	{
+		Entry& entry = append_();
+		entry.argument[0] = a;
+		entry.argument[1] = noNode;
+		entry.partial[0] = da;
+		entry.partial[1] = 0.0;
+		return size_ - 1;
+	}
+
+	Node record(Node a, double da, Node b, double db)
+	{
+		Entry& entry = append_();
+		entry.argument[0] = a;
+		entry.argument[1] = b;
+		entry.partial[0] = da;
+		entry.partial[1] = db;
+		return size_ - 1;
+	}
+
+	// The number of nodes, to rewind(.) to later
+	std::size_t mark() const
+	{
+		return size_;
+	}
+
+	// Drops the nodes recorded since mark (the memory is kept)
+	void rewind(std::size_t mark);
+
+	// Sweeps back from output:  afterwards adjoint(x) is d(output)/dx for every x recorded before it
+	void propagate(const ADouble& output);
+	double adjoint(const ADouble& x) const;
+
+	std::size_t size() const;
+	std::size_t capacity() const;	// Nodes the arena holds without allocating
+
+private:
+	struct Entry
+	{
+		Node argument[2];
+		double partial[2];
+	};
+
+	static const std::size_t blockSize_ = 4096;	// Entries per block
+
+	Entry& append_()
+	{
+		if (size_ == blocks_.size() * blockSize_)
+		{
+			blocks_.emplace_back(new Entry[blockSize_]);
+		}
+		const std::size_t index = size_++;
+		return blocks_[index / blockSize_][index % blockSize_];
+	}
+
+	static thread_local AdjointTape* current_;
+
+	std::vector<std::unique_ptr<Entry[]> > blocks_;
+	std::size_t size_;
+	std::vector<double> adjoints_;	// Of the nodes up to the last output propagated
+};
+
+// A double that records its operations on this thread's AdjointTape.  A constant (converted from
+// a double, or computed from constants only) records nothing.
+class ADouble
+{
+public:
+	ADouble(double value = 0.0) :value_(value), node_(AdjointTape::noNode) {}
+	ADouble(double value, AdjointTape::Node node) :value_(value), node_(node) {}
+
+	double value() const
+	{
+		return value_;
+	}
+
+	AdjointTape::Node node() const
+	{
+		return node_;
+	}
+
+private:
+	double value_;
+	AdjointTape::Node node_;
+};
+
+// The result of a one-argument operation on a:  value f, derivative df
+inline ADouble unaryResult(const ADouble& a, double f, double df)
+{
+	if (a.node() == AdjointTape::noNode)
+	{
+		return ADouble(f);
+	}
+	return ADouble(f, AdjointTape::current().record(a.node(), df));
+}
+
+// The result of a two-argument operation:  value f, partial derivatives da and db
+inline ADouble binaryResult(const ADouble& a, const ADouble& b, double f, double da, double db)
+{
+	if (b.node() == AdjointTape::noNode)
+	{
+		return unaryResult(a, f, da);
+	}
+	if (a.node() == AdjointTape::noNode)
+	{
+		return unaryResult(b, f, db);
+	}
+	return ADouble(f, AdjointTape::current().record(a.node(), da, b.node(), db));
+}
+
+inline ADouble operator+(const ADouble& a, const ADouble& b)
+{
+	return binaryResult(a, b, a.value() + b.value(), 1.0, 1.0);
+}
+
+inline ADouble operator-(const ADouble& a, const ADouble& b)
+{
+	return binaryResult(a, b, a.value() - b.value(), 1.0, -1.0);
+}
+
+inline ADouble operator*(const ADouble& a, const ADouble& b)
+{
+	return binaryResult(a, b, a.value() * b.value(), b.value(), a.value());
+}
+
+inline ADouble operator/(const ADouble& a, const ADouble& b)
+{
+	const double inverse = 1.0 / b.value();
+	const double f = a.value() * inverse;
+	return binaryResult(a, b, f, inverse, -f * inverse);
+}
+
+inline ADouble operator-(const ADouble& a)
+{
+	return unaryResult(a, -a.value(), -1.0);
+}
+
+ADouble exp(const ADouble& a);
+ADouble log(const ADouble& a);
+ADouble sqrt(const ADouble& a);
+
+#endif
@@ -0,0 +1,223 @@
+#include "AnalyticBarrier.h"
+#include "BarrierPayoff.h"
+#include <cmath>
+
+namespace
+{
+	// Forward-mode dual number:  a value and its derivatives with respect to spot, volatility,
+	// the risk-free rate, the strike and the barrier level, in that order.
+	enum { D_SPOT, D_VOL, D_RATE, D_STRIKE, D_BARRIER, NUM_DERIVATIVES };
+
+	struct Dual
+	{
+		double v;
+		double d[NUM_DERIVATIVES];
+	};
+
+	Dual constant(double v)
+	{
+		return Dual{ v, {} };
+	}
+
+	Dual variable(double v, int which)
+	{
+		Dual x = constant(v);
+		x.d[which] = 1.0;
+		return x;
+	}
+
+	// f(x), given f(x.v) and f'(x.v)
+	Dual chain(const Dual& x, double f, double df)
+	{
+		Dual y{ f, {} };
+		for (int i = 0; i < NUM_DERIVATIVES; ++i)
+		{
+			y.d[i] = df * x.d[i];
+		}
+		return y;
+	}
+
+	Dual operator+(const Dual& a, const Dual& b)
+	{
+		Dual y{ a.v + b.v, {} };
+		for (int i = 0; i < NUM_DERIVATIVES; ++i)
+		{
+			y.d[i] = a.d[i] + b.d[i];
+		}
+		return y;
+	}
+
+	Dual operator-(const Dual& a, const Dual& b)
+	{
+		Dual y{ a.v - b.v, {} };
+		for (int i = 0; i < NUM_DERIVATIVES; ++i)
+		{
+			y.d[i] = a.d[i] - b.d[i];
+		}
+		return y;
+	}
+
+	Dual operator*(const Dual& a, const Dual& b)
+	{
+		Dual y{ a.v * b.v, {} };
+		for (int i = 0; i < NUM_DERIVATIVES; ++i)
+		{
+			y.d[i] = a.d[i] * b.v + a.v * b.d[i];
+		}
+		return y;
+	}
+
+	Dual operator/(const Dual& a, const Dual& b)
+	{
+		Dual y{ a.v / b.v, {} };
+		for (int i = 0; i < NUM_DERIVATIVES; ++i)
+		{
+			y.d[i] = (a.d[i] - y.v * b.d[i]) / b.v;
+		}
+		return y;
+	}
+
+	Dual operator+(const Dual& a, double b) { return a + constant(b); }
+	Dual operator*(double a, const Dual& b) { return constant(a) * b; }
+	Dual operator-(const Dual& a) { return constant(0.0) - a; }
+
+	Dual exp(const Dual& x)
+	{
+		double e = std::exp(x.v);
+		return chain(x, e, e);
+	}
+
+	Dual log(const Dual& x)
+	{
+		return chain(x, std::log(x.v), 1.0 / x.v);
+	}
+
+	Dual sqrt(const Dual& x)
+	{
+		double s = std::sqrt(x.v);
+		return chain(x, s, 0.5 / s);
+	}
+
+	Dual pow(const Dual& base, const Dual& exponent)
+	{
+		return exp(exponent * log(base));
+	}
+
+	// Standard normal distribution function
+	Dual N(const Dual& x)
+	{
+		const double invSqrt2 = 0.70710678118654752440;
+		const double invSqrt2Pi = 0.39894228040143267794;
+		return chain(x, 0.5 * std::erfc(-x.v * invSqrt2), invSqrt2Pi * std::exp(-0.5 * x.v * x.v));
+	}
+
+	// The Reiner-Rubinstein formula, with cost of carry b = r (no dividends)
+	Dual barrierPrice(Barrier barrierType, OptionType optionType, const Dual& barrierLevel, const Dual& X, double K,
+		const Dual& S, const Dual& sigma, const Dual& r, double T, double settlement, double monitoringInterval)
+	{
+		const double phi = (optionType == OptionType::CALL) ? 1.0 : -1.0;
+		const double eta = isUpBarrier(barrierType) ? -1.0 : 1.0;
+		const bool knockIn = isKnockIn(barrierType);
+		const Dual settlementLag = exp(-r * constant(settlement - T));
+
+		// Continuous-equivalent barrier:  moved away from the spot for discrete monitoring
+		const Dual H = barrierLevel * exp(-eta * broadieGlassermanBeta * std::sqrt(monitoringInterval) * sigma);
+
+		const Dual sigmaSqrtT = sigma * constant(std::sqrt(T));
+		const Dual dfT = exp(-r * constant(T));
+		const Dual mu = (r - 0.5 * (sigma * sigma)) / (sigma * sigma);
+		const Dual carry = (mu + 1.0) * sigmaSqrtT;
+		const Dual x1 = log(S / X) / sigmaSqrtT + carry;
+
+		// Plain European value:  A in Haug's notation, and the value of a knock-in that has already
+		// been knocked in
+		const Dual A = phi * S * N(phi * x1) - phi * X * dfT * N(phi * x1 - phi * sigmaSqrtT);
+
+		// Already at or through the barrier:  knocked in or out today
+		if (isUpBarrier(barrierType) ? (S.v >= H.v) : (S.v <= H.v))
+		{
+			return knockIn ? A * settlementLag : constant(K) * settlementLag;
+		}
+
+		const Dual lambda = sqrt(mu * mu + 2.0 * r / (sigma * sigma));
+		const Dual hs = H / S;
+		const Dual hs2mu = pow(hs, 2.0 * mu);
+		const Dual hs2mu2 = hs2mu * hs * hs;
+
+		const Dual x2 = log(S / H) / sigmaSqrtT + carry;
+		const Dual y1 = log(H * H / X / S) / sigmaSqrtT + carry;
+		const Dual y2 = log(hs) / sigmaSqrtT + carry;
+		const Dual z = log(hs) / sigmaSqrtT + lambda * sigmaSqrtT;
+
+		const Dual B = phi * S * N(phi * x2) - phi * X * dfT * N(phi * x2 - phi * sigmaSqrtT);
+		const Dual C = phi * S * hs2mu2 * N(eta * y1) - phi * X * dfT * hs2mu * N(eta * y1 - eta * sigmaSqrtT);
+		const Dual D = phi * S * hs2mu2 * N(eta * y2) - phi * X * dfT * hs2mu * N(eta * y2 - eta * sigmaSqrtT);
+		const Dual E = K * dfT * (N(eta * x2 - eta * sigmaSqrtT) - hs2mu * N(eta * y2 - eta * sigmaSqrtT));
+		const Dual F = K * (pow(hs, mu + lambda) * N(eta * z) + pow(hs, mu - lambda) * N(eta * z - 2.0 * eta * lambda * sigmaSqrtT));
+
+		const bool strikeAbove = (X.v >= H.v);
+		const bool call = (optionType == OptionType::CALL);
+		Dual value;
+		switch (barrierType)
+		{
+		case Barrier::DOWN_AND_IN:
+			value = call ? (strikeAbove ? C + E : A - B + D + E) : (strikeAbove ? B - C + D + E : A + E);
+			break;
+		case Barrier::UP_AND_IN:
+			value = call ? (strikeAbove ? A + E : B - C + D + E) : (strikeAbove ? A - B + D + E : C + E);
+			break;
+		case Barrier::DOWN_AND_OUT:
+			value = call ? (strikeAbove ? A - C + F : B - D + F) : (strikeAbove ? A - B + C - D + F : F);
+			break;
+		case Barrier::UP_AND_OUT:
+			value = call ? (strikeAbove ? F : A - B + C - D + F) : (strikeAbove ? B - D + F : A - C + F);
+			break;
+		}
+
+		return value * settlementLag;
+	}
+}
+
+AnalyticBarrier::AnalyticBarrier(Barrier barrierType, OptionType optionType, double barrierLevel, double strike,
+	double rebate, double monitoringInterval) :barrierType_(barrierType), optionType_(optionType),
+	barrierLevel_(barrierLevel), strike_(strike), rebate_(rebate), monitoringInterval_(monitoringInterval) {}
+
+double AnalyticBarrier::price(double spot, double riskFreeRate, double volatility, double timeToExpiry,
+	double timeToSettlement) const
+{
+	return barrierPrice(barrierType_, optionType_, constant(barrierLevel_), constant(strike_), rebate_, constant(spot),
+		constant(volatility), constant(riskFreeRate), timeToExpiry, timeToSettlement, monitoringInterval_).v;
+}
+
+OptionResults AnalyticBarrier::values(double spot, double riskFreeRate, double volatility, double timeToExpiry,
+	double timeToSettlement, double quantity) const
+{
+	Dual value = barrierPrice(barrierType_, optionType_, variable(barrierLevel_, D_BARRIER), variable(strike_, D_STRIKE),
+		rebate_, variable(spot, D_SPOT), variable(volatility, D_VOL), variable(riskFreeRate, D_RATE), timeToExpiry,
+		timeToSettlement, monitoringInterval_);
+
+	// The first derivatives at spot and volatility shifted by a relative h either way
+	const double h = 1e-4;
+	auto firstOrder = [&](double s, double vol)
+	{
+		return barrierPrice(barrierType_, optionType_, constant(barrierLevel_), constant(strike_), rebate_,
+			variable(s, D_SPOT), variable(vol, D_VOL), constant(riskFreeRate), timeToExpiry, timeToSettlement,
+			monitoringInterval_);
+	};
+	const Dual spotUp = firstOrder(spot * (1.0 + h), volatility);
+	const Dual spotDown = firstOrder(spot * (1.0 - h), volatility);
+	const Dual volUp = firstOrder(spot, volatility * (1.0 + h));
+	const Dual volDown = firstOrder(spot, volatility * (1.0 - h));
+
+	OptionResults results;
+	results.resultSet.insert({ OptionResults::PRICE, quantity * value.v });
+	results.resultSet.insert({ OptionResults::DELTA, quantity * value.d[D_SPOT] });
+	results.resultSet.insert({ OptionResults::VEGA, quantity * value.d[D_VOL] });
+	results.resultSet.insert({ OptionResults::RHO, quantity * value.d[D_RATE] });
+	results.resultSet.insert({ OptionResults::STRIKE_SENSITIVITY, quantity * value.d[D_STRIKE] });
+	results.resultSet.insert({ OptionResults::BARRIER_SENSITIVITY, quantity * value.d[D_BARRIER] });
+	results.resultSet.insert({ OptionResults::GAMMA, quantity * (spotUp.d[D_SPOT] - spotDown.d[D_SPOT]) / (2.0 * h * spot) });
+	results.resultSet.insert({ OptionResults::VANNA, quantity * (spotUp.d[D_VOL] - spotDown.d[D_VOL]) / (2.0 * h * spot) });
+	results.resultSet.insert({ OptionResults::VOLGA, quantity * (volUp.d[D_VOL] - volDown.d[D_VOL]) / (2.0 * h * volatility) });
+	return results;
+}
@@ -0,0 +1,46 @@
+#ifndef ANALYTIC_BARRIER_H
+#define ANALYTIC_BARRIER_H
+
+#include "ResultSet.h"
+
+// Closed-form value of a continuously monitored single-barrier option under constant-volatility
+// geometric Brownian motion with no dividends -- the model EquityPriceGenerator simulates --
+// after Reiner and Rubinstein (1991), in the form given by Haug, "The Complete Guide to Option
+// Pricing Formulas", 4.17.1.  Covers up/down and in/out calls and puts, with a cash rebate:
+// paid at expiry for a knock-in that was never knocked in, and when the barrier is hit for a
+// knock-out.
+//
+// Greeks are exact derivatives of the formula (carried through it by forward-mode automatic
+// differentiation), not finite differences.
+//
+// A barrier monitored only at equally spaced dates is priced as a continuous one moved by the
+// Broadie-Glasserman-Kou shift (see shiftedBarrier(.)), with the shift included in the greeks.
+//
+// Every cash flow is assumed to settle (settlement - timeToExpiry) after the event, as in
+// BarrierOption, and is discounted at the risk-free rate over that lag.
+class AnalyticBarrier
+{
+public:
+	// monitoringInterval:  year fraction between monitoring dates, or 0 for continuous monitoring
+	AnalyticBarrier(Barrier barrierType, OptionType optionType, double barrierLevel, double strike,
+		double rebate = 0.0, double monitoringInterval = 0.0);
+
+	// Value of one unit.  timeToExpiry and timeToSettlement are year fractions from the value date.
+	double price(double spot, double riskFreeRate, double volatility, double timeToExpiry,
+		double timeToSettlement) const;
+
+	// Price, delta, vega and rho of quantity units, the derivatives in the strike and barrier level,
+	// and gamma, vanna and volga (central differences of the exact delta and vega)
+	OptionResults values(double spot, double riskFreeRate, double volatility, double timeToExpiry,
+		double timeToSettlement, double quantity = 1.0) const;
+
+private:
+	Barrier barrierType_;
+	OptionType optionType_;
+	double barrierLevel_;
+	double strike_;
+	double rebate_;
+	double monitoringInterval_;
+};
+
+#endif
@@ -1,280 +1,1282 @@
-#include "BarrierOption.h"
-#include "EquityPriceGenerator.h"
-#include "ResultSet.h"
-#include <vector>
-#include <algorithm>
-#include <numeric>
-#include <cmath>
-#include <future>
-#include <ctime>
-#include <limits>
-#include <cassert>
-
-using std::vector;
-using std::map;
-using std::max;			// <algorithm>
-using std::transform;
-using std::for_each;
-using std::exp;
-using std::accumulate;
-using std::async;
-using std::future;
-using std::clock_t;
-using std::all_of;
-using std::find_if;
-using std::back_inserter;
-
-BarrierOption::BarrierOption(double barrierLevel, double strike, double spot, double riskFreeRate, double volatility,
-	double quantity, Barrier BarrierType, const Date& valueDate, const Date& expiryDate,
-	const Date& settlementDate, unsigned numTimeSteps, unsigned numScenarios, bool runParallel,
-	int seed, double greekShift, const Act365& dc) :barrierLevel_(barrierLevel),strike_(strike), spot_(spot),
-	riskFreeRate_(riskFreeRate), volatility_(volatility), quantity_(quantity),
-	BarrierType_(BarrierType), numTimeSteps_(numTimeSteps), numScenarios_(numScenarios), runParallel_(runParallel), seed_(seed),
-	greekShift_(greekShift), tau_(dc.yearFraction(valueDate, expiryDate)), settlement_(dc.yearFraction(valueDate, settlementDate))
-{
-	calculate_();
-}
-
-OptionResults BarrierOption::operator()() const
-{
-	return results_;
-}
-
-double BarrierOption::time() const
-{
-	return time_;
-}
-
-void BarrierOption::calculate_()
-{
-	clock_t begin = clock();		// begin time with threads
-
-	computePrice_();
-	computeDelta_();
-	computeVega_();
-	computeRho_();
-
-	clock_t end = clock();		// end time with threads
-	time_ = double(end - begin) / CLOCKS_PER_SEC;
-
-	results_.resultSet.insert({ results_.PRICE, price_ });
-	results_.resultSet.insert({ results_.DELTA, delta_ });
-	results_.resultSet.insert({ results_.VEGA, vega_ });
-	results_.resultSet.insert({ results_.RHO, rho_ });
-}
-
-// Private helper functions:
-void BarrierOption::computePrice_()
-{
-	if (runParallel_)
-	{
-		computePriceAsync_();			
-	}
-	else
-	{
-		computePriceNoParallel_();
-	}
-}
-
-void BarrierOption::computePriceNoParallel_()
-{
-	// ctor: EquityPriceGenerator(double initEquityPrice, unsigned numTimeSteps, 
-	//                            double timeToMaturity, double drift, double volatility);
-	EquityPriceGenerator epg(spot_, numTimeSteps_, tau_, riskFreeRate_, volatility_);
-	vector<int> seeds;
-	seeds.push_back(seed_);		// seed_ is actually our starting seed value
-
-	for (unsigned i = 1; i < numScenarios_; ++i)
-	{
-		// This is a contrived way of setting a different seed for 
-		// each scenario.  There are more robust ways to do this.
-		seeds.push_back(seed_ + i);
-	}
-
-	vector<double> discountedPayoffs;
-
-	for (auto& seed : seeds)
-	{
-		double terminalPrice = (epg(seed)).back();
-		vector<double> priceVector = epg(seed);
-		double payoff = 0.0;
-		double existenceTime = 0.0;
-
-		switch (BarrierType_)
-		{
-		case Barrier::DOWN_AND_OUT:
-			// payoff = max(terminalPrice - strike_, 0.0);
-			if (all_of(priceVector.begin(), priceVector.end(), 
-				[this](double stp) {return stp> barrierLevel_;}))
-			{
-				payoff = 0.0;
-			}
-			else
-			{
-				auto knock = find_if(priceVector.begin(), priceVector.end(), 
-					[this](double stp) {return stp < barrierLevel_;});
-				payoff = strike_ - *knock;
-				int pos = std::distance(priceVector.begin(), knock);
-				existenceTime = settlement_*( (pos+1) /priceVector.size() );
-			}
-			break;
-		case Barrier::UP_AND_OUT:
-			// payoff = max(strike_ - terminalPrice, 0.0);
-			if (all_of(priceVector.begin(), priceVector.end(), 
-				[this](double stp) {return stp < barrierLevel_; }))
-			{
-				payoff = 0.0;
-			}
-			else
-			{
-				auto knock = find_if(priceVector.begin(), priceVector.end(), 
-					[this](double stp) {return stp > barrierLevel_; });
-				payoff = *knock - strike_;
-				int pos = std::distance(priceVector.begin(), knock);
-				existenceTime = settlement_ * ((pos + 1) / priceVector.size());
-			}
-			break;
-		default:	// Put an assert here, as this should NEVER happen
-			assert(false);
-			break;
-		}
-
-		discountedPayoffs.push_back(discFactor_(0.0, existenceTime) * payoff);
-	}
-
-	price_ = quantity_ * (1.0 / discountedPayoffs.size()) * accumulate(discountedPayoffs.begin(), discountedPayoffs.end(), 0.0);
-
-}
-
-void BarrierOption::computePriceAsync_()
-{
-	EquityPriceGenerator epg(spot_, numTimeSteps_, tau_, riskFreeRate_, volatility_);
-
-	vector<int> seeds;
-	seeds.push_back(seed_);		// seed_ is actually our starting seed value
-
-	for (unsigned i = 1; i < numScenarios_; ++i)	// We might, instead, wish to use
-	{												// an arbitrary vector of seeds.
-		seeds.push_back(seed_ + i);
-	}
-
-	// typedef vector<double> realVector;	// Old way
-	using realVector = vector<double>;		// Modern C++ way
-	vector<future<realVector> > futures;
-
-	for (auto& seed : seeds)
-	{
-		futures.push_back(async(epg, seed));
-	}
-
-	vector<double> discountedPayoffs;
-
-	for (auto& future : futures)
-	{
-		// double terminalPrice = future.get().back();
-		vector<double> priceVector;
-		priceVector = future.get();
-		double payoff = 0.0;
-		double existenceTime = 0.0;
-		
-		switch (BarrierType_)
-		{
-		case Barrier::DOWN_AND_OUT:
-			// payoff = max(terminalPrice - strike_, 0.0);
-			if (all_of(priceVector.begin(), priceVector.end(),
-				[this](double stp) {return stp > barrierLevel_; }))
-			{
-				payoff = 0.0;
-			}
-			else
-			{
-				auto knock = find_if(priceVector.begin(), priceVector.end(), 
-					[this](double stp) {return stp < barrierLevel_; });
-				payoff = strike_ - *knock;
-				int pos = std::distance(priceVector.begin(), knock);
-				existenceTime = settlement_ * ((pos + 1) / priceVector.size());
-			}
-			break;
-		case Barrier::UP_AND_OUT:
-			// payoff = max(strike_ - terminalPrice, 0.0);
-			if (all_of(priceVector.begin(), priceVector.end(), 
-				[this](double stp) {return stp < barrierLevel_; }))
-			{
-				payoff = 0.0;
-			}
-			else
-			{
-				auto knock = find_if(priceVector.begin(), priceVector.end(), 
-					[this](double stp) {return stp > barrierLevel_; });
-				payoff = *knock - strike_;
-				int pos = std::distance(priceVector.begin(), knock);
-				existenceTime = settlement_ * ((pos + 1) / priceVector.size());
-			}
-			break;
-		default:	// Should put assert here; this case should NEVER happen
-			payoff = std::numeric_limits<double>::quiet_NaN();	// Returns NaN (Not a Number)
-			break;
-		}
-
-		discountedPayoffs.push_back(discFactor_(0.0, existenceTime) * payoff);
-	}
-
-	price_ = quantity_ * (1.0 / discountedPayoffs.size()) * accumulate(discountedPayoffs.begin(), discountedPayoffs.end(), 0.0);
-}
-
-void BarrierOption::computeDelta_()
-{
-	double origSpot = spot_;
-	double origPrice = price_;
-	spot_ *= greekShift_;
-	computePrice_();
-
-	delta_ = (price_ - origPrice) / greekShift_;
-
-	// reset state to original:
-	spot_ = origSpot;
-	price_ = origPrice;
-}
-
-void BarrierOption::computeVega_()
-{
-	double origVol = volatility_;
-	double origPrice = price_;
-	volatility_ *= greekShift_;
-	computePrice_();
-
-	vega_ = (price_ - origPrice) / greekShift_;
-
-	// reset state to original:
-	volatility_ = origVol;
-	price_ = origPrice;
-}
-
-void BarrierOption::computeRho_()
-{
-	double origRfRate_ = riskFreeRate_;
-	double origPrice = price_;
-	riskFreeRate_ *= greekShift_;	// If we were using a term structure, we would need to 
-									// shock the entire curve
-	computePrice_();
-
-	rho_ = (price_ - origPrice) / greekShift_;
-
-	// reset state to original:
-	riskFreeRate_ = origRfRate_;
-	price_ = origPrice;
-}
-
-double BarrierOption::discFactor_(double yearFraction1, double yearFraction2)
-{
-	if (yearFraction1 <= yearFraction2)
-	{
-		return exp(-(yearFraction2 - yearFraction1)*riskFreeRate_);
-	}
-	else
-	{
-		// handle error:  For now, just return NaN (Not a Number).
-		// Should put in an exception for production.
-		return std::numeric_limits<double>::quiet_NaN();
-	}
-}
+#include "BarrierOption.h"
+#include "EquityPriceGenerator.h"
+#include "ResultSet.h"
+#include "PricingThreadPool.h"
+#include "BarrierPayoff.h"
+#include "BatchPathGenerator.h"
+#include "AnalyticBarrier.h"
+#include "OneStepSurvival.h"
+#include "BarrierOptionPaths.h"
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <limits>
+#include <chrono>
+#include <type_traits>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <cassert>
+
+using std::vector;
+using std::max;			// <algorithm>
+using std::exp;
+using std::accumulate;
+using std::size_t;
+
+BarrierOption::BarrierOption(double barrierLevel, double strike, double spot, double riskFreeRate, double volatility,
+	double quantity, Barrier BarrierType, const Date& valueDate, const Date& expiryDate,
+	const Date& settlementDate, unsigned numTimeSteps, unsigned numScenarios, bool runParallel,
+	int seed, double greekShift, const Act365& dc, PricingThreadPool* executor,
+	const EngineSettings& settings) :BarrierOption(barrierLevel, strike, spot, riskFreeRate, volatility, quantity,
+	BarrierType, isUpBarrier(BarrierType) ? OptionType::PUT : OptionType::CALL, valueDate, expiryDate, settlementDate,
+	numTimeSteps, numScenarios, runParallel, seed, greekShift, dc, executor, settings) {}
+
+BarrierOption::BarrierOption(double barrierLevel, double strike, double spot, double riskFreeRate, double volatility,
+	double quantity, Barrier BarrierType, OptionType optionType, const Date& valueDate, const Date& expiryDate,
+	const Date& settlementDate, unsigned numTimeSteps, unsigned numScenarios, bool runParallel,
+	int seed, double greekShift, const Act365& dc, PricingThreadPool* executor,
+	const EngineSettings& settings) :BarrierOption(barrierLevel, strike, spot, riskFreeRate, volatility, quantity,
+	BarrierType, optionType, 0.0, valueDate, expiryDate, settlementDate, numTimeSteps, numScenarios, runParallel,
+	seed, greekShift, dc, executor, settings) {}
+
+BarrierOption::BarrierOption(double barrierLevel, double strike, double spot, double riskFreeRate, double volatility,
+	double quantity, Barrier BarrierType, OptionType optionType, double rebate, const Date& valueDate,
+	const Date& expiryDate, const Date& settlementDate, unsigned numTimeSteps, unsigned numScenarios,
+	bool runParallel, int seed, double greekShift, const Act365& dc, PricingThreadPool* executor,
+	const EngineSettings& settings) :runParallel_(runParallel), executor_(executor), settings_(settings),
+	BarrierType_(BarrierType), optionType_(optionType), barrierLevel_(barrierLevel),
+	upperBarrierLevel_(std::numeric_limits<double>::infinity()), firstMonitored_(0), lastMonitored_(numTimeSteps),
+	rebate_(rebate), spot_(spot), strike_(strike), riskFreeRate_(riskFreeRate), volatility_(volatility), quantity_(quantity),
+	numTimeSteps_(numTimeSteps), greekShift_(greekShift), tau_(dc.yearFraction(valueDate, expiryDate)),
+	settlement_(dc.yearFraction(valueDate, settlementDate)), numScenarios_(numScenarios), seed_(seed)
+{
+	// A pair needs both its paths
+	if (settings_.antithetic && numScenarios_ % 2 == 1)
+	{
+		++numScenarios_;
+	}
+	maxScenarios_ = numScenarios_;
+	baseRiskFreeRate_ = riskFreeRate_;
+	baseVolatility_ = volatility_;
+	invalidate_();
+}
+
+BarrierOption::BarrierOption(double lowerBarrier, double upperBarrier, double strike, double spot, double riskFreeRate,
+	double volatility, double quantity, bool knockIn, OptionType optionType, double rebate, const Date& windowStart,
+	const Date& windowEnd, const Date& valueDate, const Date& expiryDate, const Date& settlementDate,
+	unsigned numTimeSteps, unsigned numScenarios, bool runParallel, int seed, double greekShift, const Act365& dc,
+	PricingThreadPool* executor, const EngineSettings& settings) :BarrierOption((lowerBarrier > 0.0) ? lowerBarrier
+	: upperBarrier, strike, spot, riskFreeRate, volatility, quantity, (lowerBarrier > 0.0)
+	? (knockIn ? Barrier::DOWN_AND_IN : Barrier::DOWN_AND_OUT) : (knockIn ? Barrier::UP_AND_IN : Barrier::UP_AND_OUT),
+	optionType, rebate, valueDate, expiryDate, settlementDate, numTimeSteps, numScenarios, runParallel, seed,
+	greekShift, dc, executor, settings)
+{
+	if (!(lowerBarrier < upperBarrier) || (lowerBarrier <= 0.0 && upperBarrier == std::numeric_limits<double>::infinity()))
+	{
+		throw std::invalid_argument("BarrierOption:  needs a lower barrier below the upper one, and at least one of them");
+	}
+	if (lowerBarrier > 0.0)
+	{
+		upperBarrierLevel_ = upperBarrier;
+	}
+
+	// The time steps within the window (none if it misses the path)
+	const double dt = tau_ / numTimeSteps_;
+	const double first = std::ceil(dc.yearFraction(valueDate, windowStart) / dt - 1.0e-9);
+	const double last = std::floor(dc.yearFraction(valueDate, windowEnd) / dt + 1.0e-9);
+	if (last < std::max(first, 0.0) || first > numTimeSteps_)
+	{
+		firstMonitored_ = 1;
+		lastMonitored_ = 0;
+	}
+	else
+	{
+		firstMonitored_ = static_cast<unsigned>(std::max(first, 0.0));
+		lastMonitored_ = static_cast<unsigned>(std::min(last, double(numTimeSteps_)));
+	}
+}
+
+OptionResults BarrierOption::operator()() const
+{
+	return (*this)(OptionResults::FIRST_ORDER);
+}
+
+OptionResults BarrierOption::operator()(unsigned request) const
+{
+	calculate_(request);
+	return results_;
+}
+
+double BarrierOption::time() const
+{
+	return time_;
+}
+
+double BarrierOption::stdError() const
+{
+	return stdError_;
+}
+
+double BarrierOption::stdError(OptionResults::Value value) const
+{
+	return (value == OptionResults::PRICE) ? stdError_ : stdErrors_[value];
+}
+
+double BarrierOption::precisionDifference() const
+{
+	return precisionDifference_;
+}
+
+size_t BarrierOption::cachedScenarios() const
+{
+	return pathCache_.size() / numTimeSteps_ * (settings_.antithetic ? 2 : 1);
+}
+
+void BarrierOption::setSpot(double spot)
+{
+	spot_ = spot;
+	invalidate_();
+}
+
+void BarrierOption::setVolatility(double volatility)
+{
+	volatility_ = volatility;
+	invalidate_();
+}
+
+void BarrierOption::setRiskFreeRate(double riskFreeRate)
+{
+	riskFreeRate_ = riskFreeRate;
+	invalidate_();
+}
+
+void BarrierOption::invalidate_()
+{
+	results_ = OptionResults();
+	price_ = delta_ = vega_ = rho_ = strikeSensitivity_ = barrierSensitivity_ = 0.0;
+	gamma_ = vanna_ = volga_ = stdError_ = 0.0;
+	std::fill(stdErrors_, stdErrors_ + OptionResults::NUM_VALUES, std::numeric_limits<double>::quiet_NaN());
+	precisionDifference_ = 0.0;
+	precisionScenarios_ = 0;
+	time_ = 0.0;
+	runStatistics_ = RunStatistics();
+	runStatistics_.collected = settings_.collectStatistics;
+	taskThreads_.clear();
+
+	// Target-precision mode sets the number of scenarios afresh for the new inputs
+	numScenarios_ = maxScenarios_;
+	adaptive_ = (settings_.targetStdError > 0.0 || settings_.timeBudget > 0.0)
+		&& settings_.pricingMethod == PricingMethod::MONTE_CARLO && !settings_.multilevel;
+	levelSamples_.clear();
+}
+
+void BarrierOption::calculate_(unsigned request) const
+{
+	const unsigned missing = request & (OptionResults::FIRST_ORDER | OptionResults::CONTRACT_SENSITIVITIES
+		| OptionResults::SECOND_ORDER) & ~results_.resultSet.values().present;
+	if (missing == 0)
+	{
+		return;
+	}
+
+	// Wall clock:  clock() is the CPU time of the whole process, which grows with the number of
+	// threads and so hides the speedup of the parallel run
+	const auto begin = std::chrono::steady_clock::now();
+
+	if (settings_.randomStream == RandomStream::SOBOL && settings_.pricingMethod == PricingMethod::MONTE_CARLO
+		&& !quasiRandom_)
+	{
+		// One Sobol dimension per time step; the same points serve the base and bumped valuations
+		PhaseTimer timer(statistics_(), RunStatistics::SETUP);
+		quasiRandom_ = std::make_shared<QuasiRandomNormals>(numTimeSteps_, settings_.qmcReplications, seed_);
+	}
+	if (!settings_.normalStore.empty() && settings_.pricingMethod == PricingMethod::MONTE_CARLO && !normalStore_)
+	{
+		// Checked before it is kept, so that a store that does not fit fails every valuation
+		PhaseTimer timer(statistics_(), RunStatistics::SETUP);
+		std::shared_ptr<const NormalStore> store = NormalStore::open(settings_.normalStore);
+		store->check(settings_.randomStream, seed_, numTimeSteps_, maxScenarios_ / (settings_.antithetic ? 2 : 1),
+			settings_.qmcReplications);
+		normalStore_ = store;
+	}
+	checkSettings_(missing);
+
+	// The values computed here (the closed form gives them all at once)
+	unsigned computed = missing;
+	if (settings_.pricingMethod == PricingMethod::ANALYTIC)
+	{
+		computeAnalytic_();
+		computed = OptionResults::FIRST_ORDER | OptionResults::CONTRACT_SENSITIVITIES | OptionResults::SECOND_ORDER;
+	}
+	else if (settings_.greeksMethod == GreeksMethod::ADJOINT)
+	{
+		// Every path gives the price and all the first-order values at once
+		computeAdjoint_(missing | OptionResults::FIRST_ORDER | OptionResults::CONTRACT_SENSITIVITIES);
+		computed |= OptionResults::FIRST_ORDER | OptionResults::CONTRACT_SENSITIVITIES;
+	}
+	else if (settings_.greeksMethod == GreeksMethod::SINGLE_PASS && !settings_.multilevel
+		&& (missing & ~OptionResults::PRICE_ONLY) != 0)
+	{
+		// The base state is always simulated, so the price comes with any greek.  The price alone
+		// goes through computePrice_, which runs the selected path engine.
+		computeSinglePass_(missing);
+		computed |= OptionResults::PRICE_ONLY;
+	}
+	else
+	{
+		// The bumped revaluations are measured from the price, so that is needed first
+		if (results_.resultSet.count(OptionResults::PRICE) == 0)
+		{
+			computePrice_();
+			computed |= OptionResults::PRICE_ONLY;
+		}
+		double stdError = stdError_;	// The bumped revaluations below overwrite it
+		if (missing & (1u << OptionResults::DELTA))
+		{
+			computeDelta_();
+		}
+		if (missing & (1u << OptionResults::VEGA))
+		{
+			computeVega_();
+		}
+		if (missing & (1u << OptionResults::RHO))
+		{
+			computeRho_();
+		}
+		stdError_ = stdError;
+	}
+
+	if (settings_.pricingMethod == PricingMethod::MONTE_CARLO)
+	{
+		// Values the method above has no estimator for, from one more pass over the same scenarios
+		// (which prices them again:  the price and its standard error are kept from above)
+		const double price = price_;
+		const double stdError = stdError_;
+		if ((missing & OptionResults::SECOND_ORDER) && settings_.greeksMethod != GreeksMethod::SINGLE_PASS)
+		{
+			computeSinglePass_(missing & OptionResults::SECOND_ORDER);
+		}
+		if ((missing & OptionResults::CONTRACT_SENSITIVITIES) && settings_.greeksMethod != GreeksMethod::ADJOINT)
+		{
+			computeAdjoint_(missing & OptionResults::CONTRACT_SENSITIVITIES);
+		}
+		price_ = price;
+		stdError_ = stdError;
+
+		if (settings_.precision == Precision::SINGLE && settings_.precisionCheckScenarios > 0 && precisionScenarios_ == 0)
+		{
+			checkPrecision_();
+		}
+	}
+
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+	time_ += elapsed.count();
+
+	const double values[OptionResults::NUM_VALUES] = { price_, delta_, vega_, rho_, strikeSensitivity_,
+		barrierSensitivity_, gamma_, vanna_, volga_ };
+	for (int v = OptionResults::PRICE; v <= OptionResults::VOLGA; ++v)
+	{
+		if (computed & (1u << v))
+		{
+			results_.resultSet[static_cast<OptionResults::Value>(v)] = values[v];
+		}
+	}
+	results_.resultSet[OptionResults::STD_ERROR] = stdError_;
+	// A multilevel run's scenarios are those of all its levels
+	results_.resultSet[OptionResults::NUM_SCENARIOS] = (settings_.pricingMethod == PricingMethod::ANALYTIC) ? 0.0
+		: levelSamples_.empty() ? double(numScenarios_) : double(accumulate(levelSamples_.begin(), levelSamples_.end(), size_t(0)));
+	results_.resultSet[OptionResults::TIME] = time_;
+
+	runStatistics_.stdError = stdError_;
+	results_.statistics = runStatistics_;
+}
+
+// Private helper functions:
+void BarrierOption::computePrice_() const
+{
+	if (settings_.multilevel)
+	{
+		computeMultilevel_();
+	}
+	else
+	{
+		computeScenarioPrice_(runParallel_);
+	}
+}
+
+void BarrierOption::computeScenarioPrice_(bool parallel) const
+{
+	// ctor: EquityPriceGenerator(double initEquityPrice, unsigned numTimeSteps, 
+	//                            double timeToMaturity, double drift, double volatility);
+	EquityPriceGenerator epg = generator_(spot_, riskFreeRate_, volatility_, numTimeSteps_);
+
+	// Previously the parallel run launched one std::async task (and future) per scenario, which
+	// cost more than the simulation itself.  Now the scenarios are cut into fixed-size chunks and
+	// run on the pricing thread pool.  Each scenario writes to its own slot and the sum is taken
+	// in scenario order, so the price does not depend on the number of threads (or on parallel).
+	const bool useControls = (settings_.controlVariate != ControlVariate::NONE);
+	vector<double> discountedPayoffs;
+	vector<double> controls;
+
+	std::unique_ptr<const BatchPathGenerator> batchPaths;
+	if (batchPaths_() && !useControls)
+	{
+		batchPaths.reset(new BatchPathGenerator(batchGenerator_(settings_.precision)));
+	}
+
+	runScenarios_([&](size_t batchBegin, size_t batchEnd)
+	{
+		discountedPayoffs.resize(batchEnd);
+		controls.resize(useControls ? batchEnd : 0);
+		recordBuffers_(discountedPayoffs, controls);
+		simulateScenarios_(batchBegin, batchEnd, parallel, [&](size_t begin, size_t end, RunStatistics::PathCounts* counts)
+		{
+			priceScenarios_(epg, batchPaths.get(), begin, end, discountedPayoffs.data(), useControls ? controls.data() : nullptr,
+				counts);
+		});
+	}, [&]()
+	{
+		vector<double> payoffs(discountedPayoffs);
+		setPrice_(payoffs, controls);
+		return stdError_;
+	});
+
+	setPrice_(discountedPayoffs, controls);
+}
+
+void BarrierOption::simulateScenarios_(size_t begin, size_t end, bool parallel,
+	const std::function<void(size_t, size_t, RunStatistics::PathCounts*)>& task) const
+{
+	if (settings_.cachePaths)
+	{
+		const size_t pathsPerSample = settings_.antithetic ? 2 : 1;
+		extendPathCache_((end + pathsPerSample - 1) / pathsPerSample);
+	}
+
+	RunStatistics* statistics = statistics_();
+	PhaseTimer timer(statistics, RunStatistics::SIMULATION);
+	PricingThreadPool& pool = (executor_ != nullptr) ? *executor_ : PricingThreadPool::shared();
+	if (statistics == nullptr)
+	{
+		if (parallel)
+		{
+			pool.parallelFor(begin, end, scenarioChunkSize_, [&task](size_t begin, size_t end)
+			{
+				task(begin, end, nullptr);
+			});
+		}
+		else
+		{
+			task(begin, end, nullptr);
+		}
+		return;
+	}
+
+	// Each task counts into its own PathCounts, merged once it is done
+	std::mutex mutex;
+	auto countedTask = [&](size_t begin, size_t end)
+	{
+		const auto taskBegin = std::chrono::steady_clock::now();
+		RunStatistics::PathCounts counts;
+		task(begin, end, &counts);
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - taskBegin;
+
+		std::lock_guard<std::mutex> lock(mutex);
+		statistics->add(counts);
+		statistics->taskTime += elapsed.count();
+		++statistics->tasks;
+		if (std::find(taskThreads_.begin(), taskThreads_.end(), std::this_thread::get_id()) == taskThreads_.end())
+		{
+			taskThreads_.push_back(std::this_thread::get_id());
+		}
+	};
+
+	if (parallel)
+	{
+		pool.parallelFor(begin, end, scenarioChunkSize_, countedTask);
+	}
+	else
+	{
+		countedTask(begin, end);
+	}
+	statistics->threadsUsed = static_cast<unsigned>(taskThreads_.size());
+}
+
+void BarrierOption::extendPathCache_(size_t numSamples) const
+{
+	const size_t numCached = pathCache_.size() / numTimeSteps_;
+	if (numSamples <= numCached)
+	{
+		return;
+	}
+
+	// The draws of sample j are those forEachScenario_ would take from its stream.  A path that is
+	// knocked out uses only the first few, but all numTimeSteps_ are stored for the paths of later
+	// market states.
+	PhaseTimer timer(statistics_(), RunStatistics::SETUP);
+	pathCache_.resize(numSamples * numTimeSteps_);
+	const bool skeleton = skeletonPaths_();
+	auto draw = [this, skeleton](auto& normals, double* draws)
+	{
+		for (unsigned s = 0; s < numTimeSteps_; ++s)
+		{
+			draws[s] = normals();
+		}
+		if (skeleton)
+		{
+			std::partial_sum(draws, draws + numTimeSteps_, draws);
+		}
+	};
+	auto fill = [this, &draw, skeleton](size_t begin, size_t end)
+	{
+		if (normalStore_)
+		{
+			for (size_t j = begin; j < end; ++j)
+			{
+				StoredNormals normals(normalStore_->sample(j));
+				draw(normals, &pathCache_[j * numTimeSteps_]);
+			}
+			return;
+		}
+
+		switch (settings_.randomStream)
+		{
+		case RandomStream::PHILOX:
+			for (size_t j = begin; j < end; ++j)
+			{
+				PhiloxNormals normals(seed_, j);
+				draw(normals, &pathCache_[j * numTimeSteps_]);
+			}
+			break;
+		case RandomStream::MT19937_PER_SCENARIO:
+			for (size_t j = begin; j < end; ++j)
+			{
+				MersenneNormals normals(seed_ + static_cast<int>(j));
+				draw(normals, &pathCache_[j * numTimeSteps_]);
+			}
+			break;
+		case RandomStream::SOBOL:
+		{
+			const unsigned numReplications = quasiRandom_->numReplications();
+			QuasiRandomNormals::Cursor cursor(*quasiRandom_);
+			for (size_t j = begin; j < end; ++j)
+			{
+				double* draws = &pathCache_[j * numTimeSteps_];
+				quasiRandom_->generate(static_cast<unsigned>(j % numReplications), j / numReplications, cursor, draws);
+				if (skeleton)
+				{
+					std::partial_sum(draws, draws + numTimeSteps_, draws);
+				}
+			}
+			break;
+		}
+		default:
+			assert(false);
+			break;
+		}
+	};
+
+	if (runParallel_)
+	{
+		PricingThreadPool& pool = (executor_ != nullptr) ? *executor_ : PricingThreadPool::shared();
+		pool.parallelFor(numCached, numSamples, scenarioChunkSize_, fill);
+	}
+	else
+	{
+		fill(numCached, numSamples);
+	}
+}
+
+bool BarrierOption::skeletonPaths_() const
+{
+	// A skeleton's running sums give the path only in a flat market, and its payoff has no rebate
+	// and a single barrier; the sums are kept in double
+	return settings_.cachePaths && settings_.barrierMonitoring == BarrierMonitoring::DISCRETE
+		&& settings_.controlVariate == ControlVariate::NONE && !settings_.egarch && !settings_.termStructure
+		&& rebate_ == 0.0 && singleBarrier_();
+}
+
+bool BarrierOption::batchPaths_() const
+{
+	// The batch kernel draws its own pseudo-random numbers and only tracks the discrete barrier
+	return settings_.pathEngine == PathEngine::SIMD_BATCH && settings_.randomStream != RandomStream::SOBOL
+		&& !settings_.cachePaths && !normalStore_ && !settings_.antithetic
+		&& settings_.barrierMonitoring == BarrierMonitoring::DISCRETE && rebate_ == 0.0 && singleBarrier_();
+}
+
+void BarrierOption::skeletonDraws_(size_t i, double* draws) const
+{
+	// The increments of the running sums
+	const size_t pathsPerSample = settings_.antithetic ? 2 : 1;
+	const double* skeleton = &pathCache_[(i / pathsPerSample) * numTimeSteps_];
+	const double sign = (i % pathsPerSample == 1) ? -1.0 : 1.0;
+	for (unsigned step = 0; step < numTimeSteps_; ++step)
+	{
+		draws[step] = sign * (skeleton[step] - ((step > 0) ? skeleton[step - 1] : 0.0));
+	}
+}
+
+EquityPriceGenerator BarrierOption::generator_(double spot, double riskFreeRate, double vol, unsigned numTimeSteps) const
+{
+	if (settings_.egarch)
+	{
+		return EquityPriceGenerator(spot, numTimeSteps, tau_, riskFreeRate, vol, settings_.egarch);
+	}
+	if (settings_.termStructure)
+	{
+		return EquityPriceGenerator(spot, numTimeSteps, tau_, termStructure_(riskFreeRate, vol));
+	}
+	return EquityPriceGenerator(spot, numTimeSteps, tau_, riskFreeRate, vol);
+}
+
+TermStructure BarrierOption::termStructure_(double riskFreeRate, double vol) const
+{
+	if (settings_.termStructure)
+	{
+		return settings_.termStructure->shifted(riskFreeRate - baseRiskFreeRate_, vol - baseVolatility_);
+	}
+	return TermStructure(riskFreeRate, vol);
+}
+
+void BarrierOption::checkSettings_(unsigned request) const
+{
+	// What the valuation would use, as bits; the Monte Carlo estimators only count for MONTE_CARLO
+	enum Feature
+	{
+		CLOSED_FORM, MULTILEVEL, COMMON_PASS, ONE_STEP_SURVIVAL, BRIDGE_WEIGHT, BRIDGE_SAMPLED, ANALYTIC_CONTROL,
+		TERMINAL_CONTROL, MT19937, SOBOL, ANTITHETIC, STORED_PATHS, SCALAR_ENGINE, SINGLE_PRECISION,
+		EGARCH, TERM_STRUCTURE, DOUBLE_BARRIER, REBATE, NUM_FEATURES
+	};
+	static const char* const names[NUM_FEATURES] = { "the closed form", "multilevel Monte Carlo",
+		"the single-pass greeks", "one-step survival",
+		"the Brownian-bridge weight", "the sampled bridge crossing", "the analytic control variate",
+		"the terminal-spot control variate", "mt19937 streams", "Sobol points", "antithetic pairs",
+		"cached or stored paths", "a path engine other than SIMD_BATCH", "single precision", "EGARCH volatility",
+		"a term structure", "a double or window barrier", "a rebate" };
+
+	// Each feature and the features it does not support
+	const unsigned flatMarket = (1u << EGARCH) | (1u << TERM_STRUCTURE);
+	const unsigned bridges = (1u << BRIDGE_WEIGHT) | (1u << BRIDGE_SAMPLED);
+	const unsigned controls = (1u << ANALYTIC_CONTROL) | (1u << TERMINAL_CONTROL);
+	const unsigned pathSources = (1u << ANTITHETIC) | (1u << STORED_PATHS);
+	static const struct { Feature feature; unsigned unsupported; } conflicts[] =
+	{
+		{ CLOSED_FORM, flatMarket | (1u << DOUBLE_BARRIER) },
+		{ MULTILEVEL, (1u << MT19937) | (1u << SOBOL) | bridges | controls | pathSources | (1u << ONE_STEP_SURVIVAL)
+			| (1u << EGARCH) | (1u << DOUBLE_BARRIER) | (1u << REBATE) },
+		{ ONE_STEP_SURVIVAL, flatMarket | (1u << DOUBLE_BARRIER) | (1u << REBATE) },
+		{ BRIDGE_WEIGHT, flatMarket | (1u << REBATE) },
+		{ BRIDGE_SAMPLED, flatMarket | (1u << DOUBLE_BARRIER) | (1u << REBATE) },
+		{ ANALYTIC_CONTROL, flatMarket | (1u << DOUBLE_BARRIER) },
+		{ EGARCH, 1u << TERM_STRUCTURE },
+		{ SINGLE_PRECISION, (1u << SCALAR_ENGINE) | (1u << SOBOL) | bridges | controls | pathSources | (1u << EGARCH)
+			| (1u << MULTILEVEL) | (1u << COMMON_PASS) | (1u << ONE_STEP_SURVIVAL) | (1u << DOUBLE_BARRIER) | (1u << REBATE) }
+	};
+
+	unsigned features = 0;
+	auto set = [&features](Feature feature, bool on)
+	{
+		features |= on ? (1u << feature) : 0u;
+	};
+	const bool monteCarlo = settings_.pricingMethod == PricingMethod::MONTE_CARLO;
+	set(CLOSED_FORM, !monteCarlo);
+	set(MULTILEVEL, monteCarlo && settings_.multilevel);
+	set(COMMON_PASS, monteCarlo && ((request & OptionResults::SECOND_ORDER)
+		|| (settings_.greeksMethod == GreeksMethod::SINGLE_PASS && !settings_.multilevel
+			&& (request & ~OptionResults::PRICE_ONLY))));
+	set(ONE_STEP_SURVIVAL, monteCarlo && (settings_.greeksMethod == GreeksMethod::ADJOINT
+		|| (request & (OptionResults::CONTRACT_SENSITIVITIES | OptionResults::SECOND_ORDER))));
+	set(BRIDGE_WEIGHT, monteCarlo && settings_.barrierMonitoring == BarrierMonitoring::BRIDGE_WEIGHT);
+	set(BRIDGE_SAMPLED, monteCarlo && settings_.barrierMonitoring == BarrierMonitoring::BRIDGE_SAMPLED);
+	set(ANALYTIC_CONTROL, monteCarlo && settings_.controlVariate == ControlVariate::ANALYTIC);
+	set(TERMINAL_CONTROL, monteCarlo && settings_.controlVariate == ControlVariate::TERMINAL_SPOT);
+	set(MT19937, monteCarlo && settings_.randomStream == RandomStream::MT19937_PER_SCENARIO);
+	set(SOBOL, monteCarlo && settings_.randomStream == RandomStream::SOBOL);
+	set(ANTITHETIC, monteCarlo && settings_.antithetic);
+	set(STORED_PATHS, monteCarlo && (settings_.cachePaths || !settings_.normalStore.empty()));
+	set(SCALAR_ENGINE, monteCarlo && settings_.pathEngine != PathEngine::SIMD_BATCH);
+	set(SINGLE_PRECISION, monteCarlo && settings_.precision == Precision::SINGLE);
+	set(EGARCH, settings_.egarch != nullptr);
+	set(TERM_STRUCTURE, settings_.termStructure != nullptr);
+	set(DOUBLE_BARRIER, !singleBarrier_());
+	set(REBATE, rebate_ != 0.0);
+
+	for (const auto& conflict : conflicts)
+	{
+		const unsigned clash = (features & (1u << conflict.feature)) ? features & conflict.unsupported : 0u;
+		if (clash != 0)
+		{
+			unsigned other = 0;
+			while ((clash & (1u << other)) == 0)
+			{
+				++other;
+			}
+			throw std::runtime_error(std::string("BarrierOption:  ") + names[conflict.feature] + " does not support "
+				+ names[other]);
+		}
+	}
+}
+
+RunStatistics* BarrierOption::statistics_() const
+{
+	return settings_.collectStatistics ? &runStatistics_ : nullptr;
+}
+
+void BarrierOption::recordBuffers_(const vector<double>& discountedPayoffs, const vector<double>& controls) const
+{
+	if (settings_.collectStatistics)
+	{
+		runStatistics_.bufferBytes = std::max(runStatistics_.bufferBytes,
+			(discountedPayoffs.capacity() + controls.capacity()) * sizeof(double));
+	}
+}
+
+void BarrierOption::runScenarios_(const std::function<void(size_t, size_t)>& simulate,
+	const std::function<double()>& stdError) const
+{
+	if (!adaptive_)
+	{
+		simulate(0, numScenarios_);
+		return;
+	}
+
+	const size_t maxScenarios = numScenarios_;
+	const size_t pathsPerSample = settings_.antithetic ? 2 : 1;
+	auto roundUp = [pathsPerSample](size_t n)
+	{
+		return (n + pathsPerSample - 1) / pathsPerSample * pathsPerSample;
+	};
+	const auto begin = std::chrono::steady_clock::now();
+
+	size_t n = 0;
+	size_t batch = roundUp(std::max<size_t>(settings_.batchSize, 2));
+	while (n < maxScenarios)
+	{
+		size_t next = std::min(maxScenarios, n + batch);
+		simulate(n, next);
+		n = next;
+		numScenarios_ = static_cast<unsigned>(n);
+
+		double error = stdError();
+		if (settings_.targetStdError > 0.0 && error <= settings_.targetStdError)
+		{
+			break;
+		}
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+		if (settings_.timeBudget > 0.0 && elapsed.count() >= settings_.timeBudget)
+		{
+			break;
+		}
+
+		// Next batch:  at most doubling the run, and no more than the variance so far says the target
+		// needs (with 5% to spare, and at least batchSize) or than there is time left for
+		double wanted = static_cast<double>(n);
+		if (settings_.targetStdError > 0.0)
+		{
+			double ratio = error / settings_.targetStdError;
+			wanted = std::min(wanted, std::max(1.05 * n * (ratio * ratio - 1.0), double(settings_.batchSize)));
+		}
+		if (settings_.timeBudget > 0.0)
+		{
+			wanted = std::min(wanted, (settings_.timeBudget - elapsed.count()) * n / elapsed.count());
+		}
+		batch = roundUp(std::max<size_t>(static_cast<size_t>(wanted), 1));
+	}
+
+	adaptive_ = false;
+}
+
+void BarrierOption::setPrice_(vector<double>& discountedPayoffs, const vector<double>& controls) const
+{
+	PhaseTimer timer(statistics_(), RunStatistics::REDUCTION);
+	if (!controls.empty())
+	{
+		applyControlVariate_(discountedPayoffs.data(), controls.data(), 1, expectedControl_(spot_, riskFreeRate_, volatility_));
+	}
+
+	price_ = quantity_ * (1.0 / discountedPayoffs.size()) * accumulate(discountedPayoffs.begin(), discountedPayoffs.end(), 0.0);
+	stdError_ = standardError_(discountedPayoffs.data(), 1);
+}
+
+void BarrierOption::priceScenarios_(const EquityPriceGenerator& epg, const BatchPathGenerator* batch, size_t begin,
+	size_t end, double* discountedPayoffs, double* controls, RunStatistics::PathCounts* counts) const
+{
+	// Scenario i always draws from the same stream (Philox(seed_, i) or mt19937_64(seed_ + i)),
+	// whichever engine or thread runs it.  Scenarios the batch kernel does not take, and those with
+	// the control variate, go through the scalar kernels.
+	if (batch != nullptr)
+	{
+		assert(controls == nullptr);
+		priceBatch_(*batch, begin, end, discountedPayoffs, counts);
+		return;
+	}
+
+	// The discount factor is the same for every path, so it is taken once here.
+	const double df = discFactor_(0.0, settlement_);
+
+	if (skeletonPaths_())
+	{
+		// The antithetic path of a pair is the skeleton negated
+		const size_t pathsPerSample = settings_.antithetic ? 2 : 1;
+		withBarrierPolicy(BarrierType_, optionType_, [&](auto policy)
+		{
+			const auto payoff = skeletonPayoff_<decltype(policy)>(spot_, riskFreeRate_, volatility_);
+			for (size_t i = begin; i < end; ++i)
+			{
+				const double sign = (i % pathsPerSample == 1) ? -1.0 : 1.0;
+				discountedPayoffs[i] = df * payoff(&pathCache_[(i / pathsPerSample) * numTimeSteps_], sign, counts);
+			}
+		});
+		return;
+	}
+
+	withPayoff_([&](auto policy, auto payoffOf)
+	{
+		withPathEngine_([&](auto pathVector)
+		{
+			forEachScenario_(begin, end, [&](size_t i, auto& normals)
+			{
+				discountedPayoffs[i] = discountedPayoff_<decltype(policy), decltype(pathVector)::value>(epg, normals,
+					payoffOf(epg.steps(), volatility_, i), df, (controls != nullptr) ? controls + i : nullptr, counts);
+			});
+		});
+	});
+}
+
+BatchPathGenerator BarrierOption::batchGenerator_(Precision precision) const
+{
+	return settings_.egarch
+		? BatchPathGenerator(spot_, numTimeSteps_, tau_, riskFreeRate_, volatility_, settings_.egarch, settings_.randomStream)
+		: BatchPathGenerator(spot_, numTimeSteps_, tau_, termStructure_(riskFreeRate_, volatility_), settings_.randomStream,
+			BatchPathGenerator::bestKernel(), precision);
+}
+
+void BarrierOption::priceBatch_(const BatchPathGenerator& batch, size_t begin, size_t end, double* discountedPayoffs,
+	RunStatistics::PathCounts* counts) const
+{
+	const double df = discFactor_(0.0, settlement_);
+	// The lanes refill from the whole piece, so only its last few paths run with idle lanes
+	const unsigned pieceSize = 256;
+	double terminalPrices[pieceSize];
+	bool hitBarrier[pieceSize];
+
+	withBarrierPolicy(BarrierType_, optionType_, [&](auto policy)
+	{
+		typedef decltype(policy) Policy;
+		for (size_t i = begin; i < end; i += pieceSize)
+		{
+			unsigned numPaths = static_cast<unsigned>(std::min<size_t>(pieceSize, end - i));
+			unsigned long long steps = batch.simulate(seed_, i, numPaths, BarrierType_, barrierLevel_,
+				terminalPrices, hitBarrier);
+			for (unsigned l = 0; l < numPaths; ++l)
+			{
+				discountedPayoffs[i + l] = df * Policy::payoff(strike_, terminalPrices[l], hitBarrier[l]);
+			}
+			if (counts != nullptr)
+			{
+				counts->addBlock(numPaths, steps, std::count(hitBarrier, hitBarrier + numPaths, true));
+			}
+		}
+	});
+}
+
+bool BarrierOption::singleBarrier_() const
+{
+	return upperBarrierLevel_ == std::numeric_limits<double>::infinity() && firstMonitored_ == 0
+		&& lastMonitored_ == numTimeSteps_;
+}
+
+double BarrierOption::analyticValue_(double spot, double riskFreeRate, double vol) const
+{
+	return AnalyticBarrier(BarrierType_, optionType_, barrierLevel_, strike_, 0.0, monitoringInterval_())
+		.price(spot, riskFreeRate, vol, tau_, settlement_);
+}
+
+double BarrierOption::expectedControl_(double spot, double riskFreeRate, double vol) const
+{
+	if (settings_.controlVariate == ControlVariate::TERMINAL_SPOT)
+	{
+		// The forward, discounted from the settlement date
+		return spot * termStructure_(riskFreeRate, vol).discountFactor(tau_, settlement_);
+	}
+	return analyticValue_(spot, riskFreeRate, vol);
+}
+
+double BarrierOption::monitoringInterval_() const
+{
+	if (settings_.monitoringDates == 0 || (settings_.pricingMethod == PricingMethod::MONTE_CARLO
+		&& settings_.barrierMonitoring == BarrierMonitoring::DISCRETE))
+	{
+		return 0.0;
+	}
+	return tau_ / settings_.monitoringDates;
+}
+
+void BarrierOption::applyControlVariate_(double* discountedPayoffs, const double* controls, size_t stride,
+	double expectedControl) const
+{
+	const size_t n = numScenarios_;
+	double meanX = 0.0, meanY = 0.0;
+	for (size_t i = 0; i < n; ++i)
+	{
+		meanX += discountedPayoffs[i * stride];
+		meanY += controls[i * stride];
+	}
+	meanX /= n;
+	meanY /= n;
+
+	double covariance = 0.0, variance = 0.0;
+	for (size_t i = 0; i < n; ++i)
+	{
+		double dy = controls[i * stride] - meanY;
+		covariance += (discountedPayoffs[i * stride] - meanX) * dy;
+		variance += dy * dy;
+	}
+	const double beta = (variance > 0.0) ? covariance / variance : 0.0;
+
+	for (size_t i = 0; i < n; ++i)
+	{
+		discountedPayoffs[i * stride] -= beta * (controls[i * stride] - expectedControl);
+	}
+}
+
+void BarrierOption::computeAnalytic_() const
+{
+	// Continuous monitoring (or its shifted equivalent for monitoringDates):  numTimeSteps_,
+	// numScenarios_ and the Monte Carlo settings play no part
+	OptionResults values = AnalyticBarrier(BarrierType_, optionType_, barrierLevel_, strike_, rebate_, monitoringInterval_())
+		.values(spot_, riskFreeRate_, volatility_, tau_, settlement_, quantity_);
+
+	price_ = values.resultSet.at(OptionResults::PRICE);
+	delta_ = values.resultSet.at(OptionResults::DELTA);
+	vega_ = values.resultSet.at(OptionResults::VEGA);
+	rho_ = values.resultSet.at(OptionResults::RHO);
+	strikeSensitivity_ = values.resultSet.at(OptionResults::STRIKE_SENSITIVITY);
+	barrierSensitivity_ = values.resultSet.at(OptionResults::BARRIER_SENSITIVITY);
+	gamma_ = values.resultSet.at(OptionResults::GAMMA);
+	vanna_ = values.resultSet.at(OptionResults::VANNA);
+	volga_ = values.resultSet.at(OptionResults::VOLGA);
+	stdError_ = 0.0;
+	std::fill(stdErrors_, stdErrors_ + OptionResults::NUM_VALUES, 0.0);
+}
+
+double BarrierOption::standardError_(const double* discountedPayoffs, size_t stride) const
+{
+	// An antithetic pair is one sample:  the mean of its two payoffs
+	const size_t pathsPerSample = settings_.antithetic ? 2 : 1;
+	const size_t n = numScenarios_ / pathsPerSample;
+	auto sample = [discountedPayoffs, stride, pathsPerSample](size_t j)
+	{
+		double x = 0.0;
+		for (size_t p = 0; p < pathsPerSample; ++p)
+		{
+			x += discountedPayoffs[(j * pathsPerSample + p) * stride];
+		}
+		return x / pathsPerSample;
+	};
+
+	if (settings_.randomStream == RandomStream::SOBOL)
+	{
+		// The points within a replication are not independent, but the replications are:
+		// the error comes from the spread of the replication means.
+		const size_t numReplications = quasiRandom_->numReplications();
+		vector<double> sums(numReplications, 0.0);
+		vector<size_t> counts(numReplications, 0);
+		for (size_t j = 0; j < n; ++j)
+		{
+			sums[j % numReplications] += sample(j);
+			++counts[j % numReplications];
+		}
+
+		double mean = 0.0, sumSq = 0.0;
+		size_t r = 0;
+		for (; r < numReplications && counts[r] > 0; ++r)
+		{
+			mean += sums[r] / counts[r];
+		}
+		if (r < 2)
+		{
+			return 0.0;
+		}
+		mean /= r;
+		for (size_t k = 0; k < r; ++k)
+		{
+			double d = sums[k] / counts[k] - mean;
+			sumSq += d * d;
+		}
+		return std::abs(quantity_) * std::sqrt(sumSq / (r * (r - 1.0)));
+	}
+
+	if (n < 2)
+	{
+		return 0.0;
+	}
+	double sum = 0.0, sumSq = 0.0;
+	for (size_t j = 0; j < n; ++j)
+	{
+		double x = sample(j);
+		sum += x;
+		sumSq += x * x;
+	}
+	double mean = sum / n;
+	double variance = (sumSq - n * mean * mean) / (n - 1.0);
+	return std::abs(quantity_) * std::sqrt(std::max(variance, 0.0) / n);
+}
+
+void BarrierOption::computeSinglePass_(unsigned request) const
+{
+	// Base, spot-up, vol-up and rate-up states share each scenario's normal draws, so one pass
+	// over the scenarios gives the price and the bumps; each state's path is the one a separate
+	// bump-and-reprice run (fused engine) would generate from the same seed.  Only the base and
+	// the bumps request needs are run:  they take slots 0 (the base), 1, ... numStates - 1.
+	enum { BASE, SPOT_UP, VOL_UP, RATE_UP, NUM_STATES };
+	PhaseTimer setupTimer(statistics_(), RunStatistics::SETUP);
+	const double up = 1.0 + greekShift_;
+	const double df = discFactor_(0.0, settlement_);
+
+	int states[NUM_STATES] = { BASE, BASE, BASE, BASE };
+	unsigned numStates = 1;
+	const OptionResults::Value bumpValues[NUM_STATES] = { OptionResults::PRICE, OptionResults::DELTA,
+		OptionResults::VEGA, OptionResults::RHO };
+	for (int state = SPOT_UP; state < NUM_STATES; ++state)
+	{
+		if (request & (1u << bumpValues[state]))
+		{
+			states[numStates++] = state;
+		}
+	}
+
+	vector<EquityPriceGenerator> generators;
+	double discountFactors[NUM_STATES];
+	double spots[NUM_STATES];
+	double rates[NUM_STATES];
+	double volatilities[NUM_STATES];
+	double expectedControls[NUM_STATES];
+	const bool useControls = (settings_.controlVariate != ControlVariate::NONE);
+	for (int k = 0; k < NUM_STATES; ++k)
+	{
+		const double spot = (states[k] == SPOT_UP) ? spot_ * up : spot_;
+		const double vol = (states[k] == VOL_UP) ? volatility_ + bump_(volatility_) : volatility_;
+		const double rate = (states[k] == RATE_UP) ? riskFreeRate_ + bump_(riskFreeRate_) : riskFreeRate_;
+		if (k < static_cast<int>(numStates))
+		{
+			generators.push_back(generator_(spot, rate, vol, numTimeSteps_));
+		}
+		discountFactors[k] = (states[k] == RATE_UP) ? termStructure_(rate, vol).discountFactor(0.0, settlement_) : df;
+		spots[k] = spot;
+		rates[k] = rate;
+		volatilities[k] = vol;
+		expectedControls[k] = useControls ? expectedControl_(spot, rate, vol) : 0.0;
+	}
+
+	// Gamma, vanna and volga come from the base scenarios' draws, by one-step survival:  a bumped
+	// state would need a second bump, and a knocked-out path's payoff has no second derivative
+	const bool secondOrder = (request & OptionResults::SECOND_ORDER) != 0;
+	enum { GAMMA, VANNA, VOLGA, NUM_SECOND_ORDER };
+	const OneStepSurvival survival(BarrierType_, optionType_, barrierLevel_, strike_, spot_, riskFreeRate_,
+		volatility_, tau_, numTimeSteps_, settings_.barrierMonitoring, monitoringInterval_());
+
+	vector<double> discountedPayoffs;	// Scenario-major
+	vector<double> controls;
+	vector<double> secondOrderPayoffs;	// Scenario-major:  gamma, vanna and volga
+	setupTimer.stop();
+
+	// Runs the states' payoffs over one path, counting the base state's path in counts if not null
+	auto simulateStates = [&](auto& normals, auto* payoffs, RunStatistics::PathCounts* counts)
+	{
+		if (counts == nullptr)
+		{
+			EquityPriceGenerator::simulateCommon(normals, generators.data(), payoffs, numStates);
+			return;
+		}
+
+		typedef InstrumentedPath<std::remove_reference_t<decltype(*payoffs)> > Instrumented;
+		Instrumented instrumented[NUM_STATES] = { Instrumented(payoffs[0]), Instrumented(payoffs[1]),
+			Instrumented(payoffs[2]), Instrumented(payoffs[3]) };
+		EquityPriceGenerator::simulateCommon(normals, generators.data(), instrumented, numStates);
+		counts->add(instrumented[0].steps(), instrumented[0].hit(), instrumented[0].hitStep());
+		for (unsigned k = 0; k < numStates; ++k)
+		{
+			payoffs[k] = instrumented[k].evaluator();
+		}
+	};
+
+	// Runs scenario i's states with payoffOf(k) as the payoff of slot k, and controlOf(k) as its
+	// control variate
+	auto priceControlled = [&](size_t i, auto& normals, RunStatistics::PathCounts* counts, auto payoffOf, auto controlOf)
+	{
+		typedef PathEvaluatorPair<decltype(payoffOf(0)), decltype(controlOf(0))> ControlledPayoff;
+		ControlledPayoff payoffs[NUM_STATES] = {
+			ControlledPayoff(payoffOf(0), controlOf(0)), ControlledPayoff(payoffOf(1), controlOf(1)),
+			ControlledPayoff(payoffOf(2), controlOf(2)), ControlledPayoff(payoffOf(3), controlOf(3)) };
+		simulateStates(normals, payoffs, counts);
+
+		for (unsigned k = 0; k < numStates; ++k)
+		{
+			discountedPayoffs[numStates * i + k] = discountFactors[k] * payoffs[k].first().payoff();
+			controls[numStates * i + k] = discountFactors[k] * payoffs[k].second().payoff();
+		}
+	};
+
+	// Runs scenario i's states with payoffOf(k) as the payoff of slot k, for the contract's policy
+	auto priceStates = [&](size_t i, auto& normals, RunStatistics::PathCounts* counts, auto policy, auto payoffOf)
+	{
+		typedef decltype(policy) Policy;
+		switch (settings_.controlVariate)
+		{
+		case ControlVariate::ANALYTIC:
+			priceControlled(i, normals, counts, payoffOf,
+				[&](int k) { return continuousPayoff_<Policy>(volatilities[k]); });
+			return;
+		case ControlVariate::TERMINAL_SPOT:
+			priceControlled(i, normals, counts, payoffOf, [](int) { return TerminalPricePayoff(); });
+			return;
+		default:
+			break;
+		}
+
+		typedef decltype(payoffOf(0)) Payoff;
+		Payoff payoffs[NUM_STATES] = { payoffOf(0), payoffOf(1), payoffOf(2), payoffOf(3) };
+		simulateStates(normals, payoffs, counts);
+
+		for (unsigned k = 0; k < numStates; ++k)
+		{
+			discountedPayoffs[numStates * i + k] = discountFactors[k] * payoffs[k].payoff();
+		}
+	};
+
+	auto priceChunk = [&](size_t begin, size_t end, RunStatistics::PathCounts* counts)
+	{
+		// The second-order estimator needs every draw of a path, even past a knock-out:  they are
+		// taken up front and replayed to the states
+		vector<double> draws(secondOrder ? numTimeSteps_ : 0);
+		auto priceSecondOrder = [&](size_t i)
+		{
+			const OneStepSurvival::Sensitivities sensitivities = survival(draws.data());
+			double* payoffs = &secondOrderPayoffs[NUM_SECOND_ORDER * i];
+			payoffs[GAMMA] = df * sensitivities.gamma;
+			payoffs[VANNA] = df * sensitivities.vanna;
+			payoffs[VOLGA] = df * sensitivities.volga;
+		};
+
+		if (skeletonPaths_())
+		{
+			const size_t pathsPerSample = settings_.antithetic ? 2 : 1;
+			withBarrierPolicy(BarrierType_, optionType_, [&](auto policy)
+			{
+				// The states' payoffs of the stored skeletons
+				typedef decltype(policy) Policy;
+				vector<SkeletonBarrierPayoff<Policy> > skeletonPayoffs;
+				for (unsigned k = 0; k < numStates; ++k)
+				{
+					skeletonPayoffs.push_back(skeletonPayoff_<Policy>(spots[k], rates[k], volatilities[k]));
+				}
+				for (size_t i = begin; i < end; ++i)
+				{
+					const double* skeleton = &pathCache_[(i / pathsPerSample) * numTimeSteps_];
+					const double sign = (i % pathsPerSample == 1) ? -1.0 : 1.0;
+					for (unsigned k = 0; k < numStates; ++k)
+					{
+						discountedPayoffs[numStates * i + k] = discountFactors[k]
+							* skeletonPayoffs[k](skeleton, sign, (k == 0) ? counts : nullptr);
+					}
+					if (secondOrder)
+					{
+						skeletonDraws_(i, draws.data());
+						priceSecondOrder(i);
+					}
+				}
+			});
+			return;
+		}
+
+		withPayoff_([&](auto policy, auto payoffOf)
+		{
+			forEachScenario_(begin, end, [&](size_t i, auto& normals)
+			{
+				// The sampled crossings of every state come from scenario i's one set of uniforms.  The
+				// slots past numStates are never run.
+				auto statePayoff = [&](int k)
+				{
+					return payoffOf(generators[std::min(static_cast<unsigned>(k), numStates - 1)].steps(),
+						volatilities[k], i);
+				};
+				if (!secondOrder)
+				{
+					priceStates(i, normals, counts, policy, statePayoff);
+					return;
+				}
+				for (double& z : draws)
+				{
+					z = normals();
+				}
+				StoredNormals replay(draws.data());
+				priceStates(i, replay, counts, policy, statePayoff);
+				priceSecondOrder(i);
+			});
+		});
+	};
+
+	runScenarios_([&](size_t begin, size_t end)
+	{
+		discountedPayoffs.resize(numStates * end);
+		controls.resize(useControls ? numStates * end : 0);
+		secondOrderPayoffs.resize(secondOrder ? NUM_SECOND_ORDER * end : 0);
+		recordBuffers_(discountedPayoffs, controls);
+		simulateScenarios_(begin, end, runParallel_, priceChunk);
+	}, [&]()
+	{
+		// Only the base state counts towards the target
+		PhaseTimer timer(statistics_(), RunStatistics::REDUCTION);
+		vector<double> payoffs(discountedPayoffs);
+		if (useControls)
+		{
+			applyControlVariate_(payoffs.data(), controls.data(), numStates, expectedControls[0]);
+		}
+		return standardError_(payoffs.data(), numStates);
+	});
+
+	PhaseTimer reductionTimer(statistics_(), RunStatistics::REDUCTION);
+	if (useControls)
+	{
+		for (unsigned k = 0; k < numStates; ++k)
+		{
+			applyControlVariate_(discountedPayoffs.data() + k, controls.data() + k, numStates, expectedControls[k]);
+		}
+	}
+
+	double prices[NUM_STATES] = { 0.0, 0.0, 0.0, 0.0 };
+	for (size_t i = 0; i < numScenarios_; ++i)
+	{
+		for (unsigned k = 0; k < numStates; ++k)
+		{
+			prices[k] += discountedPayoffs[numStates * i + k];
+		}
+	}
+	for (unsigned k = 0; k < numStates; ++k)
+	{
+		prices[k] *= quantity_ / numScenarios_;
+	}
+
+	price_ = prices[0];
+	stdError_ = standardError_(discountedPayoffs.data(), numStates);
+	vector<double> differences(numStates > 1 ? numScenarios_ : 0);
+	for (unsigned k = 1; k < numStates; ++k)
+	{
+		double shift = 0.0;
+		switch (states[k])
+		{
+		case SPOT_UP:
+			shift = spot_ * greekShift_;
+			delta_ = (prices[k] - prices[0]) / shift;
+			break;
+		case VOL_UP:
+			shift = bump_(volatility_);
+			vega_ = (prices[k] - prices[0]) / shift;
+			break;
+		case RATE_UP:
+			shift = bump_(riskFreeRate_);
+			rho_ = (prices[k] - prices[0]) / shift;
+			break;
+		default:
+			assert(false);
+			break;
+		}
+		for (size_t i = 0; i < numScenarios_; ++i)
+		{
+			differences[i] = discountedPayoffs[numStates * i + k] - discountedPayoffs[numStates * i];
+		}
+		stdErrors_[bumpValues[states[k]]] = standardError_(differences.data(), 1) / shift;
+	}
+
+	if (secondOrder)
+	{
+		double totals[NUM_SECOND_ORDER] = { 0.0, 0.0, 0.0 };
+		for (size_t i = 0; i < numScenarios_; ++i)
+		{
+			for (int k = 0; k < NUM_SECOND_ORDER; ++k)
+			{
+				totals[k] += secondOrderPayoffs[NUM_SECOND_ORDER * i + k];
+			}
+		}
+		gamma_ = quantity_ * totals[GAMMA] / numScenarios_;
+		vanna_ = quantity_ * totals[VANNA] / numScenarios_;
+		volga_ = quantity_ * totals[VOLGA] / numScenarios_;
+		const OptionResults::Value secondOrderValues[NUM_SECOND_ORDER] = { OptionResults::GAMMA, OptionResults::VANNA,
+			OptionResults::VOLGA };
+		for (int k = 0; k < NUM_SECOND_ORDER; ++k)
+		{
+			stdErrors_[secondOrderValues[k]] = standardError_(secondOrderPayoffs.data() + k, NUM_SECOND_ORDER);
+		}
+	}
+}
+
+void BarrierOption::computeDelta_() const
+{
+	double origSpot = spot_;
+	double origPrice = price_;
+	spot_ *= 1.0 + greekShift_;
+	computePrice_();
+
+	delta_ = (price_ - origPrice) / (origSpot * greekShift_);
+
+	// reset state to original:
+	spot_ = origSpot;
+	price_ = origPrice;
+}
+
+void BarrierOption::computeVega_() const
+{
+	double origVol = volatility_;
+	double origPrice = price_;
+	const double shift = bump_(volatility_);
+	volatility_ += shift;
+	computePrice_();
+
+	vega_ = (price_ - origPrice) / shift;
+
+	// reset state to original:
+	volatility_ = origVol;
+	price_ = origPrice;
+}
+
+void BarrierOption::computeRho_() const
+{
+	double origRfRate_ = riskFreeRate_;
+	double origPrice = price_;
+	const double shift = bump_(riskFreeRate_);
+	riskFreeRate_ += shift;		// With a term structure, this shifts the entire curve
+								// (see termStructure_)
+	computePrice_();
+
+	rho_ = (price_ - origPrice) / shift;
+
+	// reset state to original:
+	riskFreeRate_ = origRfRate_;
+	price_ = origPrice;
+}
+
+double BarrierOption::bump_(double level) const
+{
+	return (level != 0.0) ? level * greekShift_ : greekShift_;
+}
+
+double BarrierOption::discFactor_(double yearFraction1, double yearFraction2) const
+{
+	if (yearFraction1 <= yearFraction2 && settings_.termStructure)
+	{
+		return termStructure_(riskFreeRate_, volatility_).discountFactor(yearFraction1, yearFraction2);
+	}
+	else if (yearFraction1 <= yearFraction2)
+	{
+		return exp(-(yearFraction2 - yearFraction1)*riskFreeRate_);
+	}
+	else
+	{
+		// handle error:  For now, just return NaN (Not a Number).
+		// Should put in an exception for production.
+		return std::numeric_limits<double>::quiet_NaN();
+	}
+}
@@ -1,74 +1,342 @@
-#ifndef BARRIER_OPTION
-#define BARRIER_OPTION
-
-#include "Date.h"
-#include "DayCount.h"
-#include "ResultSet.h"
-#include "EquityPriceGenerator.h"
-
-
-class BarrierOption
-{
-	// Proposed defaults: bool runParallel = true, int seed = 0, double greekShift = 0.01
-public:
-	BarrierOption(double barrierLevel,double strike, double spot, double riskFreeRate, double volatility,
-		double quantity, Barrier BarrierType, const Date& valueDate, const Date& expiryDate,
-		const Date& settlementDate, unsigned numTimeSteps, unsigned numScenarios, bool runParallel,
-		int seed, double greekShift, const Act365& dc);
-
-	OptionResults operator()() const;
-	double time() const;		// Time required to run calcutions (for comparison using concurrency)
-
-private:
-	void calculate_();			// Compute price and risk values (called from ctor)
-
-	// Indicates whether to run pricing scenarios in parallel
-	bool runParallel_;			// default = true
-
-	// Private helper functions:
-	void computePrice_();
-	void computeDelta_();
-	//	void computeGamma_();
-	void computeVega_();
-	void computeRho_();
-
-	// Compare results:  non-parallel vs in-parallel with async and futures
-	void computePriceNoParallel_();
-	void computePriceAsync_();
-
-	// Compute discount factor P(t1, t2)
-	double discFactor_(double yearFactor1, double yearFactor2);
-
-	// Inputs to model:
-	Barrier BarrierType_;	// porc_: put or call
-	double barrierLevel_;
-	double spot_;
-	double strike_;
-	double riskFreeRate_;
-	double volatility_;
-	double quantity_;
-	unsigned numTimeSteps_;
-	double yearFraction_;
-	double greekShift_;		// Percentage shift to use for risk value approximations (default = 1%)
-	double tau_;			// Daycount adjusted time to expiration (as year fraction)
-	double settlement_;		// Daycount adjusted time to settlement (as year fraction)
-	unsigned numScenarios_;
-	int seed_;
-
-	// Calculated values stored in these private members:
-	double price_;
-	double delta_;
-	//	double gamma_;
-	double vega_;
-	double rho_;
-
-	// Runtime comparison using concurrency
-	double time_;
-
-	// Result set of option values:
-	OptionResults results_;
-};
-
-
-#endif // !BARRIER_OPTION
-
+#ifndef BARRIER_OPTION
+#define BARRIER_OPTION
+
+#include "Date.h"
+#include "DayCount.h"
+#include "ResultSet.h"
+#include "EquityPriceGenerator.h"
+#include "PricingThreadPool.h"
+#include "EngineSettings.h"
+#include "QuasiRandomNormals.h"
+#include "NormalStore.h"
+#include "BarrierPayoff.h"
+#include "RunStatistics.h"
+#include "TermStructure.h"
+#include "BatchPathGenerator.h"
+#include <vector>
+#include <memory>
+#include <functional>
+#include <thread>
+
+
+class BarrierOption
+{
+	// Proposed defaults: bool runParallel = true, int seed = 0, double greekShift = 0.01
+	// executor:  pool used for the parallel run; if null, the process-wide shared pool is used.
+	// The pool is not owned and must outlive the BarrierOption.
+	// settings:  choice of pricing method and Monte Carlo engine (see EngineSettings.h).
+	// Constructing the option does not value it:  the values are computed when first asked for,
+	// and kept until an input changes.  A normal store named in settings is opened then too; the
+	// valuation throws std::runtime_error if it does not fit the trade, if settings ask for EGARCH
+	// volatility or a term structure with an estimator that needs a flat market, for single precision
+	// off the SIMD batch engine, or for a multilevel run with an engine it does not support.
+public:
+	BarrierOption(double barrierLevel, double strike, double spot, double riskFreeRate, double volatility,
+		double quantity, Barrier BarrierType, OptionType optionType, const Date& valueDate, const Date& expiryDate,
+		const Date& settlementDate, unsigned numTimeSteps, unsigned numScenarios, bool runParallel,
+		int seed, double greekShift, const Act365& dc, PricingThreadPool* executor = nullptr,
+		const EngineSettings& settings = EngineSettings());
+
+	// With a cash rebate, paid as AnalyticBarrier pays it:  at expiry for a knock-in that was never
+	// knocked in, when the barrier is hit for a knock-out (each settled settlement - expiry later).
+	// The Monte Carlo engines price it only with BarrierMonitoring::DISCRETE, and not by multilevel
+	// or for the adjoint, contract or second-order values; the valuation throws std::runtime_error
+	// if settings or the request ask for one of those.
+	BarrierOption(double barrierLevel, double strike, double spot, double riskFreeRate, double volatility,
+		double quantity, Barrier BarrierType, OptionType optionType, double rebate, const Date& valueDate,
+		const Date& expiryDate, const Date& settlementDate, unsigned numTimeSteps, unsigned numScenarios,
+		bool runParallel, int seed, double greekShift, const Act365& dc, PricingThreadPool* executor = nullptr,
+		const EngineSettings& settings = EngineSettings());
+
+	// Double and window barriers:  knocked in (knockIn) or out by a price at or below lowerBarrier or
+	// at or above upperBarrier, monitored only at the time steps from windowStart to windowEnd (the
+	// initial price being at valueDate).  Either barrier may be left out, as 0 (lower) or infinity
+	// (upper), for a window on a single barrier.  Throws std::invalid_argument unless lowerBarrier <
+	// upperBarrier with at least one of them given.  The Monte Carlo engines price these with
+	// BarrierMonitoring::DISCRETE and BRIDGE_WEIGHT (see CorridorBarrierPayoff), but not by
+	// multilevel or for the adjoint, contract or second-order values, and there is no closed form;
+	// the valuation throws std::runtime_error if settings or the request ask for one of those.
+	BarrierOption(double lowerBarrier, double upperBarrier, double strike, double spot, double riskFreeRate,
+		double volatility, double quantity, bool knockIn, OptionType optionType, double rebate,
+		const Date& windowStart, const Date& windowEnd, const Date& valueDate, const Date& expiryDate,
+		const Date& settlementDate, unsigned numTimeSteps, unsigned numScenarios, bool runParallel, int seed,
+		double greekShift, const Act365& dc, PricingThreadPool* executor = nullptr,
+		const EngineSettings& settings = EngineSettings());
+
+	// The original contracts, with the option type implied by the barrier:  a down barrier on a
+	// call, an up barrier on a put
+	BarrierOption(double barrierLevel,double strike, double spot, double riskFreeRate, double volatility,
+		double quantity, Barrier BarrierType, const Date& valueDate, const Date& expiryDate,
+		const Date& settlementDate, unsigned numTimeSteps, unsigned numScenarios, bool runParallel,
+		int seed, double greekShift, const Act365& dc, PricingThreadPool* executor = nullptr,
+		const EngineSettings& settings = EngineSettings());
+
+	// Price, delta, vega and rho
+	OptionResults operator()() const;
+
+	// The values in request, a mask of OptionResults::Value bits (eg OptionResults::PRICE_ONLY):  only
+	// the simulations those need are run, and values already computed are not computed again.  The
+	// result holds every value computed so far.  Gamma, vanna and volga (OptionResults::SECOND_ORDER)
+	// come from one extra estimator on the base scenarios' paths (see OneStepSurvival), run in the
+	// same pass as the price with GreeksMethod::SINGLE_PASS; it conditions every step within reach of
+	// the barrier, so it costs 3.5 to 7 times a first-order run.  The option only changes through the
+	// setters:  the values computed here are a cache (hence const, and not safe to call concurrently).
+	OptionResults operator()(unsigned request) const;
+
+	double time() const;		// Wall-clock time required to run calcutions so far (for comparison using concurrency)
+	double stdError() const;	// Standard error of the price (with SOBOL, from the spread of the replications)
+
+	// Standard error of a value computed so far:  a greek's from the spread of its per-scenario
+	// estimates (one-step survival, the adjoint, or the single-pass bumped differences), 0 from the
+	// closed form, and NaN where there are none (bump-and-reprice and multilevel greeks)
+	double stdError(OptionResults::Value value) const;
+
+	// With EngineSettings::precision SINGLE, the price of the first precisionCheckScenarios scenarios
+	// in single precision less their price in double, on the same draws:  the rounding the float paths
+	// add, to set against stdError().  0 until a price has been checked.
+	double precisionDifference() const;
+
+	// Change a market input; the values computed so far are dropped (but not the cached paths)
+	void setSpot(double spot);
+	void setVolatility(double volatility);
+	void setRiskFreeRate(double riskFreeRate);
+
+	// With EngineSettings::cachePaths, the number of scenarios whose draws are held
+	std::size_t cachedScenarios() const;
+
+private:
+	void calculate_(unsigned request) const;	// Compute the values in request not yet in results_
+	void invalidate_();					// Drop the values computed so far
+
+	// Indicates whether to run pricing scenarios in parallel
+	bool runParallel_;			// default = true
+
+	// Thread pool used by the parallel runs (not owned; null means the shared pool)
+	PricingThreadPool* executor_;
+	static const unsigned scenarioChunkSize_ = 64;	// Scenarios per unit of work handed to the pool
+
+	EngineSettings settings_;
+	mutable std::shared_ptr<const QuasiRandomNormals> quasiRandom_;	// Set up by calculate_() when settings_ asks for SOBOL
+	mutable std::shared_ptr<const NormalStore> normalStore_;		// Opened by calculate_() when settings_ names one
+	mutable std::vector<double> pathCache_;		// cachePaths:  sample j's numTimeSteps_ draws (or their running
+										// sums, with skeletonPaths_()) start at j * numTimeSteps_
+
+	// Private helper functions:
+	void computePrice_() const;
+	void computeDelta_() const;
+	void computeVega_() const;
+	void computeRho_() const;
+	void computeSinglePass_(unsigned request) const;	// Price and the greeks in request from one pass (common random numbers)
+	void computeAdjoint_(unsigned request) const;		// The first-order values in request by adjoint differentiation
+	void computeAnalytic_() const;	// Price and the first- and second-order greeks from the closed form
+	void computeMultilevel_() const;	// Price by multilevel Monte Carlo (see EngineSettings::multilevel)
+	void checkPrecision_() const;		// Sets precisionDifference_ (see precisionDifference())
+
+	// Price from the scenarios, on this thread or (parallel) on the pricing thread pool;  the
+	// result is the same either way
+	void computeScenarioPrice_(bool parallel) const;
+
+	// Runs task(chunkBegin, chunkEnd, counts) over scenarios [begin, end):  on the pool in chunks of
+	// scenarioChunkSize_ if parallel, else in one call on this thread.  counts is null unless
+	// statistics are being collected; the tasks, their time and the path counts then go into
+	// runStatistics_.
+	void simulateScenarios_(std::size_t begin, std::size_t end, bool parallel,
+		const std::function<void(std::size_t, std::size_t, RunStatistics::PathCounts*)>& task) const;
+
+	// With settings_.cachePaths, draws and stores the normals of samples [0, numSamples) that are not
+	// already stored (an antithetic pair is one sample)
+	void extendPathCache_(std::size_t numSamples) const;
+
+	// Whether the cache holds each path's running sums of its draws, priced by SkeletonBarrierPayoff
+	// rather than by regenerating the path
+	bool skeletonPaths_() const;
+
+	// Whether the price's scenarios go through the SIMD batch kernel (without a control variate)
+	bool batchPaths_() const;
+
+	// The payoff of the stored skeletons in a market state, for the contract's Policy (see
+	// withBarrierPolicy(.))
+	template <typename Policy>
+	SkeletonBarrierPayoff<Policy> skeletonPayoff_(double spot, double riskFreeRate, double vol) const;
+
+	// Scenario i's numTimeSteps_ draws, recovered from its stored skeleton
+	void skeletonDraws_(std::size_t i, double* draws) const;
+
+	// The path generator for a market state, on numTimeSteps steps:  with settings_.egarch, vol is the
+	// initial volatility, and with settings_.termStructure, the curves are shifted to riskFreeRate and vol
+	EquityPriceGenerator generator_(double spot, double riskFreeRate, double vol, unsigned numTimeSteps) const;
+
+	// The rate and volatility curves of a market state:  settings_.termStructure moved in parallel by
+	// riskFreeRate and vol's change from the option's inputs, else flat at riskFreeRate and vol
+	TermStructure termStructure_(double riskFreeRate, double vol) const;
+
+	// Throws std::runtime_error if settings_, the trade or request combine an estimator with something
+	// it does not support (a flat-market estimator with EGARCH, say)
+	void checkSettings_(unsigned request) const;
+
+	// Multilevel:  the number of time steps on each level, coarsest first.  The coarsest is the
+	// smallest divisor of numTimeSteps_ with at least settings_.coarsestSteps steps, and each level
+	// refines the one before by the next prime factor of what is left, smallest first (so 12, 24,
+	// 48, 144, 720 for 720 steps).
+	std::vector<unsigned> multilevelGrid_() const;
+	mutable std::vector<std::size_t> levelSamples_;		// Scenarios per level, set by the price run and reused
+												// by the bumped revaluations
+
+	// With statistics being collected, the run's statistics (else null), and a note of the size of
+	// the per-scenario buffers
+	RunStatistics* statistics_() const;
+	void recordBuffers_(const std::vector<double>& discountedPayoffs, const std::vector<double>& controls) const;
+
+	// Calls simulate(begin, end) to run scenarios [begin, end), starting from 0.  Normally that is one
+	// call for all numScenarios_; in target-precision mode (see EngineSettings) it is a run of batches,
+	// with stdError() giving the price's standard error after each, and numScenarios_ is then cut
+	// down to the number run.  Later calls (eg, the bumped revaluations) run that same number.
+	void runScenarios_(const std::function<void(std::size_t, std::size_t)>& simulate,
+		const std::function<double()>& stdError) const;
+	mutable bool adaptive_;		// Target-precision mode, with the number of scenarios still to be set
+
+	// Fills discountedPayoffs[begin, end) for scenarios begin..end-1 (indexed from 0), and if
+	// controls is not null, controls[begin, end) with the discounted control variate.  With
+	// settings_.antithetic, scenarios 2j and 2j + 1 are an antithetic pair.
+	// If counts is not null, the paths are counted in it.  batch is the valuation's batch generator
+	// (see batchGenerator_()), or null if its scenarios do not go to the SIMD batch kernel.
+	void priceScenarios_(const EquityPriceGenerator& epg, const BatchPathGenerator* batch, std::size_t begin,
+		std::size_t end, double* discountedPayoffs, double* controls, RunStatistics::PathCounts* counts) const;
+	// The SIMD batch generator for the current market, in precision.  It is built once per valuation
+	// rather than per chunk:  with a term structure or EGARCH it tabulates every time step.
+	BatchPathGenerator batchGenerator_(Precision precision) const;
+	// priceScenarios_ on the SIMD batch kernel (see batchPaths_())
+	void priceBatch_(const BatchPathGenerator& batch, std::size_t begin, std::size_t end, double* discountedPayoffs,
+		RunStatistics::PathCounts* counts) const;
+
+	// Sets price_ and stdError_ from every scenario's discounted payoff (and control variate, if any)
+	void setPrice_(std::vector<double>& discountedPayoffs, const std::vector<double>& controls) const;
+
+	// Calls scenarioFn(i, normals) for scenarios i = begin..end-1, where normals is scenario i's
+	// source of draws for the random stream in settings_
+	template <typename ScenarioFn>
+	void forEachScenario_(std::size_t begin, std::size_t end, ScenarioFn scenarioFn) const;
+
+	// Calls priceWith(policy, payoffOf) once, where policy is the contract's BarrierPolicy and
+	// payoffOf(steps, vol, i) makes scenario i's payoff, with the barrier monitored as settings_ asks,
+	// on a path with steps' tables and volatility vol:  the switch on the monitoring and the contract
+	// (see withBarrierPolicy(.)) is taken here, so that the scenario loop in priceWith is
+	// instantiated for each payoff type
+	template <typename PriceFn>
+	void withPayoff_(PriceFn priceWith) const;
+
+	// Calls fn(std::true_type()) for PathEngine::PATH_VECTOR, else fn(std::false_type()):  the switch
+	// on the path engine, taken outside the scenario loop that fn passes it on to evaluatePath_
+	template <typename Fn>
+	void withPathEngine_(Fn fn) const;
+
+	// Discounted payoff of a path through payoff; if control is not null, also writes the discounted
+	// control variate for the same path, and if counts is not null, counts the path in it.  df is
+	// the discount factor to the settlement date.  Policy is the contract's (for the analytic
+	// control variate) and pathVector the path engine, as from withPayoff_ and withPathEngine_.
+	template <typename Policy, bool pathVector, typename NormalSource, typename Payoff>
+	double discountedPayoff_(const EquityPriceGenerator& epg, NormalSource& normals, Payoff payoff, double df,
+		double* control, RunStatistics::PathCounts* counts) const;
+
+	// Runs one path through evaluator, on the whole stored path if pathVector (see withPathEngine_)
+	// and else generated step by step, and counts it in counts if that is not null
+	template <bool pathVector, typename NormalSource, typename PathEvaluator>
+	void evaluatePath_(const EquityPriceGenerator& epg, NormalSource& normals, PathEvaluator& evaluator,
+		RunStatistics::PathCounts* counts) const;
+
+	// The payoffs for BarrierMonitoring::BRIDGE_* and ControlVariate::ANALYTIC:  the continuously
+	// monitored contract (with the barrier shifted for monitoringDates, if any) on a path generated
+	// with volatility vol, for the contract's Policy.  The sampled payoff draws its crossings from
+	// scenario i's own uniforms.
+	template <typename Policy>
+	ContinuousBarrierPayoff<Policy> continuousPayoff_(double vol) const;
+	template <typename Policy>
+	SampledBarrierPayoff<Policy> sampledPayoff_(double vol, std::size_t i) const;
+
+	// Whether the contract is one barrier monitored over the whole path (not a double or window
+	// barrier)
+	bool singleBarrier_() const;
+
+	// The payoff of a double or window barrier on a path with steps' tables:  with vol > 0, weighted
+	// by the bridge on that volatility (and with the barriers shifted for monitoringDates, if any)
+	template <typename Policy>
+	CorridorBarrierPayoff<Policy> corridorPayoff_(const TimeStepTable& steps, double vol) const;
+	double analyticValue_(double spot, double riskFreeRate, double vol) const;
+
+	// Expected discounted value per unit of the control variate in settings_
+	double expectedControl_(double spot, double riskFreeRate, double vol) const;
+
+	// Year fraction between the contract's monitoring dates, or 0 for a continuous barrier (and for
+	// Monte Carlo with BarrierMonitoring::DISCRETE, where the time steps are the monitoring dates)
+	double monitoringInterval_() const;
+
+	// Replaces each discounted payoff X (every stride'th entry) by X - beta (Y - expectedControl),
+	// Y being its control variate, with the variance-minimizing beta estimated from the sample
+	void applyControlVariate_(double* discountedPayoffs, const double* controls, std::size_t stride,
+		double expectedControl) const;
+
+	// Standard error of |quantity_| x the mean of discountedPayoffs[0], [stride], [2 stride], ...
+	// (one entry per scenario; an antithetic pair counts as one sample)
+	double standardError_(const double* discountedPayoffs, std::size_t stride) const;
+
+	// The shift the bumped vega and rho apply to a vol or rate level:  greekShift_ relative to it, or
+	// greekShift_ absolute at a level of 0, which a relative shift would not move
+	double bump_(double level) const;
+
+	// Compute discount factor P(t1, t2) (off settings_.termStructure, if set)
+	double discFactor_(double yearFactor1, double yearFactor2) const;
+
+	// Inputs to model:
+	Barrier BarrierType_;
+	OptionType optionType_;
+	double barrierLevel_;		// The lower barrier of a double barrier
+	double upperBarrierLevel_;	// Infinity but for a double barrier
+	unsigned firstMonitored_;	// The prices at which the barrier is monitored (0 being the initial
+	unsigned lastMonitored_;	// price):  all of them but for a window barrier
+	double rebate_;
+	mutable double spot_;			// Bumped in place (and restored) by computeDelta_
+	double strike_;
+	mutable double riskFreeRate_;	// ... by computeRho_
+	mutable double volatility_;		// ... by computeVega_
+	double quantity_;
+	unsigned numTimeSteps_;
+	double yearFraction_;
+	double greekShift_;		// Relative shift to use for risk value approximations (default = 1%), ie x -> x(1 + shift)
+							// (absolute for a zero rate or vol:  see bump_)
+	double tau_;			// Daycount adjusted time to expiration (as year fraction)
+	double settlement_;		// Daycount adjusted time to settlement (as year fraction)
+	mutable unsigned numScenarios_;
+	unsigned maxScenarios_;	// numScenarios as given (numScenarios_ is cut down in target-precision mode)
+	double baseRiskFreeRate_;	// riskFreeRate and volatility as given:  the levels of settings_.termStructure
+	double baseVolatility_;
+	int seed_;
+
+	// Calculated values stored in these private members (filled in on demand by operator()):
+	mutable double price_;
+	mutable double delta_;
+	mutable double gamma_;
+	mutable double vega_;
+	mutable double rho_;
+	mutable double strikeSensitivity_;
+	mutable double barrierSensitivity_;
+	mutable double vanna_;
+	mutable double volga_;
+	mutable double stdError_;
+	mutable double stdErrors_[OptionResults::NUM_VALUES];	// See stdError(Value) (the price's is stdError_)
+	mutable double precisionDifference_;
+	mutable std::size_t precisionScenarios_;	// Scenarios behind precisionDifference_ (0 if not checked)
+
+	// Runtime comparison using concurrency
+	mutable double time_;
+
+	// Filled in only with settings_.collectStatistics
+	mutable RunStatistics runStatistics_;
+	mutable std::vector<std::thread::id> taskThreads_;		// Threads that have run a task so far
+
+	// Result set of option values:
+	mutable OptionResults results_;
+};
+
+
+#endif // !BARRIER_OPTION
+
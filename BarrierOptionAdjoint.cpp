@@ -0,0 +1,115 @@
+#include "BarrierOption.h"
+#include "BarrierOptionPaths.h"
+#include "OneStepSurvival.h"
+#include "BatchPathGenerator.h"
+#include <vector>
+
+using std::vector;
+using std::size_t;
+
+void BarrierOption::computeAdjoint_(unsigned request) const
+{
+	// Each path, conditioned on surviving each step, is differentiated in reverse (see
+	// OneStepSurvival::adjoints):  one pass gives the price and every first-order sensitivity.  The
+	// survival weights take the place of the payoff evaluators and the control variates.
+	enum { VALUE, SPOT, VOL, RATE, STRIKE, BARRIER, NUM_ADJOINTS };
+	PhaseTimer setupTimer(statistics_(), RunStatistics::SETUP);
+	const double df = discFactor_(0.0, settlement_);
+	const OneStepSurvival survival(BarrierType_, optionType_, barrierLevel_, strike_, spot_, riskFreeRate_,
+		volatility_, tau_, numTimeSteps_, settings_.barrierMonitoring, monitoringInterval_());
+	vector<double> discountedValues;	// Scenario-major:  the value and its derivatives, as above
+
+	// A whole path's Philox draws at a time, as they are taken here, go through the batch engine's
+	// vector transform:  the same draws as the scenario's PhiloxNormals, to rounding
+	const bool vectorDraws = settings_.randomStream == RandomStream::PHILOX && !settings_.antithetic
+		&& !settings_.cachePaths && !normalStore_;
+	const BatchPathGenerator::Kernel kernel = BatchPathGenerator::bestKernel();
+	setupTimer.stop();
+
+	auto priceChunk = [&](size_t begin, size_t end, RunStatistics::PathCounts* counts)
+	{
+		vector<double> draws(numTimeSteps_);
+		auto pricePath = [&](size_t i)
+		{
+			const OneStepSurvival::Adjoints adjoints = survival.adjoints(draws.data());
+			double* values = &discountedValues[NUM_ADJOINTS * i];
+			values[VALUE] = df * adjoints.value;
+			values[SPOT] = df * adjoints.delta;
+			values[VOL] = df * adjoints.vega;
+			values[RATE] = df * (adjoints.rho - settlement_ * adjoints.value);	// The discounting too
+			values[STRIKE] = df * adjoints.strike;
+			values[BARRIER] = df * adjoints.barrier;
+			if (counts != nullptr)
+			{
+				counts->add(numTimeSteps_, false, 0);	// A conditioned path never hits the barrier
+			}
+		};
+
+		if (skeletonPaths_())
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				skeletonDraws_(i, draws.data());
+				pricePath(i);
+			}
+			return;
+		}
+		if (vectorDraws)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				BatchPathGenerator::philoxNormals(seed_, i, numTimeSteps_, draws.data(), kernel);
+				pricePath(i);
+			}
+			return;
+		}
+		forEachScenario_(begin, end, [&](size_t i, auto& normals)
+		{
+			for (double& z : draws)
+			{
+				z = normals();
+			}
+			pricePath(i);
+		});
+	};
+
+	runScenarios_([&](size_t begin, size_t end)
+	{
+		discountedValues.resize(NUM_ADJOINTS * end);
+		recordBuffers_(discountedValues, vector<double>());
+		simulateScenarios_(begin, end, runParallel_, priceChunk);
+	}, [&]()
+	{
+		PhaseTimer timer(statistics_(), RunStatistics::REDUCTION);
+		return standardError_(discountedValues.data(), NUM_ADJOINTS);
+	});
+
+	PhaseTimer reductionTimer(statistics_(), RunStatistics::REDUCTION);
+	double totals[NUM_ADJOINTS] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+	for (size_t i = 0; i < numScenarios_; ++i)
+	{
+		for (int k = 0; k < NUM_ADJOINTS; ++k)
+		{
+			totals[k] += discountedValues[NUM_ADJOINTS * i + k];
+		}
+	}
+
+	const OptionResults::Value values[NUM_ADJOINTS] = { OptionResults::PRICE, OptionResults::DELTA,
+		OptionResults::VEGA, OptionResults::RHO, OptionResults::STRIKE_SENSITIVITY, OptionResults::BARRIER_SENSITIVITY };
+	double* members[NUM_ADJOINTS] = { &price_, &delta_, &vega_, &rho_, &strikeSensitivity_, &barrierSensitivity_ };
+	for (int k = 0; k < NUM_ADJOINTS; ++k)
+	{
+		if (request & (1u << values[k]))
+		{
+			*members[k] = quantity_ * totals[k] / numScenarios_;
+			if (k != VALUE)
+			{
+				stdErrors_[values[k]] = standardError_(discountedValues.data() + k, NUM_ADJOINTS);
+			}
+		}
+	}
+	if (request & OptionResults::PRICE_ONLY)
+	{
+		stdError_ = standardError_(discountedValues.data(), NUM_ADJOINTS);
+	}
+}
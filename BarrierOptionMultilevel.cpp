@@ -0,0 +1,209 @@
+#include "BarrierOption.h"
+#include "BarrierOptionPaths.h"
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <chrono>
+#include <cstdint>
+
+using std::vector;
+using std::accumulate;
+using std::size_t;
+
+vector<unsigned> BarrierOption::multilevelGrid_() const
+{
+	unsigned steps = std::max(1u, std::min(settings_.coarsestSteps, numTimeSteps_));
+	while (numTimeSteps_ % steps != 0)
+	{
+		++steps;
+	}
+	vector<unsigned> grid(1, steps);
+	unsigned rest = numTimeSteps_ / steps;
+	for (unsigned factor = 2; rest > 1;)
+	{
+		if (rest % factor == 0)
+		{
+			steps *= factor;
+			rest /= factor;
+			grid.push_back(steps);
+		}
+		else
+		{
+			++factor;
+		}
+	}
+	return grid;
+}
+
+void BarrierOption::computeMultilevel_() const
+{
+	// Level l's scenario i draws from Philox(seed_, (l << 32) + i), so the levels are independent
+	// of one another and of the single-level scenarios.  On levels above 0 the path is simulated
+	// on the fine grid and the same path, seen every stride'th step, gives the coarse payoff:  a
+	// GBM path sampled at the coarse dates is exactly a path on the coarse grid.
+	const vector<unsigned> grid = multilevelGrid_();
+	const size_t numLevels = grid.size();
+	const double df = discFactor_(0.0, settlement_);
+	vector<vector<double> > corrections(numLevels);		// Discounted P_fine - P_coarse (P_fine on level 0)
+	vector<vector<double> > fines(numLevels);			// Discounted P_fine
+	vector<double> wallTimes(numLevels, 0.0);
+
+	auto extend = [&](size_t l, size_t numScenarios)
+	{
+		const size_t first = corrections[l].size();
+		if (numScenarios <= first)
+		{
+			return;
+		}
+		const auto begin = std::chrono::steady_clock::now();
+		corrections[l].resize(numScenarios);
+		fines[l].resize(numScenarios);
+		const EquityPriceGenerator epg = generator_(spot_, riskFreeRate_, volatility_, grid[l]);
+		const unsigned stride = (l > 0) ? grid[l] / grid[l - 1] : 1;
+		double* correction = corrections[l].data();
+		double* fine = fines[l].data();
+		withBarrierPolicy(BarrierType_, optionType_, [&](auto policy)
+		{
+			// A rebate is turned down by checkSettings_(), so the payoff never reads the fine grid's
+			// tables on the coarse path
+			typedef PolicyBarrierPayoff<decltype(policy)> Payoff;
+			const Payoff payoff(barrierLevel_, strike_, 0.0, epg.steps());
+			withPathEngine_([&](auto pathVector)
+			{
+				simulateScenarios_(first, numScenarios, runParallel_,
+					[&, l, stride, correction, fine](size_t begin, size_t end, RunStatistics::PathCounts* counts)
+				{
+					if (l == 0)
+					{
+						for (size_t i = begin; i < end; ++i)
+						{
+							PhiloxNormals normals(seed_, i);
+							Payoff path(payoff);
+							evaluatePath_<decltype(pathVector)::value>(epg, normals, path, counts);
+							fine[i] = correction[i] = df * path.payoff();
+						}
+						return;
+					}
+					for (size_t i = begin; i < end; ++i)
+					{
+						PhiloxNormals normals(seed_, (static_cast<std::uint64_t>(l) << 32) + i);
+						PathEvaluatorPair<Payoff, CoarsePath<Payoff> > paths(payoff, CoarsePath<Payoff>(payoff, stride));
+						evaluatePath_<decltype(pathVector)::value>(epg, normals, paths, counts);
+						fine[i] = df * paths.first().payoff();
+						correction[i] = fine[i] - df * paths.second().payoff();
+					}
+				});
+			});
+		});
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+		wallTimes[l] += elapsed.count();
+	};
+
+	auto moments = [](const vector<double>& x, double& mean, double& variance)
+	{
+		const size_t n = x.size();
+		mean = accumulate(x.begin(), x.end(), 0.0) / n;
+		double sumSq = 0.0;
+		for (double v : x)
+		{
+			sumSq += (v - mean) * (v - mean);
+		}
+		variance = (n > 1) ? sumSq / (n - 1.0) : 0.0;
+	};
+
+	vector<double> means(numLevels), variances(numLevels);
+	auto estimate = [&]()
+	{
+		PhaseTimer timer(statistics_(), RunStatistics::REDUCTION);
+		for (size_t l = 0; l < numLevels; ++l)
+		{
+			moments(corrections[l], means[l], variances[l]);
+		}
+	};
+
+	if (!levelSamples_.empty())
+	{
+		// A bumped revaluation:  the price run's scenarios, for common random numbers
+		for (size_t l = 0; l < numLevels; ++l)
+		{
+			extend(l, levelSamples_[l]);
+		}
+		estimate();
+	}
+	else
+	{
+		// A pilot run on every level, then the Giles allocation N_l = sqrt(V_l / C_l) sum_k sqrt(V_k C_k)
+		// / eps^2, which minimizes the cost sum_l N_l C_l for a variance sum_l V_l / N_l of eps^2.  The
+		// cost C_l of a scenario is its fine grid's steps.  If that costs more than maxScenarios_ paths
+		// at numTimeSteps_, every N_l is scaled down to fit, which is still the least variance for the
+		// cost.  The variances are estimated again after each round, until no level needs more.
+		const size_t pilot = std::max<size_t>(std::min<size_t>(settings_.batchSize, maxScenarios_), 2);
+		for (size_t l = 0; l < numLevels; ++l)
+		{
+			extend(l, pilot);
+		}
+		for (bool more = true; more;)
+		{
+			estimate();
+			double target = settings_.targetStdError / std::abs(quantity_);
+			if (settings_.targetStdError <= 0.0)
+			{
+				double mean, fineVariance;
+				moments(fines.back(), mean, fineVariance);
+				target = std::sqrt(fineVariance / maxScenarios_);
+			}
+			double sum = 0.0;
+			for (size_t l = 0; l < numLevels; ++l)
+			{
+				sum += std::sqrt(variances[l] * grid[l]);
+			}
+			const double budget = double(maxScenarios_) * numTimeSteps_;
+			const double scale = (target > 0.0) ? std::min(1.0 / (target * target), budget / (sum * sum)) : 0.0;
+
+			more = false;
+			for (size_t l = 0; l < numLevels; ++l)
+			{
+				const double wanted = std::ceil(std::sqrt(variances[l] / grid[l]) * sum * scale);
+				const size_t numScenarios = static_cast<size_t>(wanted);
+				if (numScenarios > corrections[l].size())
+				{
+					extend(l, numScenarios);
+					more = true;
+				}
+			}
+		}
+
+		levelSamples_.resize(numLevels);
+		for (size_t l = 0; l < numLevels; ++l)
+		{
+			levelSamples_[l] = corrections[l].size();
+		}
+
+		if (settings_.collectStatistics)
+		{
+			runStatistics_.levels.resize(numLevels);
+			for (size_t l = 0; l < numLevels; ++l)
+			{
+				RunStatistics::Level& level = runStatistics_.levels[l];
+				double fineMean;
+				level.fineSteps = grid[l];
+				level.coarseSteps = (l > 0) ? grid[l - 1] : 0;
+				level.scenarios = corrections[l].size();
+				level.mean = means[l];
+				level.variance = variances[l];
+				moments(fines[l], fineMean, level.fineVariance);
+				level.wallTime = wallTimes[l];
+			}
+		}
+	}
+
+	// numScenarios_ is left as given:  the scenarios run are levelSamples_'s, per level
+	double variance = 0.0;
+	for (size_t l = 0; l < numLevels; ++l)
+	{
+		variance += variances[l] / corrections[l].size();
+	}
+	price_ = quantity_ * accumulate(means.begin(), means.end(), 0.0);
+	stdError_ = std::abs(quantity_) * std::sqrt(variance);
+}
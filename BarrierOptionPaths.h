@@ -0,0 +1,247 @@
+#ifndef BARRIER_OPTION_PATHS_H
+#define BARRIER_OPTION_PATHS_H
+
+#include "BarrierOption.h"
+#include "EquityPriceGenerator.h"
+#include "BarrierPayoff.h"
+#include "RandomStreams.h"
+#include <vector>
+#include <type_traits>
+#include <cassert>
+
+// BarrierOption's scenario loop and path kernels, which are templates on the draws and the payoff:
+// included by each of its source files that runs paths (BarrierOption.cpp and the estimators split
+// out of it), not by its users.
+
+template <typename ScenarioFn>
+void BarrierOption::forEachScenario_(std::size_t begin, std::size_t end, ScenarioFn scenarioFn) const
+{
+	// With antithetic pairs, scenarios 2j and 2j + 1 both take sample j's draws, the second negated
+	const std::size_t pathsPerSample = settings_.antithetic ? 2 : 1;
+	auto run = [&scenarioFn, pathsPerSample](std::size_t i, auto& normals)
+	{
+		if (i % pathsPerSample == 1)
+		{
+			AntitheticNormals<std::remove_reference_t<decltype(normals)> > mirror(normals);
+			scenarioFn(i, mirror);
+		}
+		else
+		{
+			scenarioFn(i, normals);
+		}
+	};
+
+	if (settings_.cachePaths || normalStore_)
+	{
+		// Stored by extendPathCache_() before the run, or read in place from the store
+		for (std::size_t i = begin; i < end; ++i)
+		{
+			const std::size_t j = i / pathsPerSample;
+			StoredNormals normals(settings_.cachePaths ? &pathCache_[j * numTimeSteps_] : normalStore_->sample(j));
+			run(i, normals);
+		}
+		return;
+	}
+
+	switch (settings_.randomStream)
+	{
+	case RandomStream::PHILOX:
+		for (std::size_t i = begin; i < end; ++i)
+		{
+			PhiloxNormals normals(seed_, i / pathsPerSample);
+			run(i, normals);
+		}
+		break;
+	case RandomStream::MT19937_PER_SCENARIO:
+		for (std::size_t i = begin; i < end; ++i)
+		{
+			MersenneNormals normals(seed_ + static_cast<int>(i / pathsPerSample));
+			run(i, normals);
+		}
+		break;
+	case RandomStream::SOBOL:
+	{
+		// Samples are dealt out to the replications in turn:  sample j is point j / R of
+		// replication j % R.  A run of R samples shares one Sobol point, which the cursor keeps.
+		const unsigned numReplications = quasiRandom_->numReplications();
+		QuasiRandomNormals::Cursor cursor(*quasiRandom_);
+		std::vector<double> increments(numTimeSteps_);
+		for (std::size_t i = begin; i < end; ++i)
+		{
+			const std::size_t j = i / pathsPerSample;
+			quasiRandom_->generate(static_cast<unsigned>(j % numReplications), j / numReplications, cursor, increments.data());
+			StoredNormals normals(increments.data());
+			run(i, normals);
+		}
+		break;
+	}
+	default:
+		assert(false);
+		break;
+	}
+}
+
+template <typename Policy>
+SkeletonBarrierPayoff<Policy> BarrierOption::skeletonPayoff_(double spot, double riskFreeRate, double vol) const
+{
+	return SkeletonBarrierPayoff<Policy>(barrierLevel_, strike_, spot, riskFreeRate, vol, tau_ / numTimeSteps_,
+		numTimeSteps_);
+}
+
+template <typename Policy>
+ContinuousBarrierPayoff<Policy> BarrierOption::continuousPayoff_(double vol) const
+{
+	return ContinuousBarrierPayoff<Policy>(shiftedBarrier(BarrierType_, barrierLevel_, vol, monitoringInterval_()),
+		strike_, vol, tau_ / numTimeSteps_);
+}
+
+template <typename Policy>
+SampledBarrierPayoff<Policy> BarrierOption::sampledPayoff_(double vol, std::size_t i) const
+{
+	// Counter word 3 = 2:  a stream of its own, apart from the path normals and the QMC shifts
+	return SampledBarrierPayoff<Policy>(shiftedBarrier(BarrierType_, barrierLevel_, vol, monitoringInterval_()),
+		strike_, vol, tau_ / numTimeSteps_, PhiloxUniforms(seed_, i, 2u));
+}
+
+template <typename Policy>
+CorridorBarrierPayoff<Policy> BarrierOption::corridorPayoff_(const TimeStepTable& steps, double vol) const
+{
+	// A single barrier's corridor is open on the other side
+	double lower = Policy::up ? 0.0 : barrierLevel_;
+	double upper = Policy::up ? barrierLevel_ : upperBarrierLevel_;
+	if (vol > 0.0)
+	{
+		lower = shiftedBarrier(Barrier::DOWN_AND_OUT, lower, vol, monitoringInterval_());
+		upper = shiftedBarrier(Barrier::UP_AND_OUT, upper, vol, monitoringInterval_());
+	}
+	return CorridorBarrierPayoff<Policy>(lower, upper, strike_, rebate_, firstMonitored_, lastMonitored_, vol,
+		tau_ / numTimeSteps_, steps);
+}
+
+template <typename PriceFn>
+void BarrierOption::withPayoff_(PriceFn priceWith) const
+{
+	withBarrierPolicy(BarrierType_, optionType_, [this, &priceWith](auto policy)
+	{
+		typedef decltype(policy) Policy;
+		if (!singleBarrier_())
+		{
+			// BRIDGE_SAMPLED is turned down by checkSettings_()
+			const bool bridge = (settings_.barrierMonitoring == BarrierMonitoring::BRIDGE_WEIGHT);
+			priceWith(policy, [this, bridge](const TimeStepTable& steps, double vol, std::size_t)
+			{
+				return corridorPayoff_<Policy>(steps, bridge ? vol : 0.0);
+			});
+			return;
+		}
+
+		switch (settings_.barrierMonitoring)
+		{
+		case BarrierMonitoring::DISCRETE:
+			priceWith(policy, [this](const TimeStepTable& steps, double, std::size_t)
+			{
+				return PolicyBarrierPayoff<Policy>(barrierLevel_, strike_, rebate_, steps);
+			});
+			break;
+		case BarrierMonitoring::BRIDGE_WEIGHT:
+			priceWith(policy, [this](const TimeStepTable&, double vol, std::size_t)
+			{
+				return continuousPayoff_<Policy>(vol);
+			});
+			break;
+		case BarrierMonitoring::BRIDGE_SAMPLED:
+			priceWith(policy, [this](const TimeStepTable&, double vol, std::size_t i)
+			{
+				return sampledPayoff_<Policy>(vol, i);
+			});
+			break;
+		default:
+			assert(false);
+			break;
+		}
+	});
+}
+
+template <typename Fn>
+void BarrierOption::withPathEngine_(Fn fn) const
+{
+	switch (settings_.pathEngine)
+	{
+	case PathEngine::FUSED:
+	case PathEngine::SIMD_BATCH:	// Scenarios the batch kernel does not take (see priceScenarios_)
+		fn(std::false_type());
+		break;
+	case PathEngine::PATH_VECTOR:
+		fn(std::true_type());
+		break;
+	default:	// Put an assert here, as this should NEVER happen
+		assert(false);
+		break;
+	}
+}
+
+template <typename Policy, bool pathVector, typename NormalSource, typename Payoff>
+double BarrierOption::discountedPayoff_(const EquityPriceGenerator& epg, NormalSource& normals, Payoff payoff,
+	double df, double* control, RunStatistics::PathCounts* counts) const
+{
+	// The payoff is settled on the settlement date whether or not the option survived
+	auto controlled = [&](auto controlPayoff)
+	{
+		PathEvaluatorPair<Payoff, decltype(controlPayoff)> payoffs(payoff, controlPayoff);
+		evaluatePath_<pathVector>(epg, normals, payoffs, counts);
+		*control = df * payoffs.second().payoff();
+		return df * payoffs.first().payoff();
+	};
+
+	switch ((control != nullptr) ? settings_.controlVariate : ControlVariate::NONE)
+	{
+	case ControlVariate::ANALYTIC:
+		return controlled(continuousPayoff_<Policy>(volatility_));
+	case ControlVariate::TERMINAL_SPOT:
+		return controlled(TerminalPricePayoff());
+	default:
+		evaluatePath_<pathVector>(epg, normals, payoff, counts);
+		return df * payoff.payoff();
+	}
+}
+
+template <bool pathVector, typename NormalSource, typename PathEvaluator>
+void BarrierOption::evaluatePath_(const EquityPriceGenerator& epg, NormalSource& normals, PathEvaluator& evaluator,
+	RunStatistics::PathCounts* counts) const
+{
+	unsigned generated = 0;		// pathVector:  the time steps in the path
+	auto run = [&epg, &normals, &generated](auto& pathEvaluator)
+	{
+		if (!pathVector)
+		{
+			epg.simulate(normals, pathEvaluator);
+			return;
+		}
+
+		std::vector<double> priceVector = epg.path(normals);
+		generated = static_cast<unsigned>(priceVector.size() - 1);
+		for (double price : priceVector)
+		{
+			if (!pathEvaluator(price))
+			{
+				break;
+			}
+		}
+	};
+
+	if (counts == nullptr)
+	{
+		run(evaluator);
+		return;
+	}
+
+	// The same path, through the instrumented evaluator (the PATH_VECTOR engine generates every
+	// step, whether or not the evaluator needs them)
+	InstrumentedPath<PathEvaluator> instrumented(evaluator);
+	run(instrumented);
+	unsigned steps = pathVector ? generated : instrumented.steps();
+	counts->add(steps, instrumented.hit(), instrumented.hitStep());
+	evaluator = instrumented.evaluator();
+}
+
+#endif // !BARRIER_OPTION_PATHS_H
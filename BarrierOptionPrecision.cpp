@@ -0,0 +1,33 @@
+#include "BarrierOption.h"
+#include <vector>
+#include <algorithm>
+
+using std::vector;
+using std::size_t;
+
+void BarrierOption::checkPrecision_() const
+{
+	// The same scenarios through the batch kernel in each precision, so that the difference is the
+	// rounding of the float paths alone (it is not added to the run's path counts)
+	const size_t numScenarios = std::min<size_t>(settings_.precisionCheckScenarios, numScenarios_);
+	if (numScenarios == 0)
+	{
+		return;
+	}
+
+	PhaseTimer timer(statistics_(), RunStatistics::SIMULATION);
+	vector<double> singlePayoffs(numScenarios);
+	vector<double> doublePayoffs(numScenarios);
+	priceBatch_(batchGenerator_(Precision::SINGLE), 0, numScenarios, singlePayoffs.data(), nullptr);
+	priceBatch_(batchGenerator_(Precision::DOUBLE), 0, numScenarios, doublePayoffs.data(), nullptr);
+
+	double difference = 0.0;
+	for (size_t i = 0; i < numScenarios; ++i)
+	{
+		difference += singlePayoffs[i] - doublePayoffs[i];
+	}
+	precisionDifference_ = quantity_ * difference / numScenarios;
+	precisionScenarios_ = numScenarios;
+	runStatistics_.precisionDifference = precisionDifference_;
+	runStatistics_.precisionScenarios = numScenarios;
+}
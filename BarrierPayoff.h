@@ -0,0 +1,712 @@
+#ifndef BARRIER_PAYOFF_H
+#define BARRIER_PAYOFF_H
+
+#include "ResultSet.h"
+#include "RandomStreams.h"
+#include "RunStatistics.h"
+#include "TermStructure.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <cassert>
+
+inline bool isUpBarrier(Barrier barrierType)
+{
+	return barrierType == Barrier::UP_AND_OUT || barrierType == Barrier::UP_AND_IN;
+}
+
+inline bool isKnockIn(Barrier barrierType)
+{
+	return barrierType == Barrier::UP_AND_IN || barrierType == Barrier::DOWN_AND_IN;
+}
+
+// Whether price is at or beyond the barrier
+inline bool barrierHit(Barrier barrierType, double barrierLevel, double price)
+{
+	return isUpBarrier(barrierType) ? (price >= barrierLevel) : (price <= barrierLevel);
+}
+
+// Log distance of price from the barrier, positive on the side where the barrier has not been hit
+inline double logBarrierDistance(Barrier barrierType, double logBarrier, double price)
+{
+	double logDistance = std::log(price) - logBarrier;
+	return isUpBarrier(barrierType) ? -logDistance : logDistance;
+}
+
+// Broadie, Glasserman and Kou (1997):  a barrier monitored at dates monitoringInterval apart is
+// worth about the same as a continuously monitored one moved away from the spot by a factor
+// exp(beta vol sqrt(monitoringInterval)), beta = -zeta(1/2) / sqrt(2 pi).  A monitoringInterval
+// of 0 leaves the barrier where it is.
+const double broadieGlassermanBeta = 0.5825971579390106;
+
+inline double shiftedBarrier(Barrier barrierType, double barrierLevel, double vol, double monitoringInterval)
+{
+	double shift = std::exp(broadieGlassermanBeta * vol * std::sqrt(monitoringInterval));
+	return isUpBarrier(barrierType) ? barrierLevel * shift : barrierLevel / shift;
+}
+
+inline double vanillaPayoff(OptionType optionType, double strike, double terminalPrice)
+{
+	return (optionType == OptionType::CALL) ? std::max(terminalPrice - strike, 0.0)
+		: std::max(strike - terminalPrice, 0.0);
+}
+
+// Undiscounted payoff of a single-barrier option, given how the path ended:  a knock-out pays the
+// vanilla payoff if the barrier was never hit, a knock-in only if it was.
+inline double barrierPayoff(Barrier barrierType, OptionType optionType, double strike, double terminalPrice,
+	bool hit)
+{
+	return (hit == isKnockIn(barrierType)) ? vanillaPayoff(optionType, strike, terminalPrice) : 0.0;
+}
+
+// Barrier payoff that is fed one path price at a time, so that it can be evaluated while the
+// path is being generated (see EquityPriceGenerator::simulate(.)) as well as over a stored path.
+// The barrier is monitored at every price it is given, including the initial one; the up barriers
+// are hit at or above the barrier level, the down barriers at or below.
+class BarrierPayoff
+{
+public:
+	BarrierPayoff(Barrier barrierType, OptionType optionType, double barrierLevel, double strike) :
+		barrierType_(barrierType), optionType_(optionType), barrierLevel_(barrierLevel), strike_(strike),
+		hit_(false), lastPrice_(0.0) {}
+
+	// Returns false once a knock-out has been hit:  the payoff is then fixed (at zero) and the
+	// rest of the path need not be generated.  A knock-in always needs the terminal price.
+	bool operator()(double price)
+	{
+		if (hit_ && !isKnockIn(barrierType_))
+		{
+			return false;
+		}
+
+		lastPrice_ = price;
+		hit_ = hit_ || barrierHit(barrierType_, barrierLevel_, price);
+		return !hit_ || isKnockIn(barrierType_);
+	}
+
+	bool hit() const
+	{
+		return hit_;
+	}
+
+	// Undiscounted payoff, valid once the path has ended (or been knocked out)
+	double payoff() const
+	{
+		return barrierPayoff(barrierType_, optionType_, strike_, lastPrice_, hit_);
+	}
+
+private:
+	Barrier barrierType_;
+	OptionType optionType_;
+	double barrierLevel_;
+	double strike_;
+	bool hit_;
+	double lastPrice_;
+};
+
+// The barrier's direction and kind and the option type as template parameters:  a path kernel
+// instantiated on a policy (see withBarrierPolicy(.)) has no branch on them left in its loops.
+template <Barrier barrierType, OptionType optionType>
+struct BarrierPolicy
+{
+	static constexpr bool up = (barrierType == Barrier::UP_AND_OUT || barrierType == Barrier::UP_AND_IN);
+	static constexpr bool knockIn = (barrierType == Barrier::UP_AND_IN || barrierType == Barrier::DOWN_AND_IN);
+
+	static bool hit(double barrierLevel, double price)
+	{
+		return up ? (price >= barrierLevel) : (price <= barrierLevel);
+	}
+
+	// As logBarrierDistance(.)
+	static double logDistance(double logBarrier, double price)
+	{
+		double logDistance = std::log(price) - logBarrier;
+		return up ? -logDistance : logDistance;
+	}
+
+	static double vanilla(double strike, double terminalPrice)
+	{
+		return (optionType == OptionType::CALL) ? std::max(terminalPrice - strike, 0.0)
+			: std::max(strike - terminalPrice, 0.0);
+	}
+
+	// As barrierPayoff(.)
+	static double payoff(double strike, double terminalPrice, bool hit)
+	{
+		return (hit == knockIn) ? vanilla(strike, terminalPrice) : 0.0;
+	}
+};
+
+namespace barrier_policy_detail
+{
+	template <Barrier barrierType, typename Fn>
+	void withOptionType(OptionType optionType, Fn& fn)
+	{
+		if (optionType == OptionType::CALL)
+		{
+			fn(BarrierPolicy<barrierType, OptionType::CALL>());
+		}
+		else
+		{
+			fn(BarrierPolicy<barrierType, OptionType::PUT>());
+		}
+	}
+}
+
+// Calls fn(BarrierPolicy<barrierType, optionType>()) for the run-time barrierType and optionType:
+// the one switch on them, taken outside the path loops that fn instantiates on the policy
+template <typename Fn>
+void withBarrierPolicy(Barrier barrierType, OptionType optionType, Fn fn)
+{
+	switch (barrierType)
+	{
+	case Barrier::UP_AND_OUT:
+		barrier_policy_detail::withOptionType<Barrier::UP_AND_OUT>(optionType, fn);
+		break;
+	case Barrier::DOWN_AND_OUT:
+		barrier_policy_detail::withOptionType<Barrier::DOWN_AND_OUT>(optionType, fn);
+		break;
+	case Barrier::UP_AND_IN:
+		barrier_policy_detail::withOptionType<Barrier::UP_AND_IN>(optionType, fn);
+		break;
+	case Barrier::DOWN_AND_IN:
+		barrier_policy_detail::withOptionType<Barrier::DOWN_AND_IN>(optionType, fn);
+		break;
+	default:
+		assert(false);
+		break;
+	}
+}
+
+// BarrierPayoff with the contract fixed at compile time by Policy (a BarrierPolicy), and a cash
+// rebate as in AnalyticBarrier:  a knock-in that was never knocked in pays it at expiry, and a
+// knock-out pays it when the barrier is hit.  The latter is grown to expiry by steps' discount
+// factors, P(0, t_k) / P(0, T) for a hit at the k-th price (the initial one being the 0th), so
+// that payoff() is discounted from the settlement date like any other.  With no rebate, the
+// values are exactly those of BarrierPayoff.
+template <typename Policy>
+class PolicyBarrierPayoff
+{
+public:
+	// steps:  the path generator's tables (not owned; only read for a knock-out's rebate)
+	PolicyBarrierPayoff(double barrierLevel, double strike, double rebate, const TimeStepTable& steps) :
+		barrierLevel_(barrierLevel), strike_(strike), rebate_(rebate), steps_(&steps), prices_(0), hitStep_(0),
+		hit_(false), lastPrice_(0.0) {}
+
+	// Returns false once a knock-out has been hit
+	bool operator()(double price)
+	{
+		if (hit_ && !Policy::knockIn)
+		{
+			return false;
+		}
+
+		lastPrice_ = price;
+		if (!hit_ && Policy::hit(barrierLevel_, price))
+		{
+			hit_ = true;
+			hitStep_ = prices_;
+		}
+		++prices_;
+		return !hit_ || Policy::knockIn;
+	}
+
+	bool hit() const
+	{
+		return hit_;
+	}
+
+	double payoff() const
+	{
+		if (hit_ == Policy::knockIn)
+		{
+			return Policy::vanilla(strike_, lastPrice_);
+		}
+		if (rebate_ == 0.0 || Policy::knockIn)
+		{
+			return rebate_;
+		}
+		return rebate_ * steps_->discountFactor(hitStep_) / steps_->discountFactor(steps_->numTimeSteps());
+	}
+
+private:
+	double barrierLevel_;
+	double strike_;
+	double rebate_;
+	const TimeStepTable* steps_;
+	unsigned prices_;		// Prices seen so far
+	unsigned hitStep_;
+	bool hit_;
+	double lastPrice_;
+};
+
+// The same contract monitored continuously, for a path known only at equally spaced times.
+// Between two prices the log price is a Brownian bridge, which stays clear of the barrier with
+// probability 1 - exp(-2 ln(S1/H) ln(S2/H) / (vol^2 dt)); the product of these over the path is
+// the probability the continuous path survived.  payoff() weights the vanilla payoff by it (a
+// knock-out) or by its complement (a knock-in), so its expectation is exactly the analytic
+// (continuous-barrier) value, whatever the number of time steps.  The contract is fixed by Policy
+// (a BarrierPolicy), as for PolicyBarrierPayoff.
+template <typename Policy>
+class ContinuousBarrierPayoff
+{
+public:
+	// vol and dt:  volatility and time step of the path generator
+	ContinuousBarrierPayoff(double barrierLevel, double strike, double vol, double dt) :
+		logBarrier_(std::log(barrierLevel)), strike_(strike), twoOverVarianceStep_(2.0 / (vol * vol * dt)),
+		survival_(1.0), lastLogDistance_(0.0), lastPrice_(0.0), started_(false) {}
+
+	// Returns false once a knock-out is certainly dead
+	bool operator()(double price)
+	{
+		if (survival_ == 0.0 && !Policy::knockIn)
+		{
+			return false;
+		}
+
+		double logDistance = Policy::logDistance(logBarrier_, price);
+		if (logDistance <= 0.0)
+		{
+			survival_ = 0.0;
+		}
+		else if (started_)
+		{
+			// Far from the barrier the crossing probability is below 1e-17:  skip the exp
+			double exponent = twoOverVarianceStep_ * lastLogDistance_ * logDistance;
+			if (exponent < 40.0)
+			{
+				survival_ *= 1.0 - std::exp(-exponent);
+			}
+		}
+		started_ = true;
+		lastLogDistance_ = logDistance;
+		lastPrice_ = price;
+		return survival_ != 0.0 || Policy::knockIn;
+	}
+
+	double survival() const
+	{
+		return survival_;
+	}
+
+	// Whether the path itself has been at or beyond the barrier (not just likely to have crossed)
+	bool hit() const
+	{
+		return survival_ == 0.0;
+	}
+
+	double payoff() const
+	{
+		double weight = Policy::knockIn ? 1.0 - survival_ : survival_;
+		return weight * Policy::vanilla(strike_, lastPrice_);
+	}
+
+private:
+	double logBarrier_;
+	double strike_;
+	double twoOverVarianceStep_;	// 2 / (vol^2 dt)
+	double survival_;
+	double lastLogDistance_;
+	double lastPrice_;
+	bool started_;
+};
+
+// Double barriers and monitoring windows:  the contract is knocked out (or in) by a price at or
+// below lowerBarrier or at or above upperBarrier, either of which may be left out (as 0 and as
+// infinity), but only among prices firstMonitored, ..., lastMonitored (the initial price being
+// price 0).  With vol > 0, each step between two monitored prices is also weighted by the
+// probability that its Brownian bridge stayed inside the corridor, as ContinuousBarrierPayoff
+// does for one barrier.  By the method of images that is the sum over the integers n of
+// exp(-2 nw (nw + b - a) / v) - exp(-2 (a + nw)(b + nw) / v), where a and b are the two log
+// distances from the lower barrier, w the corridor's log width and v = vol^2 dt:  n = 0 gives 1
+// less the lower barrier's crossing probability, and the second term of n = -1 is the upper's.  The terms past
+// |n| = 3 are below exp(-32 w^2 / v) and are left out.  A rebate is paid as by
+// PolicyBarrierPayoff.  All of it is kept in a few running values, so the contract is priced in
+// the same single pass over the path as any other.  Policy (a BarrierPolicy) gives the kind, in or
+// out, and the option type; its direction is not used, the corridor having both sides.
+template <typename Policy>
+class CorridorBarrierPayoff
+{
+public:
+	// steps:  the path generator's tables (not owned; only read for a knock-out's rebate)
+	CorridorBarrierPayoff(double lowerBarrier, double upperBarrier, double strike, double rebate,
+		unsigned firstMonitored, unsigned lastMonitored, double vol, double dt, const TimeStepTable& steps) :
+		lowerBarrier_(lowerBarrier), upperBarrier_(upperBarrier), logLower_(std::log(lowerBarrier)), logUpper_(std::log(upperBarrier)),
+		strike_(strike), rebate_(rebate), firstMonitored_(firstMonitored), lastMonitored_(lastMonitored),
+		twoOverVarianceStep_((vol > 0.0) ? 2.0 / (vol * vol * dt) : 0.0), steps_(&steps), prices_(0),
+		survival_(1.0), rebateValue_(0.0), lastLogPrice_(0.0), lastPrice_(0.0) {}
+
+	// Returns false once a knock-out is certainly dead
+	bool operator()(double price)
+	{
+		if (survival_ == 0.0 && !Policy::knockIn)
+		{
+			return false;
+		}
+
+		const unsigned k = prices_++;
+		lastPrice_ = price;
+		if (k < firstMonitored_ || k > lastMonitored_)
+		{
+			return true;
+		}
+
+		const double before = survival_;
+		if (price <= lowerBarrier_ || price >= upperBarrier_)
+		{
+			survival_ = 0.0;
+		}
+		else if (twoOverVarianceStep_ > 0.0)
+		{
+			const double logPrice = std::log(price);
+			if (k > firstMonitored_)
+			{
+				survival_ *= bridgeSurvival_(lastLogPrice_, logPrice);
+			}
+			lastLogPrice_ = logPrice;
+		}
+		if (rebate_ != 0.0 && !Policy::knockIn && survival_ != before)
+		{
+			// The knock-out's rebate, paid at the k-th price and grown to expiry
+			rebateValue_ += (before - survival_) * rebate_ * steps_->discountFactor(k)
+				/ steps_->discountFactor(steps_->numTimeSteps());
+		}
+		return survival_ != 0.0 || Policy::knockIn;
+	}
+
+	double survival() const
+	{
+		return survival_;
+	}
+
+	// Whether the path itself has been at or beyond a barrier in the window
+	bool hit() const
+	{
+		return survival_ == 0.0;
+	}
+
+	double payoff() const
+	{
+		const double vanilla = Policy::vanilla(strike_, lastPrice_);
+		return Policy::knockIn ? (1.0 - survival_) * vanilla + survival_ * rebate_ : survival_ * vanilla + rebateValue_;
+	}
+
+private:
+	// Probability that the bridge between log prices x1 and x2 (both inside) stays inside
+	double bridgeSurvival_(double x1, double x2) const
+	{
+		// A left-out barrier is infinitely far away.  Far from both barriers every term is below
+		// 1e-17 (the images further out are smaller still):  skip the exps.
+		const double a = x1 - logLower_, b = x2 - logLower_;
+		const double lowerExponent = twoOverVarianceStep_ * a * b;
+		const double upperExponent = twoOverVarianceStep_ * (logUpper_ - x1) * (logUpper_ - x2);
+		if (lowerExponent >= 40.0 && upperExponent >= 40.0)
+		{
+			return 1.0;
+		}
+
+		double survival = 1.0 - std::exp(-lowerExponent) - std::exp(-upperExponent);
+		const double w = logUpper_ - logLower_;
+		if (w < std::numeric_limits<double>::infinity())
+		{
+			for (int n = 1; n <= 3; ++n)
+			{
+				const double nw = n * w;
+				survival += std::exp(-twoOverVarianceStep_ * nw * (nw + b - a))
+					+ std::exp(-twoOverVarianceStep_ * nw * (nw - b + a))
+					- std::exp(-twoOverVarianceStep_ * (a + nw) * (b + nw))
+					- std::exp(-twoOverVarianceStep_ * (nw + w - a) * (nw + w - b));
+			}
+		}
+		return std::max(survival, 0.0);
+	}
+
+	double lowerBarrier_;
+	double upperBarrier_;
+	double logLower_;		// -infinity with no lower barrier
+	double logUpper_;
+	double strike_;
+	double rebate_;
+	unsigned firstMonitored_;
+	unsigned lastMonitored_;
+	double twoOverVarianceStep_;	// 2 / (vol^2 dt), or 0 for no bridge
+	const TimeStepTable* steps_;
+	unsigned prices_;		// Prices seen so far
+	double survival_;
+	double rebateValue_;	// A knock-out's rebate so far, grown to expiry
+	double lastLogPrice_;
+	double lastPrice_;
+};
+
+// The BarrierPayoff contract over a stored Brownian skeleton instead of a generated path:
+// skeleton[k - 1] is the sum of a path's first k standard normal draws, so that after k steps
+// the log price is log(spot) + k (drift - vol^2/2) dt + vol sqrt(dt) skeleton[k - 1].  Testing
+// the barrier is then a multiply-add and compare per step, in log space and with no exp; only
+// the terminal price needs one.  The values agree with BarrierPayoff over the same draws to
+// rounding.  One of these serves every path of a market state; the contract is fixed by Policy (a
+// BarrierPolicy).
+template <typename Policy>
+class SkeletonBarrierPayoff
+{
+public:
+	// drift, vol and dt:  those of the path generator
+	SkeletonBarrierPayoff(double barrierLevel, double strike, double spot, double drift, double vol, double dt,
+		unsigned numSteps) :strike_(strike), spot_(spot), logBarrier_(std::log(barrierLevel / spot)),
+		logDrift_((drift - vol * vol / 2.0) * dt), diffusion_(vol * std::sqrt(dt)), numSteps_(numSteps),
+		hitAtStart_(Policy::hit(barrierLevel, spot)) {}
+
+	// Undiscounted payoff of the path with skeleton times sign (-1 for the antithetic path); if
+	// counts is not null, the path is counted in it
+	double operator()(const double* skeleton, double sign, RunStatistics::PathCounts* counts) const
+	{
+		const double diffusion = sign * diffusion_;
+		unsigned step = 0;
+		bool hit = hitAtStart_;
+		if (!hit && Policy::up)
+		{
+			for (step = 1; step <= numSteps_ && step * logDrift_ + diffusion * skeleton[step - 1] < logBarrier_; ++step) {}
+			hit = step <= numSteps_;
+		}
+		else if (!hit)
+		{
+			for (step = 1; step <= numSteps_ && step * logDrift_ + diffusion * skeleton[step - 1] > logBarrier_; ++step) {}
+			hit = step <= numSteps_;
+		}
+
+		// Once hit, the rest of the path does not matter:  a knock-in needs only the terminal price.
+		// It is counted as running to expiry, as a generated one does.
+		if (counts != nullptr)
+		{
+			counts->add((hit && !Policy::knockIn) ? step : numSteps_, hit, step);
+		}
+		if (hit != Policy::knockIn)
+		{
+			return 0.0;
+		}
+		double terminalPrice = spot_ * std::exp(numSteps_ * logDrift_ + diffusion * skeleton[numSteps_ - 1]);
+		return Policy::vanilla(strike_, terminalPrice);
+	}
+
+private:
+	double strike_;
+	double spot_;
+	double logBarrier_;		// log(barrier / spot)
+	double logDrift_;		// (drift - vol^2/2) dt
+	double diffusion_;		// vol sqrt(dt)
+	unsigned numSteps_;
+	bool hitAtStart_;
+};
+
+// The continuously monitored contract again, but with the crossing between two prices sampled
+// rather than averaged:  a uniform draw below the Brownian-bridge crossing probability counts as
+// a hit.  The payoff is then that of BarrierPayoff, so a knocked-out path can stop early.  The
+// draw for the interval ending at price i is uniforms(i), so that the paths of several market
+// states driven by the same uniforms (see EquityPriceGenerator::simulateCommon(.)) are comparable.
+// The contract is fixed by Policy (a BarrierPolicy).
+template <typename Policy>
+class SampledBarrierPayoff
+{
+public:
+	// vol and dt:  volatility and time step of the path generator
+	SampledBarrierPayoff(double barrierLevel, double strike, double vol, double dt, const PhiloxUniforms& uniforms) :
+		logBarrier_(std::log(barrierLevel)), strike_(strike), twoOverVarianceStep_(2.0 / (vol * vol * dt)),
+		uniforms_(uniforms), step_(0), hit_(false), lastLogDistance_(0.0), lastPrice_(0.0) {}
+
+	// Returns false once a knock-out has been hit
+	bool operator()(double price)
+	{
+		if (hit_ && !Policy::knockIn)
+		{
+			return false;
+		}
+
+		double logDistance = Policy::logDistance(logBarrier_, price);
+		if (logDistance <= 0.0)
+		{
+			hit_ = true;
+		}
+		else if (step_ > 0 && !hit_)
+		{
+			double exponent = twoOverVarianceStep_ * lastLogDistance_ * logDistance;
+			hit_ = (exponent < 40.0) && (uniforms_(step_) <= std::exp(-exponent));
+		}
+		++step_;
+		lastLogDistance_ = logDistance;
+		lastPrice_ = price;
+		return !hit_ || Policy::knockIn;
+	}
+
+	bool hit() const
+	{
+		return hit_;
+	}
+
+	double payoff() const
+	{
+		return Policy::payoff(strike_, lastPrice_, hit_);
+	}
+
+private:
+	double logBarrier_;
+	double strike_;
+	double twoOverVarianceStep_;	// 2 / (vol^2 dt)
+	PhiloxUniforms uniforms_;
+	unsigned step_;
+	bool hit_;
+	double lastLogDistance_;
+	double lastPrice_;
+};
+
+// The terminal price itself, as a payoff:  used as a control variate, since its expectation (the
+// forward) is known.  It needs every path to run to expiry.
+class TerminalPricePayoff
+{
+public:
+	TerminalPricePayoff() :lastPrice_(0.0) {}
+
+	bool operator()(double price)
+	{
+		lastPrice_ = price;
+		return true;
+	}
+
+	double payoff() const
+	{
+		return lastPrice_;
+	}
+
+private:
+	double lastPrice_;
+};
+
+// Feeds each price to two path evaluators (eg, a payoff and its control variate); the path goes
+// on while either of them still needs it
+template <typename First, typename Second>
+class PathEvaluatorPair
+{
+public:
+	PathEvaluatorPair(const First& first, const Second& second) :first_(first), second_(second),
+		firstAlive_(true), secondAlive_(true) {}
+
+	bool operator()(double price)
+	{
+		firstAlive_ = firstAlive_ && first_(price);
+		secondAlive_ = secondAlive_ && second_(price);
+		return firstAlive_ || secondAlive_;
+	}
+
+	const First& first() const
+	{
+		return first_;
+	}
+
+	const Second& second() const
+	{
+		return second_;
+	}
+
+	bool hit() const
+	{
+		return first_.hit();
+	}
+
+private:
+	First first_;
+	Second second_;
+	bool firstAlive_;
+	bool secondAlive_;
+};
+
+// Feeds every stride'th price (the initial price first) to a path evaluator:  the path as seen
+// on a grid stride times coarser, for the coupled paths of a multilevel run
+template <typename Evaluator>
+class CoarsePath
+{
+public:
+	CoarsePath(const Evaluator& evaluator, unsigned stride) :evaluator_(evaluator), stride_(stride), countdown_(0),
+		alive_(true) {}
+
+	bool operator()(double price)
+	{
+		if (countdown_ == 0)
+		{
+			alive_ = evaluator_(price);
+			countdown_ = stride_;
+		}
+		--countdown_;
+		return alive_;
+	}
+
+	const Evaluator& evaluator() const
+	{
+		return evaluator_;
+	}
+
+	double payoff() const
+	{
+		return evaluator_.payoff();
+	}
+
+	bool hit() const
+	{
+		return evaluator_.hit();
+	}
+
+private:
+	Evaluator evaluator_;
+	unsigned stride_;
+	unsigned countdown_;	// Prices until the next one passed on
+	bool alive_;
+};
+
+// Feeds each price on to a path evaluator, counting the prices and noting the time step at which
+// the evaluator's barrier was first hit (see RunStatistics).  Only used when statistics are
+// collected, so the uninstrumented kernels never pay for the counting.
+template <typename Evaluator>
+class InstrumentedPath
+{
+public:
+	explicit InstrumentedPath(const Evaluator& evaluator) :evaluator_(evaluator), prices_(0), hitStep_(0), hit_(false) {}
+
+	bool operator()(double price)
+	{
+		bool alive = evaluator_(price);
+		if (!hit_ && evaluator_.hit())
+		{
+			hit_ = true;
+			hitStep_ = prices_;
+		}
+		++prices_;
+		return alive;
+	}
+
+	const Evaluator& evaluator() const
+	{
+		return evaluator_;
+	}
+
+	// Time steps generated (the initial price is not one)
+	unsigned steps() const
+	{
+		return (prices_ > 0) ? prices_ - 1 : 0;
+	}
+
+	bool hit() const
+	{
+		return hit_;
+	}
+
+	// Time step of the first price at or beyond the barrier (0 for the initial price)
+	unsigned hitStep() const
+	{
+		return hitStep_;
+	}
+
+private:
+	Evaluator evaluator_;
+	unsigned prices_;
+	unsigned hitStep_;
+	bool hit_;
+};
+
+#endif
@@ -0,0 +1,774 @@
+#include "BatchPathGenerator.h"
+#include "RandomStreams.h"
+#include "BarrierPayoff.h"
+#include <random>
+#include <cmath>
+#include <bitset>
+#include <type_traits>
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define BATCH_X86_SIMD 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#else
+#define BATCH_X86_SIMD 0
+#endif
+
+// gcc and clang need to be told that a function may use AVX instructions (the rest of the
+// file is compiled for the baseline ISA);  MSVC accepts the intrinsics anywhere.
+#if defined(__GNUC__)
+#define TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define TARGET_AVX512 __attribute__((target("avx512f")))
+#else
+#define TARGET_AVX2
+#define TARGET_AVX512
+#endif
+
+using std::mt19937_64;
+using std::cos;
+using std::sin;
+using std::exp;
+using std::log;
+using std::sqrt;
+
+namespace
+{
+	// Box-Muller:  (u1, u2) uniform on (0, 1] -> z1 = r cos(theta), z2 = r sin(theta) with
+	// r = sqrt(-2 log(u1)) and theta = 2 pi u2.  The vector kernels evaluate log, sin and cos with
+	// the polynomials below (accurate to a few ulp) so that a whole block is transformed at once.
+	typedef void(*NormalKernel)(const double* u1, const double* u2, double* z1, double* z2, unsigned numLanes);
+
+	// One time step for the whole block:  logS += logDrift + diffusion * z, lane by lane (the lanes
+	// may be at different steps of their paths), then compare against the (log) barrier.  Returns a
+	// bit mask of the lanes at or beyond the barrier after the step.
+	template <typename Real>
+	using AdvanceKernel = unsigned(*)(Real* logS, const Real* z, const Real* logDrift, const Real* diffusion,
+		Real logBarrier, bool upBarrier, unsigned numLanes);
+
+	// The EGARCH step's constants
+	struct EgarchStep
+	{
+		double rateDt;		// drift * dt
+		double halfDt;		// dt / 2
+		double sqrtDt;
+		double alphaZero;
+		double alphaOne;
+		double gamma;
+		double beta;
+	};
+
+	// One EGARCH time step for the whole block:  with sigma = exp(h / 2), logS += rateDt - halfDt sigma^2
+	// + sigma sqrtDt z, then h = alphaZero + alphaOne (|z| + gamma z) + beta h, and the barrier compare.
+	typedef unsigned(*EgarchKernel)(double* logS, double* logVariance, const double* z, const EgarchStep& step,
+		double logBarrier, bool upBarrier, unsigned numLanes);
+
+	const double pi = 3.14159265358979323846;
+	const double ln2Hi = 6.93147180369123816490e-01;	// ln(2) split so that e * ln2Hi is exact
+	const double ln2Lo = 1.90821492927058770002e-10;
+
+	// log(m) = 2 f (1 + s/3 + s^2/5 + ...), f = (m - 1)/(m + 1), s = f^2, for m in [sqrt(1/2), sqrt(2))
+	const int numLogTerms = 11;
+	const double logSeries[numLogTerms] = { 1.0, 1.0 / 3, 1.0 / 5, 1.0 / 7, 1.0 / 9, 1.0 / 11,
+		1.0 / 13, 1.0 / 15, 1.0 / 17, 1.0 / 19, 1.0 / 21 };
+
+	// Taylor series in r^2 for sin(r)/r and cos(r) on |r| <= pi/4
+	const int numSinTerms = 9;
+	const double sinSeries[numSinTerms] = { 1.0, -1.0 / 6, 1.0 / 120, -1.0 / 5040, 1.0 / 362880,
+		-1.0 / 39916800, 1.0 / 6227020800.0, -1.0 / 1307674368000.0, 1.0 / 355687428096000.0 };
+	const int numCosTerms = 10;
+	const double cosSeries[numCosTerms] = { 1.0, -1.0 / 2, 1.0 / 24, -1.0 / 720, 1.0 / 40320,
+		-1.0 / 3628800, 1.0 / 479001600, -1.0 / 87178291200.0, 1.0 / 20922789888000.0, -1.0 / 6402373705728000.0 };
+
+	// exp(x) = 2^n exp(r), n the nearest integer to x / ln(2) and |r| <= ln(2)/2, with the Taylor
+	// series for exp(r); 2^n is built in the exponent field of n + 1023 + 2^52.  |x| is held to
+	// maxExpArgument, which keeps 2^n a normal number.
+	const int numExpTerms = 13;
+	const double expSeries[numExpTerms] = { 1.0, 1.0, 1.0 / 2, 1.0 / 6, 1.0 / 24, 1.0 / 120, 1.0 / 720,
+		1.0 / 5040, 1.0 / 40320, 1.0 / 362880, 1.0 / 3628800, 1.0 / 39916800, 1.0 / 479001600 };
+	const double log2e = 1.44269504088896340736;
+	const double maxExpArgument = 708.0;
+	const double exponentBias = 4503599627370496.0 + 1023.0;
+
+	void normalsScalar(const double* u1, const double* u2, double* z1, double* z2, unsigned numLanes)
+	{
+		for (unsigned l = 0; l < numLanes; ++l)
+		{
+			double r = sqrt(-2.0 * log(u1[l]));
+			z1[l] = r * cos(2.0 * pi * u2[l]);
+			z2[l] = r * sin(2.0 * pi * u2[l]);
+		}
+	}
+
+	template <typename Real>
+	unsigned advanceScalar(Real* logS, const Real* z, const Real* logDrift, const Real* diffusion,
+		Real logBarrier, bool upBarrier, unsigned numLanes)
+	{
+		unsigned hit = 0;
+		for (unsigned l = 0; l < numLanes; ++l)
+		{
+			logS[l] = (logS[l] + logDrift[l]) + diffusion[l] * z[l];
+			if (upBarrier ? (logS[l] >= logBarrier) : (logS[l] <= logBarrier))
+			{
+				hit |= 1u << l;
+			}
+		}
+		return hit;
+	}
+
+	unsigned advanceEgarchScalar(double* logS, double* logVariance, const double* z, const EgarchStep& step,
+		double logBarrier, bool upBarrier, unsigned numLanes)
+	{
+		unsigned hit = 0;
+		for (unsigned l = 0; l < numLanes; ++l)
+		{
+			const double vol = exp(0.5 * logVariance[l]);
+			logS[l] = (logS[l] + (step.rateDt - step.halfDt * (vol * vol))) + (vol * step.sqrtDt) * z[l];
+			logVariance[l] = step.alphaZero + step.alphaOne * (std::abs(z[l]) + step.gamma * z[l]) + step.beta * logVariance[l];
+			if (upBarrier ? (logS[l] >= logBarrier) : (logS[l] <= logBarrier))
+			{
+				hit |= 1u << l;
+			}
+		}
+		return hit;
+	}
+
+#if BATCH_X86_SIMD
+	// ---- AVX2 + FMA:  4 doubles per register ----
+
+	TARGET_AVX2 inline __m256d hornerAvx2(__m256d x, const double* c, int n)
+	{
+		__m256d p = _mm256_set1_pd(c[n - 1]);
+		for (int k = n - 2; k >= 0; --k)
+		{
+			p = _mm256_fmadd_pd(p, x, _mm256_set1_pd(c[k]));
+		}
+		return p;
+	}
+
+	TARGET_AVX2 void normalsAvx2(const double* u1, const double* u2, double* z1, double* z2, unsigned numLanes)
+	{
+		const __m256d one = _mm256_set1_pd(1.0);
+		const __m256d twoTo52 = _mm256_set1_pd(4503599627370496.0);
+		const __m256i mantissaMask = _mm256_set1_epi64x(0x000FFFFFFFFFFFFFLL);
+		const __m256i signMask = _mm256_set1_epi64x(static_cast<long long>(0x8000000000000000ULL));
+
+		for (unsigned l = 0; l < numLanes; l += 4)
+		{
+			// log(u1):  split u1 = m * 2^e, then fold m into [sqrt(1/2), sqrt(2))
+			__m256i bits = _mm256_castpd_si256(_mm256_loadu_pd(u1 + l));
+			__m256i expField = _mm256_srli_epi64(bits, 52);
+			__m256d e = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(expField, _mm256_castpd_si256(twoTo52))), twoTo52);
+			e = _mm256_sub_pd(e, _mm256_set1_pd(1023.0));
+			__m256d m = _mm256_castsi256_pd(_mm256_or_si256(_mm256_and_si256(bits, mantissaMask), _mm256_castpd_si256(one)));
+			__m256d big = _mm256_cmp_pd(m, _mm256_set1_pd(1.4142135623730951), _CMP_GT_OQ);
+			m = _mm256_blendv_pd(m, _mm256_mul_pd(m, _mm256_set1_pd(0.5)), big);
+			e = _mm256_add_pd(e, _mm256_and_pd(big, one));
+
+			__m256d f = _mm256_div_pd(_mm256_sub_pd(m, one), _mm256_add_pd(m, one));
+			__m256d logM = _mm256_mul_pd(_mm256_add_pd(f, f), hornerAvx2(_mm256_mul_pd(f, f), logSeries, numLogTerms));
+			__m256d logU = _mm256_fmadd_pd(e, _mm256_set1_pd(ln2Hi), _mm256_fmadd_pd(e, _mm256_set1_pd(ln2Lo), logM));
+			__m256d radius = _mm256_sqrt_pd(_mm256_mul_pd(_mm256_set1_pd(-2.0), logU));
+
+			// sin and cos of 2 pi u2:  w = 4 u2 in quarter turns, q = nearest quarter, r in [-pi/4, pi/4]
+			__m256d w = _mm256_mul_pd(_mm256_loadu_pd(u2 + l), _mm256_set1_pd(4.0));
+			__m256d q = _mm256_round_pd(w, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+			__m256d r = _mm256_mul_pd(_mm256_sub_pd(w, q), _mm256_set1_pd(pi / 2.0));
+			__m256d r2 = _mm256_mul_pd(r, r);
+			__m256d sinR = _mm256_mul_pd(r, hornerAvx2(r2, sinSeries, numSinTerms));
+			__m256d cosR = hornerAvx2(r2, cosSeries, numCosTerms);
+
+			// Quadrant q mod 4 = 0, 1, 2, 3:  (sin, cos) = (s, c), (c, -s), (-s, -c), (-c, s)
+			__m256d quadrant = _mm256_sub_pd(q, _mm256_mul_pd(_mm256_set1_pd(4.0),
+				_mm256_floor_pd(_mm256_mul_pd(q, _mm256_set1_pd(0.25)))));
+			__m256d odd = _mm256_cmp_pd(_mm256_sub_pd(quadrant, _mm256_mul_pd(_mm256_set1_pd(2.0),
+				_mm256_floor_pd(_mm256_mul_pd(quadrant, _mm256_set1_pd(0.5))))), one, _CMP_EQ_OQ);
+			__m256d negateSin = _mm256_cmp_pd(quadrant, _mm256_set1_pd(2.0), _CMP_GE_OQ);
+			__m256d negateCos = _mm256_cmp_pd(_mm256_andnot_pd(_mm256_castsi256_pd(signMask),
+				_mm256_sub_pd(quadrant, _mm256_set1_pd(1.5))), one, _CMP_LT_OQ);
+
+			__m256d sinTheta = _mm256_blendv_pd(sinR, cosR, odd);
+			__m256d cosTheta = _mm256_blendv_pd(cosR, sinR, odd);
+			sinTheta = _mm256_xor_pd(sinTheta, _mm256_and_pd(negateSin, _mm256_castsi256_pd(signMask)));
+			cosTheta = _mm256_xor_pd(cosTheta, _mm256_and_pd(negateCos, _mm256_castsi256_pd(signMask)));
+
+			_mm256_storeu_pd(z1 + l, _mm256_mul_pd(radius, cosTheta));
+			_mm256_storeu_pd(z2 + l, _mm256_mul_pd(radius, sinTheta));
+		}
+	}
+
+	TARGET_AVX2 unsigned advanceAvx2(double* logS, const double* z, const double* logDrift, const double* diffusion,
+		double logBarrier, bool upBarrier, unsigned numLanes)
+	{
+		const __m256d barrier = _mm256_set1_pd(logBarrier);
+
+		unsigned hit = 0;
+		for (unsigned l = 0; l < numLanes; l += 4)
+		{
+			__m256d x = _mm256_add_pd(_mm256_loadu_pd(logS + l), _mm256_loadu_pd(logDrift + l));
+			x = _mm256_fmadd_pd(_mm256_loadu_pd(z + l), _mm256_loadu_pd(diffusion + l), x);
+			_mm256_storeu_pd(logS + l, x);
+
+			__m256d crossed = upBarrier ? _mm256_cmp_pd(x, barrier, _CMP_GE_OQ) : _mm256_cmp_pd(x, barrier, _CMP_LE_OQ);
+			hit |= static_cast<unsigned>(_mm256_movemask_pd(crossed)) << l;
+		}
+		return hit;
+	}
+
+	// 8 floats per register
+	TARGET_AVX2 unsigned advanceSingleAvx2(float* logS, const float* z, const float* logDrift, const float* diffusion,
+		float logBarrier, bool upBarrier, unsigned numLanes)
+	{
+		const __m256 barrier = _mm256_set1_ps(logBarrier);
+
+		unsigned hit = 0;
+		for (unsigned l = 0; l < numLanes; l += 8)
+		{
+			__m256 x = _mm256_add_ps(_mm256_loadu_ps(logS + l), _mm256_loadu_ps(logDrift + l));
+			x = _mm256_fmadd_ps(_mm256_loadu_ps(z + l), _mm256_loadu_ps(diffusion + l), x);
+			_mm256_storeu_ps(logS + l, x);
+
+			__m256 crossed = upBarrier ? _mm256_cmp_ps(x, barrier, _CMP_GE_OQ) : _mm256_cmp_ps(x, barrier, _CMP_LE_OQ);
+			hit |= static_cast<unsigned>(_mm256_movemask_ps(crossed)) << l;
+		}
+		return hit;
+	}
+
+	TARGET_AVX2 inline __m256d expAvx2(__m256d x)
+	{
+		x = _mm256_max_pd(_mm256_min_pd(x, _mm256_set1_pd(maxExpArgument)), _mm256_set1_pd(-maxExpArgument));
+		__m256d n = _mm256_round_pd(_mm256_mul_pd(x, _mm256_set1_pd(log2e)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+		__m256d r = _mm256_fnmadd_pd(n, _mm256_set1_pd(ln2Lo), _mm256_fnmadd_pd(n, _mm256_set1_pd(ln2Hi), x));
+		__m256i twoToN = _mm256_slli_epi64(_mm256_castpd_si256(_mm256_add_pd(n, _mm256_set1_pd(exponentBias))), 52);
+		return _mm256_mul_pd(hornerAvx2(r, expSeries, numExpTerms), _mm256_castsi256_pd(twoToN));
+	}
+
+	TARGET_AVX2 unsigned advanceEgarchAvx2(double* logS, double* logVariance, const double* z, const EgarchStep& step,
+		double logBarrier, bool upBarrier, unsigned numLanes)
+	{
+		const __m256d signMask = _mm256_set1_pd(-0.0);
+		const __m256d barrier = _mm256_set1_pd(logBarrier);
+
+		unsigned hit = 0;
+		for (unsigned l = 0; l < numLanes; l += 4)
+		{
+			__m256d h = _mm256_loadu_pd(logVariance + l);
+			__m256d zl = _mm256_loadu_pd(z + l);
+			__m256d vol = expAvx2(_mm256_mul_pd(h, _mm256_set1_pd(0.5)));
+
+			__m256d mu = _mm256_fnmadd_pd(_mm256_mul_pd(vol, vol), _mm256_set1_pd(step.halfDt), _mm256_set1_pd(step.rateDt));
+			__m256d x = _mm256_add_pd(_mm256_loadu_pd(logS + l), mu);
+			x = _mm256_fmadd_pd(zl, _mm256_mul_pd(vol, _mm256_set1_pd(step.sqrtDt)), x);
+			_mm256_storeu_pd(logS + l, x);
+
+			__m256d shock = _mm256_fmadd_pd(_mm256_set1_pd(step.gamma), zl, _mm256_andnot_pd(signMask, zl));
+			h = _mm256_fmadd_pd(_mm256_set1_pd(step.beta), h,
+				_mm256_fmadd_pd(_mm256_set1_pd(step.alphaOne), shock, _mm256_set1_pd(step.alphaZero)));
+			_mm256_storeu_pd(logVariance + l, h);
+
+			__m256d crossed = upBarrier ? _mm256_cmp_pd(x, barrier, _CMP_GE_OQ) : _mm256_cmp_pd(x, barrier, _CMP_LE_OQ);
+			hit |= static_cast<unsigned>(_mm256_movemask_pd(crossed)) << l;
+		}
+		return hit;
+	}
+
+	// ---- AVX-512F:  8 doubles per register (only F instructions, so no DQ double logic ops) ----
+
+	// Every lane of the zero-masked forms below, which (unlike the plain ones) do not start from an
+	// undefined register
+	const __mmask8 allLanes = 0xFF;
+
+	TARGET_AVX512 inline __m512d hornerAvx512(__m512d x, const double* c, int n)
+	{
+		__m512d p = _mm512_set1_pd(c[n - 1]);
+		for (int k = n - 2; k >= 0; --k)
+		{
+			p = _mm512_fmadd_pd(p, x, _mm512_set1_pd(c[k]));
+		}
+		return p;
+	}
+
+	TARGET_AVX512 void normalsAvx512(const double* u1, const double* u2, double* z1, double* z2, unsigned numLanes)
+	{
+		const __m512d one = _mm512_set1_pd(1.0);
+		const __m512d twoTo52 = _mm512_set1_pd(4503599627370496.0);
+		const __m512i mantissaMask = _mm512_set1_epi64(0x000FFFFFFFFFFFFFLL);
+		const __m512i signMask = _mm512_set1_epi64(static_cast<long long>(0x8000000000000000ULL));
+
+		for (unsigned l = 0; l < numLanes; l += 8)
+		{
+			__m512i bits = _mm512_castpd_si512(_mm512_loadu_pd(u1 + l));
+			__m512i expField = _mm512_maskz_srli_epi64(allLanes, bits, 52);
+			__m512d e = _mm512_sub_pd(_mm512_castsi512_pd(_mm512_or_si512(expField, _mm512_castpd_si512(twoTo52))), twoTo52);
+			e = _mm512_sub_pd(e, _mm512_set1_pd(1023.0));
+			__m512d m = _mm512_castsi512_pd(_mm512_or_si512(_mm512_and_si512(bits, mantissaMask), _mm512_castpd_si512(one)));
+			__mmask8 big = _mm512_cmp_pd_mask(m, _mm512_set1_pd(1.4142135623730951), _CMP_GT_OQ);
+			m = _mm512_mask_mul_pd(m, big, m, _mm512_set1_pd(0.5));
+			e = _mm512_mask_add_pd(e, big, e, one);
+
+			__m512d f = _mm512_div_pd(_mm512_sub_pd(m, one), _mm512_add_pd(m, one));
+			__m512d logM = _mm512_mul_pd(_mm512_add_pd(f, f), hornerAvx512(_mm512_mul_pd(f, f), logSeries, numLogTerms));
+			__m512d logU = _mm512_fmadd_pd(e, _mm512_set1_pd(ln2Hi), _mm512_fmadd_pd(e, _mm512_set1_pd(ln2Lo), logM));
+			__m512d radius = _mm512_maskz_sqrt_pd(allLanes, _mm512_mul_pd(_mm512_set1_pd(-2.0), logU));
+
+			__m512d w = _mm512_mul_pd(_mm512_loadu_pd(u2 + l), _mm512_set1_pd(4.0));
+			__m512d q = _mm512_maskz_roundscale_pd(allLanes, w, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+			__m512d r = _mm512_mul_pd(_mm512_sub_pd(w, q), _mm512_set1_pd(pi / 2.0));
+			__m512d r2 = _mm512_mul_pd(r, r);
+			__m512d sinR = _mm512_mul_pd(r, hornerAvx512(r2, sinSeries, numSinTerms));
+			__m512d cosR = hornerAvx512(r2, cosSeries, numCosTerms);
+
+			__m512d quadrant = _mm512_sub_pd(q, _mm512_mul_pd(_mm512_set1_pd(4.0),
+				_mm512_maskz_roundscale_pd(allLanes, _mm512_mul_pd(q, _mm512_set1_pd(0.25)), _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC)));
+			__mmask8 odd = _mm512_cmp_pd_mask(_mm512_sub_pd(quadrant, _mm512_mul_pd(_mm512_set1_pd(2.0),
+				_mm512_maskz_roundscale_pd(allLanes, _mm512_mul_pd(quadrant, _mm512_set1_pd(0.5)), _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC))),
+				one, _CMP_EQ_OQ);
+			__mmask8 negateSin = _mm512_cmp_pd_mask(quadrant, _mm512_set1_pd(2.0), _CMP_GE_OQ);
+			__mmask8 negateCos = _mm512_cmp_pd_mask(quadrant, one, _CMP_EQ_OQ) | _mm512_cmp_pd_mask(quadrant, _mm512_set1_pd(2.0), _CMP_EQ_OQ);
+
+			__m512d sinTheta = _mm512_mask_blend_pd(odd, sinR, cosR);
+			__m512d cosTheta = _mm512_mask_blend_pd(odd, cosR, sinR);
+			sinTheta = _mm512_castsi512_pd(_mm512_mask_xor_epi64(_mm512_castpd_si512(sinTheta), negateSin,
+				_mm512_castpd_si512(sinTheta), signMask));
+			cosTheta = _mm512_castsi512_pd(_mm512_mask_xor_epi64(_mm512_castpd_si512(cosTheta), negateCos,
+				_mm512_castpd_si512(cosTheta), signMask));
+
+			_mm512_storeu_pd(z1 + l, _mm512_mul_pd(radius, cosTheta));
+			_mm512_storeu_pd(z2 + l, _mm512_mul_pd(radius, sinTheta));
+		}
+	}
+
+	TARGET_AVX512 unsigned advanceAvx512(double* logS, const double* z, const double* logDrift, const double* diffusion,
+		double logBarrier, bool upBarrier, unsigned numLanes)
+	{
+		const __m512d barrier = _mm512_set1_pd(logBarrier);
+
+		unsigned hit = 0;
+		for (unsigned l = 0; l < numLanes; l += 8)
+		{
+			__m512d x = _mm512_add_pd(_mm512_loadu_pd(logS + l), _mm512_loadu_pd(logDrift + l));
+			x = _mm512_fmadd_pd(_mm512_loadu_pd(z + l), _mm512_loadu_pd(diffusion + l), x);
+			_mm512_storeu_pd(logS + l, x);
+
+			__mmask8 crossed = upBarrier ? _mm512_cmp_pd_mask(x, barrier, _CMP_GE_OQ) : _mm512_cmp_pd_mask(x, barrier, _CMP_LE_OQ);
+			hit |= static_cast<unsigned>(crossed) << l;
+		}
+		return hit;
+	}
+
+	// 16 floats per register
+	TARGET_AVX512 unsigned advanceSingleAvx512(float* logS, const float* z, const float* logDrift, const float* diffusion,
+		float logBarrier, bool upBarrier, unsigned numLanes)
+	{
+		const __m512 barrier = _mm512_set1_ps(logBarrier);
+
+		unsigned hit = 0;
+		for (unsigned l = 0; l < numLanes; l += 16)
+		{
+			__m512 x = _mm512_add_ps(_mm512_loadu_ps(logS + l), _mm512_loadu_ps(logDrift + l));
+			x = _mm512_fmadd_ps(_mm512_loadu_ps(z + l), _mm512_loadu_ps(diffusion + l), x);
+			_mm512_storeu_ps(logS + l, x);
+
+			__mmask16 crossed = upBarrier ? _mm512_cmp_ps_mask(x, barrier, _CMP_GE_OQ) : _mm512_cmp_ps_mask(x, barrier, _CMP_LE_OQ);
+			hit |= static_cast<unsigned>(crossed) << l;
+		}
+		return hit;
+	}
+
+	TARGET_AVX512 inline __m512d expAvx512(__m512d x)
+	{
+		x = _mm512_maskz_max_pd(allLanes, _mm512_maskz_min_pd(allLanes, x, _mm512_set1_pd(maxExpArgument)), _mm512_set1_pd(-maxExpArgument));
+		__m512d n = _mm512_maskz_roundscale_pd(allLanes, _mm512_mul_pd(x, _mm512_set1_pd(log2e)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+		__m512d r = _mm512_fnmadd_pd(n, _mm512_set1_pd(ln2Lo), _mm512_fnmadd_pd(n, _mm512_set1_pd(ln2Hi), x));
+		__m512i twoToN = _mm512_maskz_slli_epi64(allLanes, _mm512_castpd_si512(_mm512_add_pd(n, _mm512_set1_pd(exponentBias))), 52);
+		return _mm512_mul_pd(hornerAvx512(r, expSeries, numExpTerms), _mm512_castsi512_pd(twoToN));
+	}
+
+	TARGET_AVX512 unsigned advanceEgarchAvx512(double* logS, double* logVariance, const double* z, const EgarchStep& step,
+		double logBarrier, bool upBarrier, unsigned numLanes)
+	{
+		const __m512d barrier = _mm512_set1_pd(logBarrier);
+
+		unsigned hit = 0;
+		for (unsigned l = 0; l < numLanes; l += 8)
+		{
+			__m512d h = _mm512_loadu_pd(logVariance + l);
+			__m512d zl = _mm512_loadu_pd(z + l);
+			__m512d vol = expAvx512(_mm512_mul_pd(h, _mm512_set1_pd(0.5)));
+
+			__m512d mu = _mm512_fnmadd_pd(_mm512_mul_pd(vol, vol), _mm512_set1_pd(step.halfDt), _mm512_set1_pd(step.rateDt));
+			__m512d x = _mm512_add_pd(_mm512_loadu_pd(logS + l), mu);
+			x = _mm512_fmadd_pd(zl, _mm512_mul_pd(vol, _mm512_set1_pd(step.sqrtDt)), x);
+			_mm512_storeu_pd(logS + l, x);
+
+			__m512d shock = _mm512_fmadd_pd(_mm512_set1_pd(step.gamma), zl, _mm512_abs_pd(zl));
+			h = _mm512_fmadd_pd(_mm512_set1_pd(step.beta), h,
+				_mm512_fmadd_pd(_mm512_set1_pd(step.alphaOne), shock, _mm512_set1_pd(step.alphaZero)));
+			_mm512_storeu_pd(logVariance + l, h);
+
+			__mmask8 crossed = upBarrier ? _mm512_cmp_pd_mask(x, barrier, _CMP_GE_OQ) : _mm512_cmp_pd_mask(x, barrier, _CMP_LE_OQ);
+			hit |= static_cast<unsigned>(crossed) << l;
+		}
+		return hit;
+	}
+#endif
+
+	// The advance kernel for Real:  the double ones above, or their float counterparts
+	template <typename Real>
+	AdvanceKernel<Real> advanceKernel(BatchPathGenerator::Kernel kernel);
+
+	template <>
+	AdvanceKernel<double> advanceKernel<double>(BatchPathGenerator::Kernel kernel)
+	{
+#if BATCH_X86_SIMD
+		if (kernel == BatchPathGenerator::Kernel::AVX2)
+		{
+			return advanceAvx2;
+		}
+		if (kernel == BatchPathGenerator::Kernel::AVX512)
+		{
+			return advanceAvx512;
+		}
+#endif
+		return advanceScalar<double>;
+	}
+
+	template <>
+	AdvanceKernel<float> advanceKernel<float>(BatchPathGenerator::Kernel kernel)
+	{
+#if BATCH_X86_SIMD
+		if (kernel == BatchPathGenerator::Kernel::AVX2)
+		{
+			return advanceSingleAvx2;
+		}
+		if (kernel == BatchPathGenerator::Kernel::AVX512)
+		{
+			return advanceSingleAvx512;
+		}
+#endif
+		return advanceScalar<float>;
+	}
+}
+
+BatchPathGenerator::BatchPathGenerator(double initEquityPrice, unsigned numTimeSteps, double timeToMaturity,
+	double drift, double volatility, RandomStream randomStream, Kernel kernel, Precision precision)
+	:BatchPathGenerator(initEquityPrice, numTimeSteps, timeToMaturity, TermStructure(drift, volatility), randomStream,
+	kernel, precision) {}
+
+BatchPathGenerator::BatchPathGenerator(double initEquityPrice, unsigned numTimeSteps, double timeToMaturity,
+	const TermStructure& termStructure, RandomStream randomStream, Kernel kernel, Precision precision)
+	:initEquityPrice_(initEquityPrice),
+	numTimeSteps_(numTimeSteps), steps_(std::make_shared<const TimeStepTable>(termStructure, timeToMaturity, numTimeSteps)),
+	rateDt_(0.0), dt_(timeToMaturity / numTimeSteps), initLogVariance_(0.0),
+	randomStream_(randomStream), kernel_(kernel), precision_(precision)
+{
+#if !BATCH_X86_SIMD
+	kernel_ = Kernel::SCALAR;		// No vector kernels on this architecture
+#endif
+}
+
+BatchPathGenerator::BatchPathGenerator(double initEquityPrice, unsigned numTimeSteps, double timeToMaturity, double drift,
+	double initVolatility, std::shared_ptr<const Egarch> egarch, RandomStream randomStream, Kernel kernel)
+	:BatchPathGenerator(initEquityPrice, numTimeSteps, timeToMaturity, drift, initVolatility, randomStream, kernel)
+{
+	egarch_ = std::move(egarch);
+	rateDt_ = drift * dt_;
+	initLogVariance_ = log(initVolatility * initVolatility);
+}
+
+BatchPathGenerator::Kernel BatchPathGenerator::bestKernel()
+{
+#if BATCH_X86_SIMD
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] >= 7)
+	{
+		__cpuidex(info, 1, 0);
+		bool osxsave = (info[2] & (1 << 27)) != 0;
+		bool fma = (info[2] & (1 << 12)) != 0;
+		unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;		// Registers the OS saves on a context switch
+
+		__cpuidex(info, 7, 0);
+		bool avx2 = (info[1] & (1 << 5)) != 0;
+		bool avx512f = (info[1] & (1 << 16)) != 0;
+
+		if (avx512f && (xcr0 & 0xE6) == 0xE6)
+		{
+			return Kernel::AVX512;
+		}
+		if (avx2 && fma && (xcr0 & 0x6) == 0x6)
+		{
+			return Kernel::AVX2;
+		}
+	}
+#else
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f"))
+	{
+		return Kernel::AVX512;
+	}
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+	{
+		return Kernel::AVX2;
+	}
+#endif
+#endif
+	return Kernel::SCALAR;
+}
+
+BatchPathGenerator::Kernel BatchPathGenerator::kernel() const
+{
+	return kernel_;
+}
+
+Precision BatchPathGenerator::precision() const
+{
+	return precision_;
+}
+
+unsigned BatchPathGenerator::lanes() const
+{
+	const unsigned doubleLanes = (kernel_ == Kernel::AVX512) ? 16 : 8;
+	return (precision_ == Precision::SINGLE) ? 2 * doubleLanes : doubleLanes;
+}
+
+unsigned long long BatchPathGenerator::simulate(int seed, std::size_t firstScenario, unsigned numPaths, Barrier barrierType,
+	double barrierLevel, double* terminalPrices, bool* hitBarrier) const
+{
+	if (precision_ == Precision::SINGLE)
+	{
+		return simulate_<float>(seed, firstScenario, numPaths, barrierType, barrierLevel, terminalPrices, hitBarrier);
+	}
+	return simulate_<double>(seed, firstScenario, numPaths, barrierType, barrierLevel, terminalPrices, hitBarrier);
+}
+
+void BatchPathGenerator::philoxNormals(int seed, std::size_t scenario, unsigned numSteps, double* draws, Kernel kernel)
+{
+	NormalKernel normals = normalsScalar;
+#if BATCH_X86_SIMD
+	if (kernel == Kernel::AVX2)
+	{
+		normals = normalsAvx2;
+	}
+	else if (kernel == Kernel::AVX512)
+	{
+		normals = normalsAvx512;
+	}
+#endif
+
+	// maxLanes step pairs at a time;  the pairs past the last step are transformed but not kept
+	const PhiloxNormals stream(seed, scenario);
+	double u1[maxLanes];
+	double u2[maxLanes];
+	double z1[maxLanes];
+	double z2[maxLanes];
+	const unsigned numPairs = (numSteps + 1) / 2;
+	for (unsigned first = 0; first < numPairs; first += maxLanes)
+	{
+		const unsigned count = std::min(numPairs - first, static_cast<unsigned>(maxLanes));
+		for (unsigned l = 0; l < maxLanes; ++l)
+		{
+			u1[l] = 1.0;
+			u2[l] = 0.0;
+		}
+		for (unsigned l = 0; l < count; ++l)
+		{
+			stream.uniforms(first + l, u1[l], u2[l]);
+		}
+		normals(u1, u2, z1, z2, maxLanes);
+		for (unsigned l = 0; l < count; ++l)
+		{
+			const unsigned step = 2 * (first + l);
+			draws[step] = z1[l];
+			if (step + 1 < numSteps)
+			{
+				draws[step + 1] = z2[l];
+			}
+		}
+	}
+}
+
+template <typename Real>
+unsigned long long BatchPathGenerator::simulate_(int seed, std::size_t firstScenario, unsigned numPaths, Barrier barrierType,
+	double barrierLevel, double* terminalPrices, bool* hitBarrier) const
+{
+	const unsigned numLanes = lanes();
+
+	NormalKernel normals = normalsScalar;
+	const AdvanceKernel<Real> advance = advanceKernel<Real>(kernel_);
+	EgarchKernel advanceEgarch = advanceEgarchScalar;
+#if BATCH_X86_SIMD
+	if (kernel_ == Kernel::AVX2)
+	{
+		normals = normalsAvx2;
+		advanceEgarch = advanceEgarchAvx2;
+	}
+	else if (kernel_ == Kernel::AVX512)
+	{
+		normals = normalsAvx512;
+		advanceEgarch = advanceEgarchAvx512;
+	}
+#endif
+	EgarchStep egarchStep = {};
+	if (egarch_)
+	{
+		egarchStep = EgarchStep{ rateDt_, 0.5 * dt_, sqrt(dt_), egarch_->alphaZero(), egarch_->alphaOne(),
+			egarch_->gamma(), egarch_->beta() };
+	}
+
+	const bool upBarrier = isUpBarrier(barrierType);
+	const bool knockIn = isKnockIn(barrierType);
+	const double logBarrier = log(barrierLevel);
+	const double logSpot = log(initEquityPrice_);
+	const bool startsKnocked = upBarrier ? (logSpot >= logBarrier) : (logSpot <= logBarrier);
+
+	// In double the lanes hold log prices;  in float, log returns from the initial price, so that a
+	// step's rounding is relative to the move so far rather than to log(price)
+	const bool single = std::is_same<Real, float>::value;
+	const Real* logDrifts = steps_->logDriftsIn<Real>();
+	const Real* diffusions = steps_->diffusionsIn<Real>();
+	const Real laneBarrier = static_cast<Real>(single ? logBarrier - logSpot : logBarrier);
+
+	// Structure-of-arrays state for the block.  Each lane runs one scenario at a time and takes the
+	// next one as soon as its path is done, so a knock-out block does not wait for its longest-lived
+	// lane.  Box-Muller gives two normals per pair of uniforms, so the transform runs on every other
+	// step and the second set is kept for the next;  lanes only take a new scenario on a transform
+	// step, so every lane's own steps stay paired.  The normals are drawn in double whatever Real is.
+	Real logS[maxLanes];
+	double logVariance[maxLanes];	// EGARCH only
+	double u1[maxLanes];
+	double u2[maxLanes];
+	double draws[maxLanes];
+	double drawsNext[maxLanes];
+	Real z[maxLanes];
+	Real logDrift[maxLanes];		// Of each lane's current step (an idle lane's is step 0's, but it is masked out)
+	Real diffusion[maxLanes];
+	std::size_t scenario[maxLanes];	// Relative to firstScenario
+	unsigned laneStep[maxLanes];	// Steps the lane's path has taken
+	mt19937_64 engines[maxLanes];	// Only for RandomStream::MT19937_PER_SCENARIO
+	const bool philox = (randomStream_ == RandomStream::PHILOX);
+
+	for (unsigned l = 0; l < maxLanes; ++l)
+	{
+		logS[l] = static_cast<Real>(single ? 0.0 : logSpot);
+		logVariance[l] = initLogVariance_;
+		u1[l] = 1.0;		// Idle lanes:  u1 = 1 gives z = 0
+		u2[l] = 0.0;
+		laneStep[l] = 0;	// Idle lanes step with z = 0 and step 0's drift, and are masked out of the results
+	}
+
+	// The barrier applies to the initial price as well:  if the spot is already through it, a
+	// knock-out has no path to simulate
+	if (numTimeSteps_ == 0 || (startsKnocked && !knockIn))
+	{
+		for (unsigned i = 0; i < numPaths; ++i)
+		{
+			terminalPrices[i] = initEquityPrice_;
+			hitBarrier[i] = startsKnocked;
+		}
+		return 0;
+	}
+
+	unsigned active = 0;		// Lanes running a path
+	unsigned knocked = 0;		// Active lanes whose path has hit the barrier
+	std::size_t nextScenario = 0;
+	unsigned long long pathSteps = 0;
+	bool transformStep = true;
+
+	while (active != 0 || nextScenario < numPaths)
+	{
+		if (transformStep)
+		{
+			// Free lanes take the next scenarios
+			for (unsigned l = 0; l < numLanes && nextScenario < numPaths; ++l)
+			{
+				if ((active >> l) & 1u)
+				{
+					continue;
+				}
+				scenario[l] = nextScenario++;
+				logS[l] = static_cast<Real>(single ? 0.0 : logSpot);
+				logVariance[l] = initLogVariance_;
+				if (!philox)
+				{
+					engines[l].seed(seed + static_cast<int>(firstScenario + scenario[l]));
+				}
+				active |= 1u << l;
+				knocked |= startsKnocked ? (1u << l) : 0u;
+			}
+
+			// Draw only for the active lanes;  idle lanes keep u1 = 1 and so z = 0.
+			for (unsigned l = 0; l < numLanes; ++l)
+			{
+				if (((active >> l) & 1u) && philox)
+				{
+					PhiloxNormals(seed, firstScenario + scenario[l]).uniforms(laneStep[l] / 2, u1[l], u2[l]);
+				}
+				else if ((active >> l) & 1u)
+				{
+					u1[l] = uniformFromBits(engines[l]());
+					u2[l] = uniformFromBits(engines[l]());
+				}
+				else
+				{
+					u1[l] = 1.0;
+				}
+			}
+			normals(u1, u2, draws, drawsNext, numLanes);
+		}
+		else
+		{
+			for (unsigned l = 0; l < numLanes; ++l)
+			{
+				draws[l] = drawsNext[l];
+			}
+		}
+		for (unsigned l = 0; l < numLanes; ++l)
+		{
+			z[l] = static_cast<Real>(draws[l]);
+			logDrift[l] = logDrifts[laneStep[l]];
+			diffusion[l] = diffusions[laneStep[l]];
+		}
+		transformStep = !transformStep;
+
+		unsigned hit = 0;
+		if constexpr (std::is_same<Real, double>::value)
+		{
+			hit = egarch_ ? advanceEgarch(logS, logVariance, draws, egarchStep, logBarrier, upBarrier, numLanes)
+				: advance(logS, z, logDrift, diffusion, laneBarrier, upBarrier, numLanes);
+		}
+		else
+		{
+			hit = advance(logS, z, logDrift, diffusion, laneBarrier, upBarrier, numLanes);
+		}
+		hit &= active;
+		knocked |= hit;
+
+		// Knock-out paths end at the barrier, the others at expiry
+		unsigned done = knockIn ? 0u : hit;
+		for (unsigned l = 0; l < numLanes; ++l)
+		{
+			laneStep[l] += (active >> l) & 1u;
+			done |= static_cast<unsigned>(laneStep[l] == numTimeSteps_) << l;
+		}
+		pathSteps += std::bitset<maxLanes>(active).count();
+		active &= ~done;
+		for (unsigned l = 0; done != 0; ++l, done >>= 1)
+		{
+			if (done & 1u)
+			{
+				// The lane is free for the next scenario
+				const double x = static_cast<double>(logS[l]);
+				terminalPrices[scenario[l]] = single ? initEquityPrice_ * exp(x) : exp(x);
+				hitBarrier[scenario[l]] = ((knocked >> l) & 1u) != 0;
+				knocked &= ~(1u << l);
+				laneStep[l] = 0;
+			}
+		}
+	}
+
+	return pathSteps;
+}
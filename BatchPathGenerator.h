@@ -0,0 +1,95 @@
+#ifndef BATCH_PATH_GENERATOR_H
+#define BATCH_PATH_GENERATOR_H
+
+#include "ResultSet.h"
+#include "EngineSettings.h"
+#include "Egarch.h"
+#include "TermStructure.h"
+#include <cstddef>
+#include <memory>
+
+// Simulates a block of equity price paths in lockstep, one SIMD lane per path.
+// The state is kept as a structure of arrays (log price per lane, normal draw per lane,
+// and a bit mask of the lanes running a path) so that each time step is a single fused
+// multiply-add and compare across the block.  A lane whose path is done takes the next
+// scenario, so the block stays full until the last few paths.  Working in log space means there is no
+// exp(.) in the step at all; the price is only exponentiated at expiry.
+//
+// The uniforms for each lane come from the scenario's own stream -- Philox keyed by (seed, scenario),
+// or mt19937_64(seed + scenario) -- and are turned into normals with a vectorized Box-Muller
+// transform.  With Philox these are the same draws as PhiloxNormals (to rounding), so the paths
+// match the scalar generator's; with mt19937_64 they have the same distribution as, but are not,
+// the draws std::normal_distribution would give.
+//
+// In single precision (see Precision) each lane carries its log return from the initial price as a
+// float, so a register holds twice the lanes;  the normals are still drawn in double and rounded.
+class BatchPathGenerator
+{
+public:
+	enum class Kernel
+	{
+		SCALAR,		// Portable fallback
+		AVX2,		// 2 x 4 doubles per step
+		AVX512		// 2 x 8 doubles per step
+	};
+
+	static const unsigned maxLanes = 32;
+
+	// kernel:  normally left to bestKernel(), which asks the CPU (CPUID) what it supports
+	BatchPathGenerator(double initEquityPrice, unsigned numTimeSteps, double timeToMaturity,
+		double drift, double volatility, RandomStream randomStream = RandomStream::PHILOX,
+		Kernel kernel = bestKernel(), Precision precision = Precision::DOUBLE);
+
+	// Piecewise rate and volatility, as EquityPriceGenerator's:  each step adds that step's entries of
+	// the TimeStepTable, so the step is still one multiply-add per lane
+	BatchPathGenerator(double initEquityPrice, unsigned numTimeSteps, double timeToMaturity,
+		const TermStructure& termStructure, RandomStream randomStream = RandomStream::PHILOX,
+		Kernel kernel = bestKernel(), Precision precision = Precision::DOUBLE);
+
+	// Stochastic volatility, as EquityPriceGenerator's EGARCH paths:  each lane's volatility starts at
+	// initVolatility and after each step moves by egarch's recursion on that lane's draw.  The lanes
+	// are kept in log variance, so a step adds only a vectorized exp(logVariance / 2) per lane.  Double
+	// precision only.
+	BatchPathGenerator(double initEquityPrice, unsigned numTimeSteps, double timeToMaturity, double drift,
+		double initVolatility, std::shared_ptr<const Egarch> egarch, RandomStream randomStream = RandomStream::PHILOX,
+		Kernel kernel = bestKernel());
+
+	static Kernel bestKernel();
+	Kernel kernel() const;
+	Precision precision() const;
+	unsigned lanes() const;			// Paths per block: 8 (scalar, AVX2) or 16 (AVX-512), twice that in single precision
+
+	// Simulates scenarios firstScenario, ..., firstScenario + numPaths - 1 of the trade seeded with
+	// seed, and monitors the barrier at every time step.  Writes each path's terminal price and whether
+	// it hit the barrier to terminalPrices[i] and hitBarrier[i], i = scenario - firstScenario.  A
+	// knock-out path stops at the barrier (its terminal price is then meaningless) and its lane takes
+	// the next scenario;  knock-in paths always run to expiry.  Returns the number of steps taken,
+	// summed over the paths.
+	unsigned long long simulate(int seed, std::size_t firstScenario, unsigned numPaths, Barrier barrierType,
+		double barrierLevel, double* terminalPrices, bool* hitBarrier) const;
+
+	// Writes the first numSteps normals of the scenario's Philox stream to draws:  PhiloxNormals(seed,
+	// scenario)'s draws (to rounding), through the vectorized Box-Muller transform with a step pair
+	// per lane, for an estimator that takes a whole path's draws at a time
+	static void philoxNormals(int seed, std::size_t scenario, unsigned numSteps, double* draws,
+		Kernel kernel = bestKernel());
+
+private:
+	// simulate(.) with the lanes' log prices in Real (for float, their log returns)
+	template <typename Real>
+	unsigned long long simulate_(int seed, std::size_t firstScenario, unsigned numPaths, Barrier barrierType,
+		double barrierLevel, double* terminalPrices, bool* hitBarrier) const;
+
+	double initEquityPrice_;
+	unsigned numTimeSteps_;
+	std::shared_ptr<const TimeStepTable> steps_;	// Per step:  (drift - vol^2/2) * dt and vol * sqrt(dt)
+	std::shared_ptr<const Egarch> egarch_;	// Null for a constant volatility
+	double rateDt_;				// EGARCH:  drift * dt
+	double dt_;
+	double initLogVariance_;	// EGARCH:  log(initVolatility^2)
+	RandomStream randomStream_;
+	Kernel kernel_;
+	Precision precision_;
+};
+
+#endif
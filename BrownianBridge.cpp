@@ -0,0 +1,86 @@
+#include "BrownianBridge.h"
+#include <cmath>
+#include <cassert>
+
+using std::vector;
+using std::sqrt;
+
+// The construction follows Jaeckel, "Monte Carlo Methods in Finance" (2002), as also used in QuantLib.
+// Time is measured in steps (t_i = i + 1 for point i), which is all that equal spacing needs.
+BrownianBridge::BrownianBridge(unsigned numSteps) :numSteps_(numSteps), bridgeIndex_(numSteps), leftIndex_(numSteps),
+	rightIndex_(numSteps), leftWeight_(numSteps), rightWeight_(numSteps), stdDev_(numSteps)
+{
+	assert(numSteps > 0);
+
+	vector<unsigned> map(numSteps, 0);		// map[l] != 0 once point l has been placed
+	auto t = [](unsigned i) { return static_cast<double>(i + 1); };
+
+	map[numSteps - 1] = 1;
+	bridgeIndex_[0] = numSteps - 1;
+	stdDev_[0] = sqrt(t(numSteps - 1));
+	leftWeight_[0] = rightWeight_[0] = 0.0;
+
+	for (unsigned j = 0, i = 1; i < numSteps; ++i)
+	{
+		// Find the next gap [j, k) of unplaced points, bounded on the right by placed point k
+		while (map[j])
+		{
+			++j;
+		}
+		unsigned k = j;
+		while (!map[k])
+		{
+			++k;
+		}
+
+		unsigned l = j + ((k - 1 - j) >> 1);	// Middle of the gap
+		map[l] = i;
+		bridgeIndex_[i] = l;
+		leftIndex_[i] = j;
+		rightIndex_[i] = k;
+
+		double tLeft = (j != 0) ? t(j - 1) : 0.0;
+		leftWeight_[i] = (t(k) - t(l)) / (t(k) - tLeft);
+		rightWeight_[i] = (t(l) - tLeft) / (t(k) - tLeft);
+		stdDev_[i] = sqrt((t(l) - tLeft) * (t(k) - t(l)) / (t(k) - tLeft));
+
+		j = k + 1;
+		if (j >= numSteps)
+		{
+			j = 0;
+		}
+	}
+}
+
+unsigned BrownianBridge::numSteps() const
+{
+	return numSteps_;
+}
+
+void BrownianBridge::transform(const double* normals, double* increments) const
+{
+	// Build W(t_i) in place, then difference it.  W has variance t_i = i + 1, so the
+	// increments come out with unit variance.
+	double* w = increments;
+	w[numSteps_ - 1] = stdDev_[0] * normals[0];
+
+	for (unsigned i = 1; i < numSteps_; ++i)
+	{
+		unsigned j = leftIndex_[i];
+		unsigned k = rightIndex_[i];
+		unsigned l = bridgeIndex_[i];
+		if (j != 0)
+		{
+			w[l] = leftWeight_[i] * w[j - 1] + rightWeight_[i] * w[k] + stdDev_[i] * normals[i];
+		}
+		else
+		{
+			w[l] = rightWeight_[i] * w[k] + stdDev_[i] * normals[i];
+		}
+	}
+
+	for (unsigned i = numSteps_ - 1; i >= 1; --i)
+	{
+		w[i] -= w[i - 1];
+	}
+}
@@ -0,0 +1,34 @@
+#ifndef BROWNIAN_BRIDGE_H
+#define BROWNIAN_BRIDGE_H
+
+#include <vector>
+
+// Brownian-bridge path construction on an equally spaced grid of numSteps steps.  The first normal
+// fixes the terminal value W(T), the next the midpoint, and so on, each later normal filling in
+// a point between two already known ones.  With quasi-random inputs this puts the best-distributed
+// (lowest) dimensions on the large-scale shape of the path.
+class BrownianBridge
+{
+public:
+	explicit BrownianBridge(unsigned numSteps);
+
+	unsigned numSteps() const;
+
+	// normals[0..numSteps) in bridge order -> the standardized increments of each time step, ie
+	// (W(t_i) - W(t_{i-1})) / sqrt(dt), which are again independent standard normals.
+	void transform(const double* normals, double* increments) const;
+
+private:
+	unsigned numSteps_;
+
+	// Construction order:  point bridgeIndex_[i] is set from its known neighbours
+	// leftIndex_[i] - 1 (or time 0) and rightIndex_[i], with the given weights and std deviation.
+	std::vector<unsigned> bridgeIndex_;
+	std::vector<unsigned> leftIndex_;
+	std::vector<unsigned> rightIndex_;
+	std::vector<double> leftWeight_;
+	std::vector<double> rightWeight_;
+	std::vector<double> stdDev_;
+};
+
+#endif
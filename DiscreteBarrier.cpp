@@ -0,0 +1,181 @@
+#include "DiscreteBarrier.h"
+#include "BarrierPayoff.h"
+#include <vector>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+namespace
+{
+	const double invSqrt2 = 0.70710678118654752440;
+	const double invSqrt2Pi = 0.39894228040143267794;
+
+	// The transition density is cut off this many standard deviations from its mean, and the grid
+	// this many standard deviations of the whole path beyond the spot
+	const double tailWidth = 10.0;
+
+	// Grid points per standard deviation of one step
+	const double pointsPerSd = 16.0;
+
+	double N(double x)
+	{
+		return 0.5 * std::erfc(-x * invSqrt2);
+	}
+
+	// E[payoff(exp(y)); lo < y < hi] for y ~ N(mean, sd^2):  hi = +inf and lo = -inf are allowed
+	double vanillaOver(OptionType optionType, double strike, double mean, double sd, double lo, double hi)
+	{
+		const double logStrike = std::log(strike);
+		if (optionType == OptionType::CALL)
+		{
+			lo = std::max(lo, logStrike);
+		}
+		else
+		{
+			hi = std::min(hi, logStrike);
+		}
+		if (lo >= hi)
+		{
+			return 0.0;
+		}
+
+		// P(lo < y + shift < hi)
+		const double variance = sd * sd;
+		auto probability = [&](double shift)
+		{
+			return N((hi - mean - shift) / sd) - N((lo - mean - shift) / sd);
+		};
+		const double terminal = std::exp(mean + 0.5 * variance) * probability(variance);
+		const double exercise = strike * probability(0.0);
+		return (optionType == OptionType::CALL) ? terminal - exercise : exercise - terminal;
+	}
+}
+
+DiscreteBarrier::DiscreteBarrier(Barrier barrierType, OptionType optionType, double barrierLevel, double strike,
+	unsigned numDates) :barrierType_(barrierType), optionType_(optionType), barrierLevel_(barrierLevel),
+	strike_(strike), numDates_(std::max(numDates, 1u)) {}
+
+double DiscreteBarrier::price(double spot, double riskFreeRate, double volatility, double timeToExpiry,
+	double timeToSettlement) const
+{
+	const double out = expectedPayoff_(spot, riskFreeRate, volatility, timeToExpiry, false);
+	const double value = isKnockIn(barrierType_)
+		? expectedPayoff_(spot, riskFreeRate, volatility, timeToExpiry, true) - out : out;
+	return std::exp(-riskFreeRate * timeToSettlement) * value;
+}
+
+OptionResults DiscreteBarrier::values(double spot, double riskFreeRate, double volatility, double timeToExpiry,
+	double timeToSettlement, double quantity) const
+{
+	// Central differences, with spot and volatility moved by a relative h and the rate by hRate
+	const double h = 1e-3;
+	const double hRate = 1e-4;
+	auto at = [&](double spotShift, double volShift, double rateShift)
+	{
+		return quantity * price(spot * (1.0 + spotShift * h), riskFreeRate + rateShift * hRate,
+			volatility * (1.0 + volShift * h), timeToExpiry, timeToSettlement);
+	};
+	const double value = at(0, 0, 0);
+	const double spotUp = at(1, 0, 0);
+	const double spotDown = at(-1, 0, 0);
+	const double volUp = at(0, 1, 0);
+	const double volDown = at(0, -1, 0);
+	const double dS = h * spot;
+	const double dVol = h * volatility;
+
+	OptionResults results;
+	results.resultSet.insert({ OptionResults::PRICE, value });
+	results.resultSet.insert({ OptionResults::DELTA, (spotUp - spotDown) / (2.0 * dS) });
+	results.resultSet.insert({ OptionResults::VEGA, (volUp - volDown) / (2.0 * dVol) });
+	results.resultSet.insert({ OptionResults::RHO, (at(0, 0, 1) - at(0, 0, -1)) / (2.0 * hRate) });
+	results.resultSet.insert({ OptionResults::GAMMA, (spotUp - 2.0 * value + spotDown) / (dS * dS) });
+	results.resultSet.insert({ OptionResults::VANNA, (at(1, 1, 0) - at(1, -1, 0) - at(-1, 1, 0) + at(-1, -1, 0))
+		/ (4.0 * dS * dVol) });
+	results.resultSet.insert({ OptionResults::VOLGA, (volUp - 2.0 * value + volDown) / (dVol * dVol) });
+	return results;
+}
+
+double DiscreteBarrier::expectedPayoff_(double spot, double riskFreeRate, double volatility, double timeToExpiry,
+	bool noBarrier) const
+{
+	const double infinity = std::numeric_limits<double>::infinity();
+	const double x0 = std::log(spot);
+	const double pathSd = volatility * std::sqrt(timeToExpiry);
+	const double pathDrift = (riskFreeRate - 0.5 * volatility * volatility) * timeToExpiry;
+	if (noBarrier)
+	{
+		return vanillaOver(optionType_, strike_, x0 + pathDrift, pathSd, -infinity, infinity);
+	}
+	if (barrierHit(barrierType_, barrierLevel_, spot))
+	{
+		return 0.0;		// Knocked out today
+	}
+
+	// Log prices on the side of the barrier that survives, from the barrier outwards:  y_j = b + up j h
+	const double up = isUpBarrier(barrierType_) ? -1.0 : 1.0;	// Direction away from the barrier
+	const double b = std::log(barrierLevel_);
+	const double dt = timeToExpiry / numDates_;
+	const double mu = (riskFreeRate - 0.5 * volatility * volatility) * dt;
+	const double sd = volatility * std::sqrt(dt);
+	const double lo = (up > 0.0) ? b : -infinity;
+	const double hi = (up > 0.0) ? infinity : b;
+	if (numDates_ == 1)
+	{
+		return vanillaOver(optionType_, strike_, x0 + mu, sd, lo, hi);
+	}
+
+	const double step = sd / pointsPerSd;
+	const double width = up * (x0 - b) + std::abs(pathDrift) + tailWidth * pathSd;
+	const std::size_t numPoints = 2 * static_cast<std::size_t>(std::ceil(0.5 * width / step)) + 1;	// Odd, for Simpson's rule
+	auto y = [&](std::size_t j)
+	{
+		return b + up * (j * step);
+	};
+	std::vector<double> weights(numPoints);		// Simpson's rule
+	for (std::size_t j = 0; j < numPoints; ++j)
+	{
+		weights[j] = step / 3.0 * ((j == 0 || j + 1 == numPoints) ? 1.0 : (j % 2 == 1) ? 4.0 : 2.0);
+	}
+
+	// Values one date before expiry:  the last step in closed form
+	std::vector<double> values(numPoints);
+	for (std::size_t j = 0; j < numPoints; ++j)
+	{
+		values[j] = vanillaOver(optionType_, strike_, y(j) + mu, sd, lo, hi);
+	}
+
+	// Back a date at a time:  value_i = sum_j weight_j density(y_j - y_i) value_j, where the density
+	// of a step of d grid points is the same for every i
+	const long reach = static_cast<long>(std::ceil(tailWidth * pointsPerSd + std::abs(mu) / step));
+	std::vector<double> kernel(2 * reach + 1);
+	for (long d = -reach; d <= reach; ++d)
+	{
+		const double z = (up * d * step - mu) / sd;
+		kernel[d + reach] = invSqrt2Pi / sd * std::exp(-0.5 * z * z);
+	}
+	std::vector<double> previous(numPoints);
+	for (unsigned date = numDates_ - 1; date > 1; --date)
+	{
+		for (std::size_t i = 0; i < numPoints; ++i)
+		{
+			const std::size_t first = (i > static_cast<std::size_t>(reach)) ? i - reach : 0;
+			const std::size_t last = std::min(numPoints - 1, i + reach);
+			double sum = 0.0;
+			for (std::size_t j = first; j <= last; ++j)
+			{
+				sum += weights[j] * kernel[j + reach - i] * values[j];
+			}
+			previous[i] = sum;
+		}
+		values.swap(previous);
+	}
+
+	// The first date, from the spot
+	double sum = 0.0;
+	for (std::size_t j = 0; j < numPoints; ++j)
+	{
+		const double z = (y(j) - x0 - mu) / sd;
+		sum += weights[j] * invSqrt2Pi / sd * std::exp(-0.5 * z * z) * values[j];
+	}
+	return sum;
+}
@@ -0,0 +1,43 @@
+#ifndef DISCRETE_BARRIER_H
+#define DISCRETE_BARRIER_H
+
+#include "ResultSet.h"
+
+// Value of a single-barrier option monitored at numDates equally spaced dates (the last one at
+// expiry), under the constant-volatility geometric Brownian motion EquityPriceGenerator simulates,
+// by numerical integration rather than simulation:  the value is rolled back from expiry one
+// monitoring date at a time, each step integrating the Gaussian transition density over a grid of
+// log prices that ends at the barrier.  It is the model the Monte Carlo engine prices with
+// BarrierMonitoring::DISCRETE on numDates time steps, without the Broadie-Glasserman-Kou
+// approximation AnalyticBarrier makes for discrete monitoring, so it serves as the reference for
+// that engine's price and greeks.
+//
+// A knock-in is the vanilla option less the knock-out.  There is no rebate.  The greeks are central
+// differences of the (deterministic) integral.  Cash flows settle at timeToSettlement, as in
+// BarrierOption.
+class DiscreteBarrier
+{
+public:
+	DiscreteBarrier(Barrier barrierType, OptionType optionType, double barrierLevel, double strike, unsigned numDates);
+
+	// Value of one unit.  timeToExpiry and timeToSettlement are year fractions from the value date.
+	double price(double spot, double riskFreeRate, double volatility, double timeToExpiry,
+		double timeToSettlement) const;
+
+	// Price, delta, vega and rho, and gamma, vanna and volga, of quantity units
+	OptionResults values(double spot, double riskFreeRate, double volatility, double timeToExpiry,
+		double timeToSettlement, double quantity = 1.0) const;
+
+private:
+	// Undiscounted expected payoff of the knock-out (or, with noBarrier, of the vanilla option)
+	double expectedPayoff_(double spot, double riskFreeRate, double volatility, double timeToExpiry,
+		bool noBarrier) const;
+
+	Barrier barrierType_;
+	OptionType optionType_;
+	double barrierLevel_;
+	double strike_;
+	unsigned numDates_;
+};
+
+#endif
@@ -1,25 +1,38 @@
-#ifndef EGARCH_H	
-#define EGARCH_H
-
-#include <cmath>
-#include <random>
-
-using std::mt19937_64;
-using std::normal_distribution;
-using std::exp;
-using std::vector;
-
-class Egarch
-{
-public:
-	Egarch(double alphaZero, double alphaOne, double gamma, double beta, int seed);
-	double operator() (double prevSigma,double norm) const;
-private:
-	double alphaZero_;
-	double alphaOne_;
-	double gamma_;
-	double beta_;
-	int seed_;
-};
-
-#endif
+#ifndef EGARCH_H	
+#define EGARCH_H
+
+#include <cmath>
+#include <random>
+
+using std::mt19937_64;
+using std::normal_distribution;
+using std::exp;
+using std::vector;
+
+class Egarch
+{
+public:
+	Egarch(double alphaZero, double alphaOne, double gamma, double beta, int seed);
+	double operator() (double prevSigma,double norm) const;
+
+	// The same recursion in log variance:  log(sigma^2) from the previous one.  A path kept in log
+	// variance needs no log(prevSigma^2), and only exp(logVariance / 2) for its sigma.
+	double logVariance(double prevLogVariance, double norm) const
+	{
+		return alphaZero_ + alphaOne_ * (std::abs(norm) + gamma_ * norm) + beta_ * prevLogVariance;
+	}
+
+	double alphaZero() const;
+	double alphaOne() const;
+	double gamma() const;
+	double beta() const;
+
+private:
+	double alphaZero_;
+	double alphaOne_;
+	double gamma_;
+	double beta_;
+	int seed_;
+};
+
+#endif
@@ -0,0 +1,262 @@
+#include "EgarchCalibrator.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using std::vector;
+using std::size_t;
+
+namespace
+{
+	const int numParameters = EgarchCalibrator::NUM_PARAMETERS;
+	const double log2Pi = 1.83787706640934548356;
+
+	// The first log variance:  that of the whole series
+	double initialLogVariance(const double* returns, size_t numReturns)
+	{
+		double sumSq = 0.0;
+		for (size_t t = 0; t < numReturns; ++t)
+		{
+			sumSq += returns[t] * returns[t];
+		}
+		return std::log(std::max(sumSq / std::max<size_t>(numReturns, 1), std::numeric_limits<double>::min()));
+	}
+
+	double dot(const double* a, const double* b)
+	{
+		double sum = 0.0;
+		for (int k = 0; k < numParameters; ++k)
+		{
+			sum += a[k] * b[k];
+		}
+		return sum;
+	}
+}
+
+Egarch EgarchFit::egarch(double periodsPerYear, int seed) const
+{
+	// log(sigma^2) moves up by log(periodsPerYear) on annualizing, which alphaZero absorbs
+	return Egarch(alphaZero + (1.0 - beta) * std::log(periodsPerYear), alphaOne, gamma, beta, seed);
+}
+
+EgarchCalibrator::EgarchCalibrator(unsigned maxIterations, double tolerance, PricingThreadPool* executor)
+	:maxIterations_(maxIterations), tolerance_(tolerance), executor_(executor) {}
+
+double EgarchCalibrator::logLikelihood(const double* returns, size_t numReturns, const double* parameters,
+	double* gradient)
+{
+	const double alphaZero = parameters[ALPHA_ZERO];
+	const double alphaOne = parameters[ALPHA_ONE];
+	const double gamma = parameters[GAMMA];
+	const double beta = parameters[BETA];
+
+	// h = log(sigma_t^2) and dh/d(parameters), carried from one return to the next.  With
+	// g = |z| + gamma z, dh_t = (1, g, alphaOne z, h_{t-1}) + (beta - alphaOne g / 2) dh_{t-1}, since
+	// z = r exp(-h / 2) moves by -z dh / 2.
+	double h = initialLogVariance(returns, numReturns);
+	double dh[numParameters] = { 0.0, 0.0, 0.0, 0.0 };
+	double sum = 0.0;
+	double gradientSum[numParameters] = { 0.0, 0.0, 0.0, 0.0 };
+	for (size_t t = 0; t < numReturns; ++t)
+	{
+		const double z = returns[t] * std::exp(-0.5 * h);
+		const double zSq = z * z;
+		sum += h + zSq;
+		for (int k = 0; k < numParameters; ++k)
+		{
+			gradientSum[k] += (1.0 - zSq) * dh[k];
+		}
+
+		const double g = std::abs(z) + gamma * z;
+		const double carry = beta - 0.5 * alphaOne * g;
+		const double direct[numParameters] = { 1.0, g, alphaOne * z, h };
+		for (int k = 0; k < numParameters; ++k)
+		{
+			dh[k] = direct[k] + carry * dh[k];
+		}
+		h = alphaZero + alphaOne * g + beta * h;
+	}
+
+	if (gradient != nullptr)
+	{
+		for (int k = 0; k < numParameters; ++k)
+		{
+			gradient[k] = -0.5 * gradientSum[k];
+		}
+	}
+	return -0.5 * (numReturns * log2Pi + sum);
+}
+
+EgarchFit EgarchCalibrator::operator()(const double* returns, size_t numReturns) const
+{
+	// Minimizes f = -logLikelihood / numReturns, per return so that tolerance_ does not depend on
+	// the length of the series.  The search runs in x = (alphaZero + beta c, alphaOne, gamma, beta),
+	// c the first log variance:  the recursion is then h - c = x[0] - c + alphaOne g + beta (h - c), and
+	// a move in beta is not undone by one in alphaZero, as it very nearly is with h far from 0.  The
+	// start is a persistent process at the series' own variance.
+	const double scale = 1.0 / std::max<size_t>(numReturns, 1);
+	const double c = initialLogVariance(returns, numReturns);
+	auto parameters = [c](const double* x, double* p)
+	{
+		std::copy(x, x + numParameters, p);
+		p[ALPHA_ZERO] = x[ALPHA_ZERO] - x[BETA] * c;
+	};
+	auto objective = [&](const double* x, double* gradient)
+	{
+		double p[numParameters];
+		parameters(x, p);
+		const double f = -scale * logLikelihood(returns, numReturns, p, gradient);
+		gradient[BETA] -= c * gradient[ALPHA_ZERO];
+		for (int k = 0; k < numParameters; ++k)
+		{
+			gradient[k] *= -scale;
+		}
+		return f;
+	};
+
+	const double meanAbsNormal = 0.79788456080286535588;	// E|z| = sqrt(2 / pi)
+	double x[numParameters] = { 0.0, 0.1, 0.0, 0.95 };
+	x[ALPHA_ZERO] = c - x[ALPHA_ONE] * meanAbsNormal;
+	double gradient[numParameters];
+	double f = objective(x, gradient);
+
+	// BFGS:  H approximates the inverse Hessian, starting from the identity and rescaled after the
+	// first step (Nocedal and Wright, 6.20)
+	double H[numParameters][numParameters];
+	auto resetH = [&H](double diagonal)
+	{
+		for (int i = 0; i < numParameters; ++i)
+		{
+			for (int j = 0; j < numParameters; ++j)
+			{
+				H[i][j] = (i == j) ? diagonal : 0.0;
+			}
+		}
+	};
+	resetH(1.0);
+	bool scaled = false;
+
+	auto maxAbs = [](const double* v)
+	{
+		double m = 0.0;
+		for (int k = 0; k < numParameters; ++k)
+		{
+			m = std::max(m, std::abs(v[k]));
+		}
+		return m;
+	};
+
+	// Near the optimum the likelihood's rounding error outgrows what a step can gain, and the
+	// gradient may then stay above tolerance_:  the search also stops once a step improves f by
+	// no more than stall (relative)
+	const double stall = 1.0e-14;
+	bool converged = false;
+	unsigned iteration = 0;
+	for (; iteration < maxIterations_ && !converged; ++iteration)
+	{
+		if (maxAbs(gradient) < tolerance_)
+		{
+			converged = true;
+			break;
+		}
+
+		double direction[numParameters];
+		for (int i = 0; i < numParameters; ++i)
+		{
+			direction[i] = -dot(H[i], gradient);
+		}
+		double slope = dot(gradient, direction);
+		if (slope >= 0.0)
+		{
+			// Not a descent direction:  start again from steepest descent
+			resetH(1.0);
+			scaled = false;
+			for (int i = 0; i < numParameters; ++i)
+			{
+				direction[i] = -gradient[i];
+			}
+			slope = dot(gradient, direction);
+		}
+
+		// Backtrack until the Armijo condition holds, staying where the recursion is stationary
+		double next[numParameters];
+		double nextGradient[numParameters];
+		double nextF = 0.0;
+		bool accepted = false;
+		double step = 1.0;
+		for (int trial = 0; trial < 60 && !accepted; ++trial, step *= 0.5)
+		{
+			for (int k = 0; k < numParameters; ++k)
+			{
+				next[k] = x[k] + step * direction[k];
+			}
+			if (std::abs(next[BETA]) < 1.0)
+			{
+				nextF = objective(next, nextGradient);
+				accepted = std::isfinite(nextF) && nextF <= f + 1.0e-4 * step * slope;
+			}
+		}
+		if (!accepted)
+		{
+			break;
+		}
+
+		double s[numParameters];
+		double y[numParameters];
+		for (int k = 0; k < numParameters; ++k)
+		{
+			s[k] = next[k] - x[k];
+			y[k] = nextGradient[k] - gradient[k];
+		}
+		const double sy = dot(s, y);
+		if (sy > 0.0)
+		{
+			if (!scaled)
+			{
+				resetH(sy / dot(y, y));
+				scaled = true;
+			}
+
+			// H = (I - rho s y') H (I - rho y s') + rho s s', rho = 1 / (s'y)
+			const double rho = 1.0 / sy;
+			double Hy[numParameters];
+			for (int i = 0; i < numParameters; ++i)
+			{
+				Hy[i] = dot(H[i], y);
+			}
+			const double yHy = dot(y, Hy);
+			for (int i = 0; i < numParameters; ++i)
+			{
+				for (int j = 0; j < numParameters; ++j)
+				{
+					H[i][j] += rho * ((1.0 + rho * yHy) * s[i] * s[j] - Hy[i] * s[j] - s[i] * Hy[j]);
+				}
+			}
+		}
+
+		converged = (f - nextF <= stall * std::abs(f));
+		std::copy(next, next + numParameters, x);
+		std::copy(nextGradient, nextGradient + numParameters, gradient);
+		f = nextF;
+	}
+
+	double p[numParameters];
+	parameters(x, p);
+	return EgarchFit{ p[ALPHA_ZERO], p[ALPHA_ONE], p[GAMMA], p[BETA], -f / scale, iteration,
+		converged || maxAbs(gradient) < tolerance_ };
+}
+
+vector<EgarchFit> EgarchCalibrator::operator()(const vector<ReturnSeries>& series) const
+{
+	// A series is a task:  each is thousands of likelihood passes, so one per chunk balances best
+	vector<EgarchFit> fits(series.size());
+	PricingThreadPool& pool = (executor_ != nullptr) ? *executor_ : PricingThreadPool::shared();
+	pool.parallelFor(0, series.size(), 1, [&](size_t begin, size_t end)
+	{
+		for (size_t k = begin; k < end; ++k)
+		{
+			fits[k] = (*this)(series[k].returns, series[k].numReturns);
+		}
+	});
+	return fits;
+}
\ No newline at end of file
@@ -0,0 +1,76 @@
+#ifndef EGARCH_CALIBRATOR_H
+#define EGARCH_CALIBRATOR_H
+
+#include "Egarch.h"
+#include "PricingThreadPool.h"
+#include <cstddef>
+#include <vector>
+
+// numReturns contiguous returns of one underlying (eg, daily log returns), oldest first.  Not owned.
+struct ReturnSeries
+{
+	const double* returns;
+	std::size_t numReturns;
+};
+
+// The maximum-likelihood parameters of one series
+struct EgarchFit
+{
+	double alphaZero;
+	double alphaOne;
+	double gamma;
+	double beta;
+	double logLikelihood;
+	unsigned iterations;
+	bool converged;			// The gradient fell below tolerance, or a step no longer gained more than rounding;
+							// else stopped at maxIterations, or where no step improved the likelihood
+
+	// The fitted process for paths that step once per return period, in the annualized volatility
+	// BarrierOption takes:  periodsPerYear is, eg, 252 for daily returns
+	Egarch egarch(double periodsPerYear, int seed = 0) const;
+};
+
+// Fits Egarch's recursion log(sigma_t^2) = alphaZero + alphaOne (|z| + gamma z) + beta log(sigma_{t-1}^2),
+// z = r_{t-1} / sigma_{t-1}, to return series by maximum likelihood with normal innovations.  The
+// returns are taken to have zero mean, and the first log variance is that of the whole series.
+//
+// The likelihood and its gradient come from one pass over the returns:  the log variance is
+// carried forward with its derivatives, a fixed four-wide update the compiler keeps in vector
+// registers, and there is one exp(.) per return.  The recursion is serial in time, so the
+// parallelism is across series:  operator()(series) fits each on its own task on the pool.
+// The optimizer is BFGS with a backtracking line search that keeps |beta| < 1.
+class EgarchCalibrator
+{
+public:
+	enum Parameter
+	{
+		ALPHA_ZERO,
+		ALPHA_ONE,
+		GAMMA,
+		BETA,
+		NUM_PARAMETERS
+	};
+
+	// executor:  pool used by operator()(series); if null, the process-wide shared pool is used.
+	// The pool is not owned and must outlive the EgarchCalibrator.
+	explicit EgarchCalibrator(unsigned maxIterations = 200, double tolerance = 1.0e-7,
+		PricingThreadPool* executor = nullptr);
+
+	// The log-likelihood of numReturns returns under parameters[NUM_PARAMETERS], and if gradient is
+	// not null, its derivatives with respect to them in gradient[NUM_PARAMETERS]
+	static double logLikelihood(const double* returns, std::size_t numReturns, const double* parameters,
+		double* gradient);
+
+	// One series, on this thread
+	EgarchFit operator()(const double* returns, std::size_t numReturns) const;
+
+	// Every series, in parallel:  fits[k] is that of series[k]
+	std::vector<EgarchFit> operator()(const std::vector<ReturnSeries>& series) const;
+
+private:
+	unsigned maxIterations_;
+	double tolerance_;		// On the largest gradient component, per return
+	PricingThreadPool* executor_;
+};
+
+#endif
\ No newline at end of file
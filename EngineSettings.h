@@ -0,0 +1,125 @@
+#ifndef ENGINE_SETTINGS_H
+#define ENGINE_SETTINGS_H
+
+#include <string>
+#include <memory>
+
+class Egarch;
+class TermStructure;
+
+// How BarrierOption values the trade
+enum class PricingMethod
+{
+	MONTE_CARLO,	// Simulate paths, monitoring the barrier at each of the numTimeSteps time steps
+	ANALYTIC		// Reiner-Rubinstein closed form, for a continuously monitored barrier (see AnalyticBarrier.h)
+};
+
+// How each Monte Carlo scenario is generated and evaluated
+enum class PathEngine
+{
+	PATH_VECTOR,	// Generate the whole price path into a vector, then evaluate the payoff over it
+	FUSED,			// Evaluate the payoff as each step is generated; stop the path once it is knocked out
+	SIMD_BATCH		// Advance blocks of 8/16 paths (16/32 in single precision) in lockstep with AVX2/AVX-512
+					// (see BatchPathGenerator).  Only prices run on it:  the price alone and each bumped
+					// revaluation of BUMP_AND_REPRICE.  The single-pass, adjoint, second-order and multilevel
+					// estimators evaluate their own paths on the scalar kernels.
+};
+
+// Where each scenario's normal draws come from (see RandomStreams.h)
+enum class RandomStream
+{
+	MT19937_PER_SCENARIO,	// A fresh mt19937_64(seed + scenario) per scenario (the original scheme)
+	PHILOX,					// Counter-based Philox4x32-10 keyed by (seed, scenario, step)
+	SOBOL					// Randomized quasi-Monte Carlo:  shifted Sobol points on a Brownian bridge (at
+							// most SobolSequence::maxDimension time steps)
+};
+
+// How delta, vega and rho are estimated (the first two are forward differences with a relative shift)
+enum class GreeksMethod
+{
+	BUMP_AND_REPRICE,	// Re-run the whole simulation once per bumped input
+	SINGLE_PASS,		// Value the base and all bumped states in one pass, off the same normal draws
+	ADJOINT				// Differentiate each path, conditioned on surviving each step (see OneStepSurvival),
+						// in reverse on an AdjointTape:  the price and every first-order sensitivity
+						// (strike and barrier included) from one pass, whatever their number
+};
+
+// Control variate for the Monte Carlo estimates
+enum class ControlVariate
+{
+	NONE,
+	ANALYTIC,		// The continuously monitored payoff on the same path (see ContinuousBarrierPayoff),
+					// whose expectation is the closed-form value
+	TERMINAL_SPOT	// The terminal price on the same path, whose expectation is the forward (the path
+					// then always runs to expiry)
+};
+
+// How the Monte Carlo engine monitors the barrier between the simulated time steps
+enum class BarrierMonitoring
+{
+	DISCRETE,		// Only at the numTimeSteps grid points, which are then the contract's monitoring dates
+	BRIDGE_WEIGHT,	// Continuously:  each path's payoff is weighted by its Brownian-bridge survival probability
+	BRIDGE_SAMPLED	// Continuously:  a crossing between steps is drawn with the Brownian-bridge probability
+};
+
+// Floating-point type of the Monte Carlo paths
+enum class Precision
+{
+	DOUBLE,
+	SINGLE		// float paths, evolved in log space, for twice the SIMD lanes and half the table traffic;
+				// the payoffs and their sums stay in double.  Only the SIMD batch engine has float paths, so
+				// the greeks must be BUMP_AND_REPRICE (the other estimators run their own double paths)
+};
+
+// Optional pricing engine choices for BarrierOption.  The defaults reproduce the standard
+// Monte Carlo valuation, so most callers never need to build one of these.
+struct EngineSettings
+{
+	PricingMethod pricingMethod = PricingMethod::MONTE_CARLO;
+	PathEngine pathEngine = PathEngine::FUSED;
+	RandomStream randomStream = RandomStream::PHILOX;
+	GreeksMethod greeksMethod = GreeksMethod::SINGLE_PASS;		// SINGLE_PASS always uses the fused kernel
+	ControlVariate controlVariate = ControlVariate::NONE;
+	unsigned qmcReplications = 16;		// SOBOL only:  independently shifted copies of the point set
+	BarrierMonitoring barrierMonitoring = BarrierMonitoring::DISCRETE;
+	unsigned monitoringDates = 0;		// BRIDGE_* and ANALYTIC:  0 for a continuous barrier, otherwise the number
+										// of equally spaced monitoring dates (by the Broadie-Glasserman shift)
+	bool antithetic = false;			// Pair each scenario with its mirror image (the same draws negated);
+										// numScenarios is then rounded up to an even number
+
+	// Target-precision mode:  run scenarios in batches until the price's standard error is down to
+	// targetStdError or timeBudget seconds have gone by; numScenarios is then the most that will run
+	double targetStdError = 0.0;
+	double timeBudget = 0.0;
+	unsigned batchSize = 4096;			// Scenarios in the first batch; later ones are sized to reach the target
+
+	// Store every scenario's draws on the first valuation and rebuild the paths from them after a spot,
+	// vol or rate change (as running sums when the payoff allows, see BarrierOption::skeletonPaths_)
+	bool cachePaths = false;
+
+	// File of precomputed draws to read instead of drawing (see NormalStore.h); empty to draw as usual
+	std::string normalStore;
+
+	// EGARCH stochastic volatility from the option's volatility (see Egarch.h); the estimators that
+	// assume a constant volatility are then not available
+	std::shared_ptr<const Egarch> egarch;
+
+	// Rate and volatility curves in place of the flat inputs, which then move them in parallel (see
+	// TermStructure.h); the flat-market estimators are then not available
+	std::shared_ptr<const TermStructure> termStructure;
+
+	// Multilevel Monte Carlo (Giles) over time-step refinement from coarsestSteps up to numTimeSteps,
+	// to targetStdError; PHILOX, discrete monitoring and bumped greeks only
+	bool multilevel = false;
+	unsigned coarsestSteps = 12;
+
+	// Float paths on the SIMD batch engine; each price's first precisionCheckScenarios scenarios are
+	// rerun in double and the difference reported (BarrierOption::precisionDifference()), 0 to skip
+	Precision precision = Precision::DOUBLE;
+	unsigned precisionCheckScenarios = 2048;
+
+	bool collectStatistics = false;		// Time the phases of the run and count what the paths did (see
+										// RunStatistics.h); when false, the kernels are not instrumented at all
+};
+
+#endif
@@ -1,48 +1,71 @@
-#include "EquityPriceGenerator.h"
-#include <random>
-#include <algorithm>	
-#include <ctime>
-#include <cmath>
-
-using std::vector;
-using std::mt19937_64;
-using std::normal_distribution;
-
-using std::exp;
-
-using std::vector;
-
-EquityPriceGenerator::EquityPriceGenerator(double initEquityPrice, unsigned numTimeSteps, double timeToMaturity, double drift, double volatility) :
-	initEquityPrice_(initEquityPrice), numTimeSteps_(numTimeSteps), timeToMaturity_(timeToMaturity), drift_(drift), volatility_(volatility),
-	yearFraction_(timeToMaturity / numTimeSteps) {}
-
-vector<double> EquityPriceGenerator::operator()(int seed) const
-{
-	vector<double> v;
-
-	mt19937_64 mtre(seed);
-	normal_distribution<> nd;
-
-	auto newPrice = [this](double previousEquityPrice, double norm)
-	{
-		double price = 0.0;
-
-		double expArg1 = (drift_ - ((volatility_ * volatility_) / 2.0)) * yearFraction_;
-		double expArg2 = volatility_ * norm * sqrt(yearFraction_);
-		price = previousEquityPrice * exp(expArg1 + expArg2);
-
-		return price;
-	};
-
-	v.push_back(initEquityPrice_);				// put initial equity price into the 1st position in the vector
-	double equityPrice = initEquityPrice_;
-
-	for (int i = 1; i <= numTimeSteps_; ++i)	// i <= numTimeSteps_ since we need a price at the end of the
-	{											// final time step.
-		equityPrice = newPrice(equityPrice, nd(mtre));	// norm = nd(mtre)
-		v.push_back(equityPrice);
-	}
-
-	return v;
-
+#include "EquityPriceGenerator.h"
+#include <random>
+#include <algorithm>	
+#include <ctime>
+#include <cmath>
+
+using std::vector;
+using std::mt19937_64;
+using std::normal_distribution;
+
+using std::exp;
+
+using std::vector;
+
+EquityPriceGenerator::EquityPriceGenerator(double initEquityPrice, unsigned numTimeSteps, double timeToMaturity, double drift, double volatility) :
+	yearFraction_(timeToMaturity / numTimeSteps),
+	initEquityPrice_(initEquityPrice), numTimeSteps_(numTimeSteps), timeToMaturity_(timeToMaturity), drift_(drift), volatility_(volatility),
+	steps_(std::make_shared<const TimeStepTable>(TermStructure(drift, volatility), timeToMaturity, numTimeSteps)) {}
+
+EquityPriceGenerator::EquityPriceGenerator(double initEquityPrice, unsigned numTimeSteps, double timeToMaturity,
+	const TermStructure& termStructure) :yearFraction_(timeToMaturity / numTimeSteps),
+	initEquityPrice_(initEquityPrice), numTimeSteps_(numTimeSteps), timeToMaturity_(timeToMaturity),
+	drift_(termStructure.integratedRate(0.0, timeToMaturity) / timeToMaturity),
+	volatility_(std::sqrt(termStructure.integratedVariance(0.0, timeToMaturity) / timeToMaturity)),
+	steps_(std::make_shared<const TimeStepTable>(termStructure, timeToMaturity, numTimeSteps)) {}
+
+EquityPriceGenerator::EquityPriceGenerator(double initEquityPrice, unsigned numTimeSteps, double timeToMaturity, double drift,
+	double initVolatility, std::shared_ptr<const Egarch> egarch) :EquityPriceGenerator(initEquityPrice, numTimeSteps,
+	timeToMaturity, drift, initVolatility)
+{
+	egarch_ = std::move(egarch);
+}
+
+vector<double> EquityPriceGenerator::operator()(int seed) const
+{
+	if (egarch_)
+	{
+		MersenneNormals normals(seed);
+		return egarchPath_(normals);
+	}
+
+	vector<double> v;
+
+	mt19937_64 mtre(seed);
+	normal_distribution<> nd;
+
+	// Step i's log drift and diffusion come from the table built with the generator
+	auto newPrice = [this](double previousEquityPrice, int i, double norm)
+	{
+		return previousEquityPrice * exp(steps_->logDrift(i) + steps_->diffusion(i) * norm);
+	};
+
+	v.push_back(initEquityPrice_);				// put initial equity price into the 1st position in the vector
+	double equityPrice = initEquityPrice_;
+
+	for (int i = 1; i <= numTimeSteps_; ++i)	// i <= numTimeSteps_ since we need a price at the end of the
+	{											// final time step.
+		equityPrice = newPrice(equityPrice, i, nd(mtre));	// norm = nd(mtre)
+		v.push_back(equityPrice);
+	}
+
+	return v;
+
+}
+
+vector<double> EquityPriceGenerator::path(const NormalStore& store, std::size_t sample) const
+{
+	assert(store.numSteps() == static_cast<unsigned>(numTimeSteps_) && sample < store.numSamples());
+	StoredNormals normals(store.sample(sample));
+	return path(normals);
 }
\ No newline at end of file
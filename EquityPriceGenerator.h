@@ -1,28 +1,291 @@
-#ifndef EQUITY_PRICE_GENERATOR_H
-#define EQUITY_PRICE_GENERATOR_H
-
-#include <vector>
-
-class EquityPriceGenerator
-{
-public:
-	// A more robust approach would be to add in a stub period at beginning
-	EquityPriceGenerator(double initEquityPrice, unsigned numTimeSteps, double timeToMaturity, double drift, double volatility);
-
-	// We could also have another ctor that takes in a TermStructure object in place of a constant drift or risk free rate,
-	// as well as a time path determined by a schedule based on dates and a daycount rule; viz,
-	// EquityPriceGenerator(double initEquityPrice, const RealSchedule& realSchedule, const TermStructure& ts, double volatility);
-
-	std::vector<double> operator()(int seed) const;
-
-private:
-	double yearFraction_;
-	const double initEquityPrice_;
-	const int numTimeSteps_;
-	const double timeToMaturity_;
-	const double drift_;
-	const double volatility_;
-};
-
-#endif
-
+#ifndef EQUITY_PRICE_GENERATOR_H
+#define EQUITY_PRICE_GENERATOR_H
+
+#include "RandomStreams.h"
+#include "NormalStore.h"
+#include "Egarch.h"
+#include "TermStructure.h"
+#include <vector>
+#include <memory>
+#include <cmath>
+#include <cassert>
+
+class EquityPriceGenerator
+{
+public:
+	// A more robust approach would be to add in a stub period at beginning
+	EquityPriceGenerator(double initEquityPrice, unsigned numTimeSteps, double timeToMaturity, double drift, double volatility);
+
+	// Stochastic volatility:  the volatility starts at initVolatility and after each time step moves
+	// by egarch's recursion, driven by that step's draw.  The path is kept in log variance (see
+	// Egarch::logVariance), so a step costs one exp(.) more than at constant volatility.
+	EquityPriceGenerator(double initEquityPrice, unsigned numTimeSteps, double timeToMaturity, double drift,
+		double initVolatility, std::shared_ptr<const Egarch> egarch);
+
+	// Piecewise rate and volatility:  each step drifts and diffuses by termStructure's rate and vol over
+	// it (see TimeStepTable).  A flat term structure gives the same paths as the constant constructor.
+	// We could also have a time path determined by a schedule based on dates and a daycount rule; viz,
+	// EquityPriceGenerator(double initEquityPrice, const RealSchedule& realSchedule, const TermStructure& ts);
+	EquityPriceGenerator(double initEquityPrice, unsigned numTimeSteps, double timeToMaturity,
+		const TermStructure& termStructure);
+
+	std::vector<double> operator()(int seed) const;
+
+	// As operator(), but with the normals taken from any source (see RandomStreams.h)
+	template <typename NormalSource>
+	std::vector<double> path(NormalSource& normals) const;
+
+	// Fused alternative to operator():  rather than storing the path, each price (including the
+	// initial one) is handed to evaluator(price) as soon as it is generated.  The evaluator returns
+	// false once the payoff is fixed (eg, knocked out), which ends the path early.
+	// Returns the number of time steps simulated.
+	template <typename NormalSource, typename PathEvaluator>
+	unsigned simulate(NormalSource& normals, PathEvaluator& evaluator) const;
+
+	// Uses the same random numbers as operator()(seed)
+	template <typename PathEvaluator>
+	unsigned simulate(int seed, PathEvaluator& evaluator) const;
+
+	// Uses sample j of a store of precomputed draws, read in place (see NormalStore.h); the store
+	// must have been built for this number of time steps
+	template <typename PathEvaluator>
+	unsigned simulate(const NormalStore& store, std::size_t sample, PathEvaluator& evaluator) const;
+	std::vector<double> path(const NormalStore& store, std::size_t sample) const;
+
+	// Common random numbers:  drives numStates generators (eg, a base and several bumped market
+	// states, all with the same number of time steps) off one stream of normals.  evaluators[k]
+	// sees the path of generators[k], exactly as simulate(normals, evaluators[k]) would; the path
+	// ends once every evaluator has returned false.  Returns the number of time steps simulated.
+	static const unsigned maxCommonStates = 8;
+	template <typename NormalSource, typename PathEvaluator>
+	static unsigned simulateCommon(NormalSource& normals, const EquityPriceGenerator* generators,
+		PathEvaluator* evaluators, unsigned numStates);
+
+	template <typename PathEvaluator>
+	static unsigned simulateCommon(int seed, const EquityPriceGenerator* generators, PathEvaluator* evaluators,
+		unsigned numStates);
+
+	// The per-step tables (with EGARCH, only the discount factors apply)
+	const TimeStepTable& steps() const
+	{
+		return *steps_;
+	}
+
+private:
+	// The EGARCH paths of path(.) and simulate(.)
+	template <typename NormalSource>
+	std::vector<double> egarchPath_(NormalSource& normals) const;
+	template <typename NormalSource, typename PathEvaluator>
+	unsigned simulateEgarch_(NormalSource& normals, PathEvaluator& evaluator) const;
+
+	double yearFraction_;
+	const double initEquityPrice_;
+	const int numTimeSteps_;
+	const double timeToMaturity_;
+	const double drift_;
+	const double volatility_;
+	std::shared_ptr<const Egarch> egarch_;	// Null for a constant volatility
+	std::shared_ptr<const TimeStepTable> steps_;	// Each step's log drift and diffusion (unused with EGARCH),
+													// shared by the copies of this generator
+};
+
+template <typename NormalSource>
+std::vector<double> EquityPriceGenerator::path(NormalSource& normals) const
+{
+	if (egarch_)
+	{
+		return egarchPath_(normals);
+	}
+
+	const double* logDrift = steps_->logDrifts();
+	const double* diffusion = steps_->diffusions();
+
+	std::vector<double> v;
+	v.reserve(numTimeSteps_ + 1);
+	v.push_back(initEquityPrice_);
+	double equityPrice = initEquityPrice_;
+
+	for (int i = 0; i < numTimeSteps_; ++i)
+	{
+		equityPrice = equityPrice * std::exp(logDrift[i] + diffusion[i] * normals());
+		v.push_back(equityPrice);
+	}
+
+	return v;
+}
+
+template <typename PathEvaluator>
+unsigned EquityPriceGenerator::simulate(int seed, PathEvaluator& evaluator) const
+{
+	MersenneNormals normals(seed);
+	return simulate(normals, evaluator);
+}
+
+template <typename PathEvaluator>
+unsigned EquityPriceGenerator::simulate(const NormalStore& store, std::size_t sample, PathEvaluator& evaluator) const
+{
+	assert(store.numSteps() == static_cast<unsigned>(numTimeSteps_) && sample < store.numSamples());
+	StoredNormals normals(store.sample(sample));
+	return simulate(normals, evaluator);
+}
+
+template <typename NormalSource, typename PathEvaluator>
+unsigned EquityPriceGenerator::simulate(NormalSource& normals, PathEvaluator& evaluator) const
+{
+	if (egarch_)
+	{
+		return simulateEgarch_(normals, evaluator);
+	}
+
+	// The same tables as operator() and path(.), so that the paths are identical
+	const double* logDrift = steps_->logDrifts();
+	const double* diffusion = steps_->diffusions();
+
+	double equityPrice = initEquityPrice_;
+	if (!evaluator(equityPrice))
+	{
+		return 0;
+	}
+
+	for (int i = 1; i <= numTimeSteps_; ++i)
+	{
+		equityPrice = equityPrice * std::exp(logDrift[i - 1] + diffusion[i - 1] * normals());
+		if (!evaluator(equityPrice))
+		{
+			return static_cast<unsigned>(i);
+		}
+	}
+
+	return static_cast<unsigned>(numTimeSteps_);
+}
+
+template <typename NormalSource>
+std::vector<double> EquityPriceGenerator::egarchPath_(NormalSource& normals) const
+{
+	std::vector<double> v;
+	v.reserve(numTimeSteps_ + 1);
+	auto store = [&v](double price)		// Given the initial price too
+	{
+		v.push_back(price);
+		return true;
+	};
+	simulateEgarch_(normals, store);
+	return v;
+}
+
+template <typename NormalSource, typename PathEvaluator>
+unsigned EquityPriceGenerator::simulateEgarch_(NormalSource& normals, PathEvaluator& evaluator) const
+{
+	const double sqrtYearFraction = std::sqrt(yearFraction_);
+	const Egarch& egarch = *egarch_;
+
+	double equityPrice = initEquityPrice_;
+	double volatility = volatility_;
+	double logVariance = std::log(volatility_ * volatility_);
+	if (!evaluator(equityPrice))
+	{
+		return 0;
+	}
+
+	for (int i = 1; i <= numTimeSteps_; ++i)
+	{
+		const double norm = normals();
+		equityPrice = equityPrice * std::exp((drift_ - (volatility * volatility) / 2.0) * yearFraction_
+			+ volatility * norm * sqrtYearFraction);
+		if (!evaluator(equityPrice))
+		{
+			return static_cast<unsigned>(i);
+		}
+		logVariance = egarch.logVariance(logVariance, norm);
+		volatility = std::exp(0.5 * logVariance);
+	}
+
+	return static_cast<unsigned>(numTimeSteps_);
+}
+
+template <typename PathEvaluator>
+unsigned EquityPriceGenerator::simulateCommon(int seed, const EquityPriceGenerator* generators,
+	PathEvaluator* evaluators, unsigned numStates)
+{
+	MersenneNormals normals(seed);
+	return simulateCommon(normals, generators, evaluators, numStates);
+}
+
+template <typename NormalSource, typename PathEvaluator>
+unsigned EquityPriceGenerator::simulateCommon(NormalSource& normals, const EquityPriceGenerator* generators,
+	PathEvaluator* evaluators, unsigned numStates)
+{
+	assert(numStates > 0 && numStates <= maxCommonStates);
+
+	const double* logDrift[maxCommonStates];
+	const double* diffusion[maxCommonStates];
+	double expArg1[maxCommonStates];			// EGARCH states:  the step's log drift,
+	double volatility[maxCommonStates];			// its volatility,
+	double sqrtYearFraction[maxCommonStates];	// and sqrt(dt)
+	double equityPrice[maxCommonStates];
+	double logVariance[maxCommonStates];		// EGARCH states only
+	const Egarch* egarch[maxCommonStates];
+	bool alive[maxCommonStates];
+	unsigned numAlive = 0;
+
+	for (unsigned k = 0; k < numStates; ++k)
+	{
+		const EquityPriceGenerator& epg = generators[k];
+		assert(epg.numTimeSteps_ == generators[0].numTimeSteps_);
+
+		logDrift[k] = epg.steps_->logDrifts();
+		diffusion[k] = epg.steps_->diffusions();
+		expArg1[k] = (epg.drift_ - ((epg.volatility_ * epg.volatility_) / 2.0)) * epg.yearFraction_;
+		volatility[k] = epg.volatility_;
+		sqrtYearFraction[k] = std::sqrt(epg.yearFraction_);
+		equityPrice[k] = epg.initEquityPrice_;
+		egarch[k] = epg.egarch_.get();
+		logVariance[k] = std::log(epg.volatility_ * epg.volatility_);
+		alive[k] = evaluators[k](equityPrice[k]);
+		numAlive += alive[k] ? 1 : 0;
+	}
+
+	const int numTimeSteps = generators[0].numTimeSteps_;
+	for (int i = 1; i <= numTimeSteps; ++i)
+	{
+		if (numAlive == 0)
+		{
+			return static_cast<unsigned>(i - 1);
+		}
+
+		double norm = normals();		// One draw, shared by every state
+		for (unsigned k = 0; k < numStates; ++k)
+		{
+			if (alive[k] && egarch[k] == nullptr)
+			{
+				equityPrice[k] = equityPrice[k] * std::exp(logDrift[k][i - 1] + diffusion[k][i - 1] * norm);
+				if (!evaluators[k](equityPrice[k]))
+				{
+					alive[k] = false;
+					--numAlive;
+				}
+			}
+			else if (alive[k])
+			{
+				equityPrice[k] = equityPrice[k] * std::exp(expArg1[k] + volatility[k] * norm * sqrtYearFraction[k]);
+				if (!evaluators[k](equityPrice[k]))
+				{
+					alive[k] = false;
+					--numAlive;
+				}
+				else
+				{
+					// The next step's volatility, and its drift correction
+					logVariance[k] = egarch[k]->logVariance(logVariance[k], norm);
+					volatility[k] = std::exp(0.5 * logVariance[k]);
+					expArg1[k] = (generators[k].drift_ - ((volatility[k] * volatility[k]) / 2.0)) * generators[k].yearFraction_;
+				}
+			}
+		}
+	}
+
+	return static_cast<unsigned>(numTimeSteps);
+}
+
+#endif
+
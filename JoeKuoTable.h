@@ -0,0 +1,23 @@
+#ifndef JOE_KUO_TABLE_H
+#define JOE_KUO_TABLE_H
+
+#include <cstdint>
+
+// Joe and Kuo's primitive polynomials and initial direction numbers for Sobol sequences (S. Joe
+// and F. Y. Kuo, "Constructing Sobol sequences with better two-dimensional projections", SIAM J.
+// Sci. Comput. 30, 2008:  the file new-joe-kuo-6.21201), for dimensions 2 to joeKuoMaxDimension.
+// The table stops, as Boost.Random's copy of it does, at the last polynomial of degree 15.
+const unsigned joeKuoMaxDimension = 3667;
+const unsigned joeKuoMaxDegree = 15;
+
+struct JoeKuoEntry
+{
+	// x^s + a_1 x^(s-1) + ... + a_(s-1) x + 1 as a bit mask, bit i the coefficient of x^i (the file
+	// gives its degree s and a, the bits a_1 .. a_(s-1) in between)
+	std::uint16_t polynomial;
+	std::uint16_t m[joeKuoMaxDegree];		// m_1 .. m_s, then 0
+};
+
+extern const JoeKuoEntry joeKuoTable[joeKuoMaxDimension - 1];	// Entry d - 2 for dimension d
+
+#endif
@@ -0,0 +1,305 @@
+#include "NormalStore.h"
+#include "RandomStreams.h"
+#include "QuasiRandomNormals.h"
+#include "PricingThreadPool.h"
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <algorithm>
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using std::size_t;
+using std::string;
+
+namespace
+{
+	const char magic[8] = { 'B', 'O', 'P', 'N', 'O', 'R', 'M', '\0' };
+	const std::uint32_t byteOrderMark = 0x01020304;
+
+	struct Header
+	{
+		char magic[8];
+		std::uint32_t version;
+		std::uint32_t byteOrder;		// byteOrderMark, as the writing machine stored it
+		std::uint32_t stream;			// RandomStream
+		std::int32_t seed;
+		std::uint32_t numSteps;
+		std::uint32_t qmcReplications;	// 0 unless SOBOL
+		std::uint64_t numSamples;
+		std::uint64_t reserved[3];		// Zero; pads the draws out to a cache line
+	};
+	static_assert(sizeof(Header) == 64, "NormalStore header must be 64 bytes");
+
+	const char* streamName(RandomStream stream)
+	{
+		switch (stream)
+		{
+		case RandomStream::MT19937_PER_SCENARIO:
+			return "MT19937_PER_SCENARIO";
+		case RandomStream::PHILOX:
+			return "PHILOX";
+		case RandomStream::SOBOL:
+			return "SOBOL";
+		default:
+			return "unknown";
+		}
+	}
+
+	void fail(const string& fileName, const string& what)
+	{
+		throw std::runtime_error("NormalStore " + fileName + ":  " + what);
+	}
+
+	// Checks the header read from fileName, of a file fileSize bytes long
+	void checkHeader(const string& fileName, const Header& header, size_t fileSize)
+	{
+		if (fileSize < sizeof(Header) || std::memcmp(header.magic, magic, sizeof(magic)) != 0)
+		{
+			fail(fileName, "not a normal store");
+		}
+		if (header.byteOrder != byteOrderMark)
+		{
+			fail(fileName, "written on a machine of the other byte order");
+		}
+		if (header.version != NormalStore::formatVersion)
+		{
+			fail(fileName, "format version " + std::to_string(header.version) + ", expected "
+				+ std::to_string(NormalStore::formatVersion));
+		}
+		if (header.stream > static_cast<std::uint32_t>(RandomStream::SOBOL) || header.numSteps == 0)
+		{
+			fail(fileName, "corrupt header");
+		}
+		if (fileSize - sizeof(Header) < header.numSamples * header.numSteps * sizeof(double))
+		{
+			fail(fileName, "truncated:  the header promises " + std::to_string(header.numSamples) + " samples of "
+				+ std::to_string(header.numSteps) + " steps");
+		}
+	}
+}
+
+NormalStore::NormalStore(const string& fileName) :fileName_(fileName), mapping_(nullptr), mappingSize_(0),
+	draws_(nullptr)
+{
+	Header header;
+#if !defined(_WIN32)
+	int fd = ::open(fileName.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		fail(fileName, "cannot be opened");
+	}
+	struct stat status;
+	if (::fstat(fd, &status) != 0)
+	{
+		::close(fd);
+		fail(fileName, "cannot be read");
+	}
+	mappingSize_ = static_cast<size_t>(status.st_size);
+	if (mappingSize_ >= sizeof(Header))
+	{
+		mapping_ = ::mmap(nullptr, mappingSize_, PROT_READ, MAP_SHARED, fd, 0);
+	}
+	::close(fd);	// The mapping keeps the file
+	if (mapping_ == MAP_FAILED || mapping_ == nullptr)
+	{
+		mapping_ = nullptr;
+		fail(fileName, "not a normal store");
+	}
+
+	std::memcpy(&header, mapping_, sizeof(Header));
+	try
+	{
+		checkHeader(fileName, header, mappingSize_);
+	}
+	catch (...)
+	{
+		::munmap(mapping_, mappingSize_);
+		throw;
+	}
+	draws_ = reinterpret_cast<const double*>(static_cast<const char*>(mapping_) + sizeof(Header));
+#else
+	// No mapping here:  the draws are read into memory once
+	std::ifstream is(fileName, std::ios::binary | std::ios::ate);
+	if (!is)
+	{
+		fail(fileName, "cannot be opened");
+	}
+	const size_t fileSize = static_cast<size_t>(is.tellg());
+	is.seekg(0);
+	if (!is.read(reinterpret_cast<char*>(&header), sizeof(Header)))
+	{
+		fail(fileName, "not a normal store");
+	}
+	checkHeader(fileName, header, fileSize);
+	buffer_.resize(static_cast<size_t>(header.numSamples) * header.numSteps);
+	is.read(reinterpret_cast<char*>(buffer_.data()), buffer_.size() * sizeof(double));
+	draws_ = buffer_.data();
+#endif
+
+	stream_ = static_cast<RandomStream>(header.stream);
+	seed_ = header.seed;
+	qmcReplications_ = header.qmcReplications;
+	numSamples_ = static_cast<size_t>(header.numSamples);
+	numSteps_ = header.numSteps;
+}
+
+NormalStore::~NormalStore()
+{
+#if !defined(_WIN32)
+	if (mapping_ != nullptr)
+	{
+		::munmap(mapping_, mappingSize_);
+	}
+#endif
+}
+
+std::shared_ptr<const NormalStore> NormalStore::open(const string& fileName)
+{
+	static std::mutex mutex;
+	static std::map<string, std::weak_ptr<const NormalStore> > stores;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	std::shared_ptr<const NormalStore> store = stores[fileName].lock();
+	if (store == nullptr)
+	{
+		store = std::make_shared<const NormalStore>(fileName);
+		stores[fileName] = store;
+	}
+	return store;
+}
+
+void NormalStore::build(const string& fileName, RandomStream stream, int seed, size_t numSamples,
+	unsigned numSteps, unsigned qmcReplications)
+{
+	std::ofstream os(fileName, std::ios::binary | std::ios::trunc);
+	if (!os)
+	{
+		fail(fileName, "cannot be created");
+	}
+
+	Header header = {};
+	std::memcpy(header.magic, magic, sizeof(magic));
+	header.version = formatVersion;
+	header.byteOrder = byteOrderMark;
+	header.stream = static_cast<std::uint32_t>(stream);
+	header.seed = seed;
+	header.numSteps = numSteps;
+	header.qmcReplications = (stream == RandomStream::SOBOL) ? qmcReplications : 0;
+	header.numSamples = numSamples;
+	os.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+
+	// Sample j is drawn exactly as BarrierOption draws scenario j (see forEachScenario_)
+	std::unique_ptr<QuasiRandomNormals> quasiRandom;
+	if (stream == RandomStream::SOBOL)
+	{
+		quasiRandom.reset(new QuasiRandomNormals(numSteps, qmcReplications, seed));
+	}
+	const size_t blockSize = 4096;
+	std::vector<double> block(blockSize * numSteps);
+	for (size_t blockBegin = 0; blockBegin < numSamples; blockBegin += blockSize)
+	{
+		const size_t blockEnd = std::min(numSamples, blockBegin + blockSize);
+		PricingThreadPool::shared().parallelFor(blockBegin, blockEnd, 64, [&](size_t begin, size_t end)
+		{
+			auto draw = [numSteps](auto& normals, double* draws)
+			{
+				for (unsigned s = 0; s < numSteps; ++s)
+				{
+					draws[s] = normals();
+				}
+			};
+			// The cursor only speeds up runs of consecutive Sobol points
+			std::unique_ptr<QuasiRandomNormals::Cursor> cursor;
+			if (quasiRandom != nullptr)
+			{
+				cursor.reset(new QuasiRandomNormals::Cursor(*quasiRandom));
+			}
+			for (size_t j = begin; j < end; ++j)
+			{
+				double* draws = &block[(j - blockBegin) * numSteps];
+				if (stream == RandomStream::PHILOX)
+				{
+					PhiloxNormals normals(seed, j);
+					draw(normals, draws);
+				}
+				else if (stream == RandomStream::MT19937_PER_SCENARIO)
+				{
+					MersenneNormals normals(seed + static_cast<int>(j));
+					draw(normals, draws);
+				}
+				else
+				{
+					const unsigned numReplications = quasiRandom->numReplications();
+					quasiRandom->generate(static_cast<unsigned>(j % numReplications), j / numReplications, *cursor, draws);
+				}
+			}
+		});
+		os.write(reinterpret_cast<const char*>(block.data()), (blockEnd - blockBegin) * numSteps * sizeof(double));
+	}
+
+	if (!os.flush())
+	{
+		fail(fileName, "write failed");
+	}
+}
+
+RandomStream NormalStore::stream() const
+{
+	return stream_;
+}
+
+int NormalStore::seed() const
+{
+	return seed_;
+}
+
+unsigned NormalStore::qmcReplications() const
+{
+	return qmcReplications_;
+}
+
+size_t NormalStore::numSamples() const
+{
+	return numSamples_;
+}
+
+unsigned NormalStore::numSteps() const
+{
+	return numSteps_;
+}
+
+void NormalStore::check(RandomStream stream, int seed, unsigned numSteps, size_t numSamples,
+	unsigned qmcReplications) const
+{
+	std::ostringstream wanted;
+	wanted << streamName(stream) << " seed " << seed << ", " << numSteps << " steps";
+	if (stream != stream_ || seed != seed_ || numSteps != numSteps_
+		|| (stream == RandomStream::SOBOL && qmcReplications != qmcReplications_))
+	{
+		fail(fileName_, "holds " + description() + ", not " + wanted.str());
+	}
+	if (numSamples > numSamples_)
+	{
+		fail(fileName_, "holds " + std::to_string(numSamples_) + " samples, " + std::to_string(numSamples) + " are needed");
+	}
+}
+
+string NormalStore::description() const
+{
+	std::ostringstream os;
+	os << streamName(stream_) << " seed " << seed_ << ", " << numSteps_ << " steps";
+	if (stream_ == RandomStream::SOBOL)
+	{
+		os << " (" << qmcReplications_ << " replications)";
+	}
+	os << ", " << numSamples_ << " samples";
+	return os.str();
+}
@@ -0,0 +1,76 @@
+#ifndef NORMAL_STORE_H
+#define NORMAL_STORE_H
+
+#include "EngineSettings.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// A file of precomputed normal draws, mapped read-only into memory.  Sample j holds the numSteps
+// draws that scenario j (antithetic pair j) would take from the random stream, seed and number
+// of time steps the file was built for, so a run that reads them gets the same values as one
+// that draws them.  The draws are used in place (see StoredNormals), and every process that maps
+// the file shares the one copy in the page cache.
+//
+// The file is a 64-byte header -- "BOPNORM" and a version, a byte-order mark, then the key (stream,
+// seed, qmcReplications for SOBOL, number of samples and of steps) -- followed by the samples, as
+// doubles in the machine's byte order.  Build one with build(.) or the tool in tools/.
+class NormalStore
+{
+public:
+	static const std::uint32_t formatVersion = 1;
+
+	// Maps fileName; throws std::runtime_error if it is not a store of this version and byte
+	// order, or is shorter than its header says
+	explicit NormalStore(const std::string& fileName);
+	~NormalStore();
+
+	NormalStore(const NormalStore&) = delete;
+	NormalStore& operator = (const NormalStore&) = delete;
+
+	// The store of fileName, mapped once per process:  callers naming the same file share the
+	// mapping for as long as any of them holds it
+	static std::shared_ptr<const NormalStore> open(const std::string& fileName);
+
+	// Draws samples [0, numSamples) of stream into fileName.  qmcReplications is used only for
+	// SOBOL (see EngineSettings).  The samples are drawn in blocks on the shared pricing pool.
+	static void build(const std::string& fileName, RandomStream stream, int seed, std::size_t numSamples,
+		unsigned numSteps, unsigned qmcReplications = 16);
+
+	RandomStream stream() const;
+	int seed() const;
+	unsigned qmcReplications() const;	// 0 unless SOBOL
+	std::size_t numSamples() const;
+	unsigned numSteps() const;
+
+	// Sample j's numSteps() draws
+	const double* sample(std::size_t j) const
+	{
+		return draws_ + j * numSteps_;
+	}
+
+	// Throws std::runtime_error unless the store holds at least numSamples samples of stream,
+	// with seed and numSteps (and qmcReplications, for SOBOL)
+	void check(RandomStream stream, int seed, unsigned numSteps, std::size_t numSamples,
+		unsigned qmcReplications) const;
+
+	// The header, for display
+	std::string description() const;
+
+private:
+	std::string fileName_;
+	RandomStream stream_;
+	int seed_;
+	unsigned qmcReplications_;
+	std::size_t numSamples_;
+	unsigned numSteps_;
+
+	void* mapping_;				// The whole file (null where it had to be read into buffer_)
+	std::size_t mappingSize_;
+	std::vector<double> buffer_;
+	const double* draws_;
+};
+
+#endif
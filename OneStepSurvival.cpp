@@ -0,0 +1,268 @@
+#include "OneStepSurvival.h"
+#include "BarrierPayoff.h"
+#include "RandomStreams.h"
+#include "AdjointTape.h"
+#include <cmath>
+#include <limits>
+
+namespace
+{
+	// Second-order forward-mode number in x = log(spot) and vol:  the value, its two first
+	// derivatives and its three second ones
+	struct Jet
+	{
+		double v;
+		double x;
+		double vol;
+		double xx;
+		double xVol;
+		double volVol;
+
+		Jet(double value = 0.0) :v(value), x(0.0), vol(0.0), xx(0.0), xVol(0.0), volVol(0.0) {}
+		Jet(double value, double dx, double dVol, double dxx, double dxVol, double dVolVol) :v(value), x(dx),
+			vol(dVol), xx(dxx), xVol(dxVol), volVol(dVolVol) {}
+	};
+
+	double value(const Jet& a)
+	{
+		return a.v;
+	}
+
+	// f(a), given f, f' and f'' at a.v
+	Jet chain(const Jet& a, double f, double df, double d2f)
+	{
+		return Jet(f, df * a.x, df * a.vol, d2f * a.x * a.x + df * a.xx, d2f * a.x * a.vol + df * a.xVol,
+			d2f * a.vol * a.vol + df * a.volVol);
+	}
+
+	Jet operator+(const Jet& a, const Jet& b)
+	{
+		return Jet(a.v + b.v, a.x + b.x, a.vol + b.vol, a.xx + b.xx, a.xVol + b.xVol, a.volVol + b.volVol);
+	}
+
+	Jet operator-(const Jet& a, const Jet& b)
+	{
+		return Jet(a.v - b.v, a.x - b.x, a.vol - b.vol, a.xx - b.xx, a.xVol - b.xVol, a.volVol - b.volVol);
+	}
+
+	Jet operator*(const Jet& a, const Jet& b)
+	{
+		return Jet(a.v * b.v, a.x * b.v + a.v * b.x, a.vol * b.v + a.v * b.vol,
+			a.xx * b.v + 2.0 * a.x * b.x + a.v * b.xx, a.xVol * b.v + a.x * b.vol + a.vol * b.x + a.v * b.xVol,
+			a.volVol * b.v + 2.0 * a.vol * b.vol + a.v * b.volVol);
+	}
+
+	Jet operator*(double c, const Jet& a)
+	{
+		return Jet(c * a.v, c * a.x, c * a.vol, c * a.xx, c * a.xVol, c * a.volVol);
+	}
+
+	Jet operator/(const Jet& a, const Jet& b)
+	{
+		double inverse = 1.0 / b.v;
+		return a * chain(b, inverse, -inverse * inverse, 2.0 * inverse * inverse * inverse);
+	}
+
+	Jet exp(const Jet& a)
+	{
+		double e = std::exp(a.v);
+		return chain(a, e, e, e);
+	}
+
+	Jet log(const Jet& a)
+	{
+		double inverse = 1.0 / a.v;
+		return chain(a, std::log(a.v), inverse, -inverse * inverse);
+	}
+
+	const double invSqrt2 = 0.70710678118654752440;
+	const double invSqrt2Pi = 0.39894228040143267794;
+
+	// Standard normal distribution function, and its inverse
+	Jet N(const Jet& a)
+	{
+		double density = invSqrt2Pi * std::exp(-0.5 * a.v * a.v);
+		return chain(a, 0.5 * std::erfc(-a.v * invSqrt2), density, -a.v * density);
+	}
+
+	Jet inverseN(const Jet& a)
+	{
+		double density;
+		double z = inverseCumulativeNormal(a.v, density);
+		return chain(a, z, 1.0 / density, z / (density * density));
+	}
+
+	// The same on the adjoint tape
+	double value(const ADouble& a)
+	{
+		return a.value();
+	}
+
+	ADouble N(const ADouble& a)
+	{
+		return unaryResult(a, 0.5 * std::erfc(-a.value() * invSqrt2), invSqrt2Pi * std::exp(-0.5 * a.value() * a.value()));
+	}
+
+	ADouble inverseN(const ADouble& a)
+	{
+		double density;
+		double z = inverseCumulativeNormal(a.value(), density);
+		return unaryResult(a, z, 1.0 / density);
+	}
+
+	// Beyond this many standard deviations from the barrier a step survives with probability 1 in
+	// double precision (1 - N(8.3) < 2^-53), and is drawn unconditioned
+	const double farFromBarrier = 8.3;
+
+	// E[payoff(exp(y)); lo < y < hi] for y ~ N(mean, sd^2):  hi = +inf and lo = -inf are allowed
+	template <typename Real>
+	Real vanillaOver(OptionType optionType, const Real& strike, const Real& mean, const Real& sd, Real lo, Real hi)
+	{
+		const double infinity = std::numeric_limits<double>::infinity();
+		const Real logStrike = log(strike);
+		if (optionType == OptionType::CALL)
+		{
+			lo = (value(lo) > value(logStrike)) ? lo : logStrike;
+		}
+		else
+		{
+			hi = (value(hi) < value(logStrike)) ? hi : logStrike;
+		}
+		if (value(lo) >= value(hi))
+		{
+			return Real(0.0);
+		}
+
+		// P(lo < y + shift < hi) for y ~ N(mean, sd^2)
+		const Real variance = sd * sd;
+		auto probability = [&](const Real& shift)
+		{
+			Real upper = (value(hi) == infinity) ? Real(1.0) : N((hi - mean - shift) / sd);
+			Real lower = (value(lo) == -infinity) ? Real(0.0) : N((lo - mean - shift) / sd);
+			return upper - lower;
+		};
+		const Real forward = exp(mean + 0.5 * variance);
+		const Real terminal = forward * probability(variance);
+		const Real exercise = strike * probability(Real(0.0));
+		return (optionType == OptionType::CALL) ? terminal - exercise : exercise - terminal;
+	}
+
+	// The one-step-survival estimate from one path's draws, undiscounted, as a function of the
+	// inputs in whatever number type carries their derivatives
+	template <typename Real>
+	Real pathValue(Barrier barrierType, OptionType optionType, const Real& logSpot, const Real& vol, const Real& rate,
+		const Real& strike, const Real& logBarrier, double dt, unsigned numSteps, const double* draws)
+	{
+		const double infinity = std::numeric_limits<double>::infinity();
+		const double up = isUpBarrier(barrierType) ? 1.0 : -1.0;
+		const bool knockIn = isKnockIn(barrierType);
+		const Real vanilla = knockIn ? vanillaOver(optionType, strike, logSpot + (dt * numSteps) * rate
+			- (0.5 * dt * numSteps) * (vol * vol), std::sqrt(dt * numSteps) * vol, Real(-infinity), Real(infinity))
+			: Real(0.0);
+		if (up * (value(logSpot) - value(logBarrier)) >= 0.0)
+		{
+			return vanilla;	// Knocked in or out today
+		}
+
+		const Real stepDrift = dt * rate - (0.5 * dt) * (vol * vol);
+		const Real stepSd = std::sqrt(dt) * vol;
+
+		// The path is tracked as its distance from the barrier in standard deviations of a step, on
+		// the surviving side, so that a step near the barrier is six operations on it:  the step's
+		// mean, its survival probability, and the conditioned draw, are all in those units
+		const Real driftTowards = (up * stepDrift) / stepSd;
+		Real distance = (up * (logBarrier - logSpot)) / stepSd;
+
+		// Steps far from the barrier only move the path, so only the value of its distance is tracked
+		// there:  distance catches up (by the farSteps and farDraws since it was last brought up to
+		// date) before the next step near the barrier
+		double distanceValue = value(distance);
+		unsigned farSteps = 0;
+		double farDraws = 0.0;
+		Real survival = Real(1.0);
+		for (unsigned step = 1; step < numSteps; ++step)
+		{
+			const double z = draws[step - 1];
+			const double meanValue = distanceValue - value(driftTowards);
+			if (meanValue > farFromBarrier)
+			{
+				distanceValue = meanValue - up * z;
+				++farSteps;
+				farDraws += z;
+				continue;
+			}
+
+			if (farSteps > 0)
+			{
+				distance = distance - (double(farSteps) * driftTowards + up * farDraws);
+				farSteps = 0;
+				farDraws = 0.0;
+			}
+
+			// Survive this step with probability p, and draw the step from the normal conditioned
+			// on surviving it, by mapping z into the surviving part of the distribution
+			const Real mean = distance - driftTowards;
+			const Real p = N(mean);
+			survival = survival * p;
+			const double u = 0.5 * std::erfc(-up * z * invSqrt2);
+			distance = mean - inverseN(u * p);
+			distanceValue = value(distance);
+		}
+		if (farSteps > 0)
+		{
+			distance = distance - (double(farSteps) * driftTowards + up * farDraws);
+		}
+		const Real x = logBarrier - (up * distance) * stepSd;
+
+		// The last step in closed form, over the part of the distribution that survives it
+		const Real mean = x + stepDrift;
+		const Real lo = (up > 0.0) ? Real(-infinity) : logBarrier;
+		const Real hi = (up > 0.0) ? logBarrier : Real(infinity);
+		const Real out = survival * vanillaOver(optionType, strike, mean, stepSd, lo, hi);
+		return knockIn ? vanilla - out : out;
+	}
+}
+
+OneStepSurvival::OneStepSurvival(Barrier barrierType, OptionType optionType, double barrierLevel, double strike,
+	double spot, double drift, double vol, double timeToExpiry, unsigned numSteps, BarrierMonitoring monitoring,
+	double monitoringInterval) :barrierType_(barrierType), optionType_(optionType), barrierLevel_(barrierLevel),
+	strike_(strike), spot_(spot), drift_(drift), vol_(vol), dt_(timeToExpiry / numSteps), numSteps_(numSteps),
+	barrierVolShift_(0.0)
+{
+	if (monitoring != BarrierMonitoring::DISCRETE)
+	{
+		// The continuous barrier, then back to a barrier monitored at the steps (both shifts are
+		// proportional to vol)
+		double shift = broadieGlassermanBeta * (std::sqrt(monitoringInterval) - std::sqrt(dt_));
+		barrierVolShift_ = isUpBarrier(barrierType) ? shift : -shift;
+	}
+}
+
+OneStepSurvival::Sensitivities OneStepSurvival::operator()(const double* draws) const
+{
+	const Jet logSpot(std::log(spot_), 1.0, 0.0, 0.0, 0.0, 0.0);
+	const Jet vol(vol_, 0.0, 1.0, 0.0, 0.0, 0.0);
+	const Jet logBarrier(std::log(barrierLevel_) + barrierVolShift_ * vol_, 0.0, barrierVolShift_, 0.0, 0.0, 0.0);
+	const Jet v = pathValue(barrierType_, optionType_, logSpot, vol, Jet(drift_), Jet(strike_), logBarrier, dt_,
+		numSteps_, draws);
+	return Sensitivities{ v.v, v.x / spot_, v.vol, (v.xx - v.x) / (spot_ * spot_), v.xVol / spot_, v.volVol };
+}
+
+OneStepSurvival::Adjoints OneStepSurvival::adjoints(const double* draws) const
+{
+	AdjointTape& tape = AdjointTape::local();
+	const std::size_t mark = tape.mark();
+	const ADouble spot = tape.variable(spot_);
+	const ADouble vol = tape.variable(vol_);
+	const ADouble rate = tape.variable(drift_);
+	const ADouble strike = tape.variable(strike_);
+	const ADouble barrier = tape.variable(barrierLevel_);
+
+	const ADouble v = pathValue(barrierType_, optionType_, log(spot), vol, rate, strike,
+		log(barrier) + barrierVolShift_ * vol, dt_, numSteps_, draws);
+	tape.propagate(v);
+	const Adjoints result{ v.value(), tape.adjoint(spot), tape.adjoint(vol), tape.adjoint(rate), tape.adjoint(strike),
+		tape.adjoint(barrier) };
+	tape.rewind(mark);
+	return result;
+}
@@ -0,0 +1,73 @@
+#ifndef ONE_STEP_SURVIVAL_H
+#define ONE_STEP_SURVIVAL_H
+
+#include "ResultSet.h"
+#include "EngineSettings.h"
+
+// Second-order sensitivities of a single-barrier option from one path's draws, by one-step
+// survival (Glasserman and Staum, "Conditioning on One-Step Survival for Barrier Option
+// Simulations", 2001).  Each step of a knock-out path is drawn from the normal conditioned on not
+// crossing the barrier, and the path is weighted by the product of those survival probabilities;
+// the last step is integrated in closed form.  The estimate is then a smooth function of spot and
+// volatility, so its pathwise derivatives (carried along the path in forward mode) are unbiased
+// even though the payoff itself jumps at the barrier:  bumping and repricing a discontinuous
+// payoff, or the likelihood-ratio weights over hundreds of short steps, are far noisier.
+//
+// A knock-in is the vanilla option (in closed form) less the knock-out.  Only the steps that can
+// reach the barrier (survival probability below 1 in double precision) pay for the conditioning.
+class OneStepSurvival
+{
+public:
+	// Undiscounted estimates from one path, per unit
+	struct Sensitivities
+	{
+		double value;
+		double delta;
+		double vega;
+		double gamma;
+		double vanna;	// d2/dspot dvol
+		double volga;	// d2/dvol2
+	};
+
+	// drift:  the risk-free rate; the path has numSteps equal steps to timeToExpiry.  monitoring
+	// as in EngineSettings:  with BRIDGE_WEIGHT or BRIDGE_SAMPLED, the continuously monitored
+	// barrier (shifted for monitoringInterval, if not 0) is monitored at the steps, moved towards
+	// the spot by the Broadie-Glasserman shift for a step.
+	OneStepSurvival(Barrier barrierType, OptionType optionType, double barrierLevel, double strike, double spot,
+		double drift, double vol, double timeToExpiry, unsigned numSteps, BarrierMonitoring monitoring,
+		double monitoringInterval);
+
+	// Undiscounted first-order estimates from one path, per unit:  rho is the derivative in the
+	// drift, strike and barrier those in the strike and barrier level
+	struct Adjoints
+	{
+		double value;
+		double delta;
+		double vega;
+		double rho;
+		double strike;
+		double barrier;
+	};
+
+	// draws:  the path's numSteps standard normal draws (the last step is integrated, so its draw
+	// is not used)
+	Sensitivities operator()(const double* draws) const;
+
+	// The same path by adjoint differentiation, on this thread's AdjointTape (rewound afterwards):
+	// every first-order sensitivity for a few times the cost of the value alone
+	Adjoints adjoints(const double* draws) const;
+
+private:
+	Barrier barrierType_;
+	OptionType optionType_;
+	double barrierLevel_;
+	double strike_;
+	double spot_;
+	double drift_;
+	double vol_;
+	double dt_;
+	unsigned numSteps_;
+	double barrierVolShift_;	// d log(monitored barrier) / d vol (non-zero for the continuous barrier)
+};
+
+#endif
@@ -0,0 +1,251 @@
+#include "PortfolioPricer.h"
+#include "EquityPriceGenerator.h"
+#include "BarrierPayoff.h"
+#include "RandomStreams.h"
+#include "NormalStore.h"
+#include <map>
+#include <tuple>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+using std::vector;
+using std::size_t;
+using std::exp;
+
+namespace
+{
+	// Base, spot-up, vol-up and rate-up market states, as in BarrierOption::computeSinglePass_()
+	enum { BASE, SPOT_UP, VOL_UP, RATE_UP, NUM_STATES };
+
+	// Per trade running totals:  the discounted payoff of each state, and the base payoff squared
+	enum { SUM_SQ_BASE = NUM_STATES, NUM_TOTALS };
+
+	// The shift of a vol or rate level in the VOL_UP and RATE_UP states, as BarrierOption::bump_:
+	// greekShift relative to the level, or absolute at a level of 0
+	double bump(double level, double greekShift)
+	{
+		return (level != 0.0) ? level * greekShift : greekShift;
+	}
+
+	// Tracks a path's running maximum and minimum and its last price:  with the barrier monitored
+	// at every price, these fix the payoff of any single-barrier trade on the path.  The path ends
+	// once every knock-out in the group is out, unless the group holds a knock-in.
+	class PathExtremes
+	{
+	public:
+		// highestUpOut and lowestDownOut:  the extreme knock-out barriers in the group (-inf and
+		// +inf if there are none)
+		PathExtremes(double highestUpOut, double lowestDownOut, bool runToExpiry) :highestUpOut_(highestUpOut),
+			lowestDownOut_(lowestDownOut), runToExpiry_(runToExpiry), max_(-std::numeric_limits<double>::infinity()),
+			min_(std::numeric_limits<double>::infinity()), lastPrice_(0.0) {}
+
+		bool operator()(double price)
+		{
+			max_ = std::max(max_, price);
+			min_ = std::min(min_, price);
+			lastPrice_ = price;
+			return runToExpiry_ || max_ < highestUpOut_ || min_ > lowestDownOut_;
+		}
+
+		// Undiscounted payoff of trade, valid once the path has ended
+		double payoff(const BarrierTrade& trade) const
+		{
+			double extreme = isUpBarrier(trade.barrierType) ? max_ : min_;
+			return barrierPayoff(trade.barrierType, trade.optionType, trade.strike, lastPrice_,
+				barrierHit(trade.barrierType, trade.barrierLevel, extreme));
+		}
+
+	private:
+		double highestUpOut_;
+		double lowestDownOut_;
+		bool runToExpiry_;
+		double max_;
+		double min_;
+		double lastPrice_;
+	};
+}
+
+PortfolioPricer::PortfolioPricer(unsigned numScenarios, int seed, double greekShift, const Act365& dc,
+	PricingThreadPool* executor, const EngineSettings& settings) :numScenarios_(numScenarios), seed_(seed),
+	greekShift_(greekShift), dc_(dc), executor_(executor), settings_(settings) {}
+
+OptionResultTable PortfolioPricer::table(const vector<BarrierTrade>& trades) const
+{
+	OptionResultTable results(trades.size());
+	for (const vector<size_t>& group : groups_(trades))
+	{
+		priceGroup_(trades, group, results);
+	}
+	return results;
+}
+
+vector<OptionResults> PortfolioPricer::operator()(const vector<BarrierTrade>& trades) const
+{
+	const OptionResultTable results = table(trades);
+	vector<OptionResults> rows(results.size());
+	for (size_t t = 0; t < results.size(); ++t)
+	{
+		rows[t] = results.results(t);
+	}
+	return rows;
+}
+
+size_t PortfolioPricer::numPathSets(const vector<BarrierTrade>& trades) const
+{
+	return groups_(trades).size();
+}
+
+vector<vector<size_t> > PortfolioPricer::groups_(const vector<BarrierTrade>& trades) const
+{
+	// Keyed on exactly the inputs to the path generator
+	typedef std::tuple<double, double, double, double, unsigned> PathSet;
+	std::map<PathSet, vector<size_t> > groups;
+	for (size_t t = 0; t < trades.size(); ++t)
+	{
+		const BarrierTrade& trade = trades[t];
+		groups[PathSet(trade.spot, trade.riskFreeRate, trade.volatility,
+			dc_.yearFraction(trade.valueDate, trade.expiryDate), trade.numTimeSteps)].push_back(t);
+	}
+
+	vector<vector<size_t> > result;
+	for (auto& group : groups)
+	{
+		result.push_back(std::move(group.second));
+	}
+	return result;
+}
+
+void PortfolioPricer::priceGroup_(const vector<BarrierTrade>& trades, const vector<size_t>& group,
+	OptionResultTable& results) const
+{
+	const BarrierTrade& market = trades[group.front()];
+	const double tau = dc_.yearFraction(market.valueDate, market.expiryDate);
+	const double up = 1.0 + greekShift_;
+	const double volUp = market.volatility + bump(market.volatility, greekShift_);
+	const double rateUp = market.riskFreeRate + bump(market.riskFreeRate, greekShift_);
+	const EquityPriceGenerator generators[NUM_STATES] = {
+		EquityPriceGenerator(market.spot, market.numTimeSteps, tau, market.riskFreeRate, market.volatility),
+		EquityPriceGenerator(market.spot * up, market.numTimeSteps, tau, market.riskFreeRate, market.volatility),
+		EquityPriceGenerator(market.spot, market.numTimeSteps, tau, market.riskFreeRate, volUp),
+		EquityPriceGenerator(market.spot, market.numTimeSteps, tau, rateUp, market.volatility) };
+
+	// Each trade's discount factor in each state (trades may settle on different dates), and the
+	// knock-outs that decide when a path can stop
+	const size_t numTrades = group.size();
+	vector<double> discountFactors(NUM_STATES * numTrades);
+	double highestUpOut = -std::numeric_limits<double>::infinity();
+	double lowestDownOut = std::numeric_limits<double>::infinity();
+	bool runToExpiry = false;
+	for (size_t j = 0; j < numTrades; ++j)
+	{
+		const BarrierTrade& trade = trades[group[j]];
+		if (isKnockIn(trade.barrierType))
+		{
+			runToExpiry = true;
+		}
+		else if (isUpBarrier(trade.barrierType))
+		{
+			highestUpOut = std::max(highestUpOut, trade.barrierLevel);
+		}
+		else
+		{
+			lowestDownOut = std::min(lowestDownOut, trade.barrierLevel);
+		}
+
+		double settlement = dc_.yearFraction(trade.valueDate, trade.settlementDate);
+		double df = exp(-settlement * market.riskFreeRate);
+		discountFactors[NUM_STATES * j + BASE] = df;
+		discountFactors[NUM_STATES * j + SPOT_UP] = df;
+		discountFactors[NUM_STATES * j + VOL_UP] = df;
+		discountFactors[NUM_STATES * j + RATE_UP] = exp(-settlement * rateUp);
+	}
+
+	// Precomputed draws, if settings_ names a store:  it must fit this group's time grid
+	std::shared_ptr<const NormalStore> store;
+	if (!settings_.normalStore.empty())
+	{
+		store = NormalStore::open(settings_.normalStore);
+		store->check(settings_.randomStream, seed_, market.numTimeSteps, numScenarios_, settings_.qmcReplications);
+	}
+
+	// Totals per chunk of scenarios, added up in chunk order afterwards, so that the values do
+	// not depend on the number of threads
+	const size_t numChunks = (numScenarios_ + scenarioChunkSize_ - 1) / scenarioChunkSize_;
+	vector<double> chunkTotals(numChunks * numTrades * NUM_TOTALS, 0.0);
+
+	auto priceChunk = [&](size_t begin, size_t end)
+	{
+		double* totals = &chunkTotals[(begin / scenarioChunkSize_) * numTrades * NUM_TOTALS];
+		auto simulate = [&](auto& normals)
+		{
+			const PathExtremes start(highestUpOut, lowestDownOut, runToExpiry);
+			PathExtremes states[NUM_STATES] = { start, start, start, start };
+			EquityPriceGenerator::simulateCommon(normals, generators, states, NUM_STATES);
+
+			for (size_t j = 0; j < numTrades; ++j)
+			{
+				const BarrierTrade& trade = trades[group[j]];
+				double* tradeTotals = totals + NUM_TOTALS * j;
+				for (int k = 0; k < NUM_STATES; ++k)
+				{
+					tradeTotals[k] += discountFactors[NUM_STATES * j + k] * states[k].payoff(trade);
+				}
+				double base = discountFactors[NUM_STATES * j + BASE] * states[BASE].payoff(trade);
+				tradeTotals[SUM_SQ_BASE] += base * base;
+			}
+		};
+
+		for (size_t i = begin; i < end; ++i)
+		{
+			if (store)
+			{
+				StoredNormals normals(store->sample(i));
+				simulate(normals);
+			}
+			else if (settings_.randomStream == RandomStream::MT19937_PER_SCENARIO)
+			{
+				MersenneNormals normals(seed_ + static_cast<int>(i));
+				simulate(normals);
+			}
+			else
+			{
+				PhiloxNormals normals(seed_, i);
+				simulate(normals);
+			}
+		}
+	};
+
+	PricingThreadPool& pool = (executor_ != nullptr) ? *executor_ : PricingThreadPool::shared();
+	pool.parallelFor(0, numScenarios_, scenarioChunkSize_, priceChunk);
+
+	const double n = numScenarios_;
+	for (size_t j = 0; j < numTrades; ++j)
+	{
+		const BarrierTrade& trade = trades[group[j]];
+		double totals[NUM_TOTALS] = { 0.0, 0.0, 0.0, 0.0, 0.0 };
+		for (size_t c = 0; c < numChunks; ++c)
+		{
+			for (int k = 0; k < NUM_TOTALS; ++k)
+			{
+				totals[k] += chunkTotals[(c * numTrades + j) * NUM_TOTALS + k];
+			}
+		}
+
+		double prices[NUM_STATES];
+		for (int k = 0; k < NUM_STATES; ++k)
+		{
+			prices[k] = trade.quantity * totals[k] / n;
+		}
+		double mean = totals[BASE] / n;
+		double variance = (n > 1.0) ? std::max(totals[SUM_SQ_BASE] - n * mean * mean, 0.0) / (n - 1.0) : 0.0;
+
+		const size_t row = group[j];
+		results(row, OptionResults::PRICE) = prices[BASE];
+		results(row, OptionResults::DELTA) = (prices[SPOT_UP] - prices[BASE]) / (trade.spot * greekShift_);
+		results(row, OptionResults::VEGA) = (prices[VOL_UP] - prices[BASE]) / bump(trade.volatility, greekShift_);
+		results(row, OptionResults::RHO) = (prices[RATE_UP] - prices[BASE]) / bump(trade.riskFreeRate, greekShift_);
+		results(row, OptionResults::STD_ERROR) = std::abs(trade.quantity) * std::sqrt(variance / n);
+		results(row, OptionResults::NUM_SCENARIOS) = n;
+	}
+}
@@ -0,0 +1,86 @@
+#ifndef PORTFOLIO_PRICER_H
+#define PORTFOLIO_PRICER_H
+
+#include "Date.h"
+#include "DayCount.h"
+#include "ResultSet.h"
+#include "ResultTable.h"
+#include "PricingThreadPool.h"
+#include "EngineSettings.h"
+#include <vector>
+
+// The terms of one single-barrier trade, and the market and time grid it is to be priced on
+// (the same inputs as a BarrierOption)
+struct BarrierTrade
+{
+	BarrierTrade(double barrierLevel, double strike, double spot, double riskFreeRate, double volatility,
+		double quantity, Barrier barrierType, OptionType optionType, const Date& valueDate, const Date& expiryDate,
+		const Date& settlementDate, unsigned numTimeSteps) :barrierLevel(barrierLevel), strike(strike), spot(spot),
+		riskFreeRate(riskFreeRate), volatility(volatility), quantity(quantity), barrierType(barrierType),
+		optionType(optionType), valueDate(valueDate), expiryDate(expiryDate), settlementDate(settlementDate),
+		numTimeSteps(numTimeSteps) {}
+
+	double barrierLevel;
+	double strike;
+	double spot;
+	double riskFreeRate;
+	double volatility;
+	double quantity;
+	Barrier barrierType;
+	OptionType optionType;
+	Date valueDate;
+	Date expiryDate;
+	Date settlementDate;
+	unsigned numTimeSteps;
+};
+
+// Prices a book of barrier trades by Monte Carlo, sharing the paths between trades.  The trades
+// are grouped by market (spot, rate, volatility) and time grid (time to expiry, number of steps);
+// each group's paths are generated once, in parallel blocks of scenarios.  Since the barrier is
+// monitored at every time step, a path's running maximum, minimum and terminal price fix every
+// trade's payoff:  the time steps track only those, and the trades are evaluated once per path.
+// A path stops once every knock-out in the group is out (unless the group holds a knock-in).  So
+// the cost grows with the number of paths per group, not paths x trades.
+//
+// Delta, vega and rho are single-pass forward differences, as with GreeksMethod::SINGLE_PASS:  the
+// bumped market states run off the same draws.  Scenario i of a trade draws from the same stream
+// (settings.randomStream:  PHILOX or MT19937_PER_SCENARIO) as it would in a BarrierOption with the
+// same seed, so a trade gets the same values as a BarrierOption with the default engine settings
+// (to rounding).  The barrier is monitored at the time steps, and no control variate is used.
+// With settings.normalStore, the draws are read from the store instead (see NormalStore.h); each
+// group's time grid must match it, or operator() throws std::runtime_error.
+class PortfolioPricer
+{
+public:
+	// executor:  pool used for the path blocks; if null, the process-wide shared pool is used.
+	// The pool is not owned and must outlive the PortfolioPricer.
+	PortfolioPricer(unsigned numScenarios, int seed, double greekShift, const Act365& dc,
+		PricingThreadPool* executor = nullptr, const EngineSettings& settings = EngineSettings());
+
+	// One row per trade, in the order given:  price, delta, vega, rho, standard error and scenarios
+	OptionResultTable table(const std::vector<BarrierTrade>& trades) const;
+
+	// The same rows, as OptionResults
+	std::vector<OptionResults> operator()(const std::vector<BarrierTrade>& trades) const;
+
+	// Number of distinct path sets (market and time grid) among trades
+	std::size_t numPathSets(const std::vector<BarrierTrade>& trades) const;
+
+private:
+	// Prices trades[group[0]], trades[group[1]], ..., which share a market and time grid
+	void priceGroup_(const std::vector<BarrierTrade>& trades, const std::vector<std::size_t>& group,
+		OptionResultTable& results) const;
+
+	// The trades' indices, grouped by market and time grid
+	std::vector<std::vector<std::size_t> > groups_(const std::vector<BarrierTrade>& trades) const;
+
+	unsigned numScenarios_;
+	int seed_;
+	double greekShift_;
+	Act365 dc_;
+	PricingThreadPool* executor_;
+	EngineSettings settings_;
+	static const unsigned scenarioChunkSize_ = 64;	// Scenarios per unit of work handed to the pool
+};
+
+#endif
@@ -0,0 +1,192 @@
+#include "PricingThreadPool.h"
+#include <algorithm>
+
+using std::size_t;
+using std::vector;
+using std::mutex;
+using std::lock_guard;
+using std::unique_lock;
+using std::function;
+using std::thread;
+using std::min;
+using std::max;
+
+PricingThreadPool::PricingThreadPool(unsigned numThreads) :pending_(0), nextQueue_(0), stop_(false)
+{
+	// hardware_concurrency() may return 0 when it cannot tell; fall back to the calling thread only.
+	unsigned numWorkers = (numThreads > 1) ? numThreads - 1 : 0;
+
+	// One queue per worker plus one for chunks pushed while no worker is idle.
+	for (unsigned i = 0; i <= numWorkers; ++i)
+	{
+		queues_.push_back(std::unique_ptr<WorkQueue>(new WorkQueue));
+	}
+
+	for (unsigned i = 0; i < numWorkers; ++i)
+	{
+		workers_.push_back(thread(&PricingThreadPool::workerLoop_, this, i));
+	}
+}
+
+PricingThreadPool::~PricingThreadPool()
+{
+	{
+		lock_guard<mutex> lock(sleepMutex_);
+		stop_ = true;
+	}
+	wake_.notify_all();
+
+	for (auto& worker : workers_)
+	{
+		worker.join();
+	}
+}
+
+unsigned PricingThreadPool::numThreads() const
+{
+	return static_cast<unsigned>(workers_.size()) + 1;
+}
+
+PricingThreadPool& PricingThreadPool::shared()
+{
+	static PricingThreadPool pool;		// Thread-safe initialization since C++11
+	return pool;
+}
+
+void PricingThreadPool::parallelFor(size_t begin, size_t end, size_t chunkSize,
+	const function<void(size_t, size_t)>& task)
+{
+	if (begin >= end)
+	{
+		return;
+	}
+
+	chunkSize = max<size_t>(chunkSize, 1);
+	size_t numChunks = (end - begin + chunkSize - 1) / chunkSize;
+
+	// Nothing to share:  skip the queues altogether.
+	if (workers_.empty() || numChunks == 1)
+	{
+		for (size_t b = begin; b < end; b += chunkSize)
+		{
+			task(b, min(b + chunkSize, end));
+		}
+		return;
+	}
+
+	Job job;
+	job.task = &task;
+	job.remaining = numChunks;
+
+	// Counted before they are queued:  a worker may pick a chunk up (and take it off pending_)
+	// as soon as it is pushed
+	{
+		lock_guard<mutex> lock(sleepMutex_);
+		pending_ += numChunks;
+	}
+
+	// Deal the chunks out round-robin so that every worker starts with local work;
+	// stealing evens things out when paths knock out early or a core is busy.
+	size_t queueIndex = nextQueue_++;
+	for (size_t b = begin; b < end; b += chunkSize)
+	{
+		WorkQueue& queue = *queues_[queueIndex++ % queues_.size()];
+		lock_guard<mutex> lock(queue.mutex);
+		queue.chunks.push_back(Chunk{ &job, b, min(b + chunkSize, end) });
+	}
+	wake_.notify_all();
+
+	// The calling thread works too, rather than just blocking.  It uses the overflow queue
+	// as its own, so it also picks up chunks from nested calls made inside a task.
+	Chunk chunk;
+	while (job.remaining > 0 && tryPop_(queues_.size() - 1, chunk))
+	{
+		run_(chunk);
+	}
+
+	{
+		unique_lock<mutex> lock(job.mutex);
+		job.done.wait(lock, [&job] { return job.remaining == 0; });
+	}
+
+	if (job.error)
+	{
+		std::rethrow_exception(job.error);
+	}
+}
+
+void PricingThreadPool::workerLoop_(size_t index)
+{
+	Chunk chunk;
+	while (true)
+	{
+		if (tryPop_(index, chunk))
+		{
+			run_(chunk);
+			continue;
+		}
+
+		unique_lock<mutex> lock(sleepMutex_);
+		wake_.wait(lock, [this] { return stop_ || pending_ > 0; });
+		if (stop_ && pending_ == 0)
+		{
+			return;
+		}
+	}
+}
+
+bool PricingThreadPool::tryPop_(size_t index, Chunk& chunk)
+{
+	size_t numQueues = queues_.size();
+
+	for (size_t i = 0; i < numQueues; ++i)
+	{
+		WorkQueue& queue = *queues_[(index + i) % numQueues];
+		lock_guard<mutex> lock(queue.mutex);
+		if (queue.chunks.empty())
+		{
+			continue;
+		}
+
+		if (i == 0)
+		{
+			chunk = queue.chunks.back();	// Own queue:  most recently pushed (still warm in cache)
+			queue.chunks.pop_back();
+		}
+		else
+		{
+			chunk = queue.chunks.front();	// Steal the oldest chunk from the victim
+			queue.chunks.pop_front();
+		}
+		--pending_;
+		return true;
+	}
+
+	return false;
+}
+
+void PricingThreadPool::run_(const Chunk& chunk)
+{
+	Job& job = *chunk.job;
+
+	try
+	{
+		(*job.task)(chunk.begin, chunk.end);
+	}
+	catch (...)
+	{
+		lock_guard<mutex> lock(job.mutex);
+		if (!job.error)
+		{
+			job.error = std::current_exception();
+		}
+	}
+
+	// Take the job's mutex before the final decrement so that parallelFor(.) cannot
+	// see remaining == 0 and destroy the job while we are still notifying.
+	lock_guard<mutex> lock(job.mutex);
+	if (--job.remaining == 0)
+	{
+		job.done.notify_all();
+	}
+}
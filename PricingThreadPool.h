@@ -0,0 +1,78 @@
+#ifndef PRICING_THREAD_POOL_H
+#define PRICING_THREAD_POOL_H
+
+#include <cstddef>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <exception>
+#include <memory>
+
+// A fixed-size pool of pricing threads.  Work is submitted as a range of scenario indices
+// which is cut into chunks; each worker owns a queue of chunks and, once its own queue is
+// empty, steals from the other workers.  The pool is meant to live for the whole run and be
+// shared by every BarrierOption, so that we pay for thread creation once rather than once per path.
+class PricingThreadPool
+{
+public:
+	// numThreads is the total concurrency, including the thread that calls parallelFor(.);
+	// so PricingThreadPool(1) starts no workers and runs everything on the calling thread.
+	explicit PricingThreadPool(unsigned numThreads = std::thread::hardware_concurrency());
+	~PricingThreadPool();
+
+	PricingThreadPool(const PricingThreadPool&) = delete;
+	PricingThreadPool& operator = (const PricingThreadPool&) = delete;
+
+	unsigned numThreads() const;
+
+	// Runs task(chunkBegin, chunkEnd) over [begin, end) in chunks of at most chunkSize indices.
+	// The calling thread helps with the work and the call returns once every chunk is done.
+	// If a task throws, the first exception is rethrown here after the remaining chunks finish.
+	void parallelFor(std::size_t begin, std::size_t end, std::size_t chunkSize,
+		const std::function<void(std::size_t, std::size_t)>& task);
+
+	// Process-wide pool (sized to the hardware) used when no executor is supplied
+	static PricingThreadPool& shared();
+
+private:
+	struct Job
+	{
+		const std::function<void(std::size_t, std::size_t)>* task;
+		std::atomic<std::size_t> remaining;
+		std::mutex mutex;
+		std::condition_variable done;
+		std::exception_ptr error;
+	};
+
+	struct Chunk
+	{
+		Job* job;
+		std::size_t begin;
+		std::size_t end;
+	};
+
+	struct WorkQueue
+	{
+		std::mutex mutex;
+		std::deque<Chunk> chunks;
+	};
+
+	void workerLoop_(std::size_t index);
+	bool tryPop_(std::size_t index, Chunk& chunk);	// own queue first (LIFO), then steal (FIFO)
+	void run_(const Chunk& chunk);
+
+	std::vector<std::unique_ptr<WorkQueue> > queues_;
+	std::vector<std::thread> workers_;
+
+	std::mutex sleepMutex_;
+	std::condition_variable wake_;
+	std::atomic<std::size_t> pending_;		// Chunks queued but not yet picked up
+	std::atomic<std::size_t> nextQueue_;	// Round-robin start for distributing a new job
+	bool stop_;
+};
+
+#endif
@@ -0,0 +1,66 @@
+#include "QuasiRandomNormals.h"
+#include "RandomStreams.h"
+#include <cassert>
+
+using std::uint32_t;
+using std::uint64_t;
+
+QuasiRandomNormals::QuasiRandomNormals(unsigned numSteps, unsigned numReplications, int seed) :sobol_(numSteps),
+	bridge_(numSteps), numReplications_(numReplications), shifts_(numReplications * numSteps)
+{
+	assert(numReplications > 0);
+
+	// Shift words from Philox on their own stream (counter word 3 = 1), so that they never
+	// coincide with the pseudo-random path draws for the same seed.
+	for (unsigned r = 0; r < numReplications_; ++r)
+	{
+		for (unsigned d = 0; d < numSteps; d += 4)
+		{
+			Philox4x32::Block b = Philox4x32::generate(d / 4, r, 0u, 1u, static_cast<uint32_t>(seed), 0u);
+			for (unsigned i = 0; i < 4 && d + i < numSteps; ++i)
+			{
+				shifts_[r * numSteps + d + i] = b.v[i];
+			}
+		}
+	}
+}
+
+unsigned QuasiRandomNormals::numSteps() const
+{
+	return sobol_.dimension();
+}
+
+unsigned QuasiRandomNormals::numReplications() const
+{
+	return numReplications_;
+}
+
+QuasiRandomNormals::Cursor::Cursor(const QuasiRandomNormals& qrn) :point_(qrn.numSteps()), normals_(qrn.numSteps()),
+	index_(0), valid_(false) {}
+
+void QuasiRandomNormals::generate(unsigned replication, uint64_t index, Cursor& cursor, double* increments) const
+{
+	assert(replication < numReplications_);
+	const unsigned numSteps = sobol_.dimension();
+
+	if (cursor.valid_ && index == cursor.index_ + 1)
+	{
+		sobol_.next(index, cursor.point_.data());
+	}
+	else if (!cursor.valid_ || index != cursor.index_)
+	{
+		sobol_.point(index, cursor.point_.data());
+	}
+	cursor.index_ = index;
+	cursor.valid_ = true;
+
+	// Shift, then take the midpoint of the 2^-32 cell so that u is never 0 or 1
+	const uint32_t* shift = &shifts_[replication * numSteps];
+	for (unsigned d = 0; d < numSteps; ++d)
+	{
+		double u = (static_cast<double>(cursor.point_[d] ^ shift[d]) + 0.5) * (1.0 / 4294967296.0);
+		cursor.normals_[d] = inverseCumulativeNormal(u);
+	}
+
+	bridge_.transform(cursor.normals_.data(), increments);
+}
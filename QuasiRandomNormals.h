@@ -0,0 +1,46 @@
+#ifndef QUASI_RANDOM_NORMALS_H
+#define QUASI_RANDOM_NORMALS_H
+
+#include "SobolSequence.h"
+#include "BrownianBridge.h"
+#include <cstdint>
+#include <vector>
+
+// Randomized quasi-Monte Carlo normals for paths of numSteps equal time steps.  Point n of the
+// Sobol sequence (one dimension per step) is given a random digital shift -- a different one for
+// each replication -- mapped through the inverse normal, and laid out along the path by a
+// Brownian bridge.  Every replication is then an unbiased estimate, and the spread of the
+// replication means gives the error estimate that plain QMC lacks.
+class QuasiRandomNormals
+{
+public:
+	QuasiRandomNormals(unsigned numSteps, unsigned numReplications, int seed);
+
+	unsigned numSteps() const;
+	unsigned numReplications() const;
+
+	// Per-thread scratch space.  Remembers the last Sobol point, so that walking through
+	// consecutive point indices costs one XOR per dimension instead of a full Gray code rebuild.
+	class Cursor
+	{
+	public:
+		explicit Cursor(const QuasiRandomNormals& qrn);
+	private:
+		friend class QuasiRandomNormals;
+		std::vector<std::uint32_t> point_;
+		std::vector<double> normals_;
+		std::uint64_t index_;
+		bool valid_;
+	};
+
+	// Writes the numSteps standardized step increments for point `index` of `replication`
+	void generate(unsigned replication, std::uint64_t index, Cursor& cursor, double* increments) const;
+
+private:
+	SobolSequence sobol_;
+	BrownianBridge bridge_;
+	unsigned numReplications_;
+	std::vector<std::uint32_t> shifts_;		// numReplications_ rows of numSteps digital shifts
+};
+
+#endif
@@ -0,0 +1,243 @@
+#ifndef RANDOM_STREAMS_H
+#define RANDOM_STREAMS_H
+
+#include <cstdint>
+#include <cmath>
+#include <random>
+
+// Sources of standard normal draws for a single scenario.  The path kernels in
+// EquityPriceGenerator take any type with a double operator()() returning the next draw.
+
+// 53 random bits -> uniform on (0, 1], so that log(u) is always finite
+inline double uniformFromBits(std::uint64_t bits)
+{
+	return (static_cast<double>(bits >> 11) + 1.0) * (1.0 / 9007199254740992.0);
+}
+
+// Inverse of the standard normal distribution function:  Acklam's rational approximation
+// (relative error 1.15e-9) polished by one Halley step, which brings it to full double precision.
+// Also sets density to the standard normal density at the result, which the Halley step has all but
+// computed.
+inline double inverseCumulativeNormal(double u, double& density)
+{
+	static const double a[6] = { -3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02,
+		1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00 };
+	static const double b[5] = { -5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02,
+		6.680131188771972e+01, -1.328068155288572e+01 };
+	static const double c[6] = { -7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00,
+		-2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00 };
+	static const double d[4] = { 7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00,
+		3.754408661907416e+00 };
+	const double lowTail = 0.02425;
+
+	double x;
+	if (u < lowTail)
+	{
+		double q = std::sqrt(-2.0 * std::log(u));
+		x = (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+			((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+	}
+	else if (u <= 1.0 - lowTail)
+	{
+		double q = u - 0.5;
+		double r = q * q;
+		x = (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q /
+			(((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1.0);
+	}
+	else
+	{
+		double q = std::sqrt(-2.0 * std::log(1.0 - u));
+		x = -(((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+			((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+	}
+
+	double inverseDensity = 2.5066282746310002 * std::exp(0.5 * x * x);
+	double e = 0.5 * std::erfc(-x / 1.4142135623730951) - u;
+	double h = e * inverseDensity;
+	double step = h / (1.0 + 0.5 * x * h);
+	density = (1.0 + x * step) / inverseDensity;	// To first order in the (tiny) step
+	return x - step;
+}
+
+inline double inverseCumulativeNormal(double u)
+{
+	double density;
+	return inverseCumulativeNormal(u, density);
+}
+
+// Philox4x32-10 counter-based generator (Salmon, Moraes, Dror and Shaw, "Parallel Random Numbers:
+// As Easy as 1, 2, 3", SC11).  Each call maps a 128-bit counter and a 64-bit key to 128 random bits
+// with no state in between, so any draw can be computed directly from its coordinates.
+class Philox4x32
+{
+public:
+	struct Block
+	{
+		std::uint32_t v[4];
+	};
+
+	static Block generate(std::uint32_t c0, std::uint32_t c1, std::uint32_t c2, std::uint32_t c3,
+		std::uint32_t k0, std::uint32_t k1)
+	{
+		Block ctr = { { c0, c1, c2, c3 } };
+		round_(ctr, k0, k1);
+		for (int r = 1; r < 10; ++r)
+		{
+			k0 += 0x9E3779B9u;		// Weyl key schedule
+			k1 += 0xBB67AE85u;
+			round_(ctr, k0, k1);
+		}
+		return ctr;
+	}
+
+private:
+	static void round_(Block& ctr, std::uint32_t k0, std::uint32_t k1)
+	{
+		std::uint64_t p0 = static_cast<std::uint64_t>(0xD2511F53u) * ctr.v[0];
+		std::uint64_t p1 = static_cast<std::uint64_t>(0xCD9E8D57u) * ctr.v[2];
+		Block out = { { static_cast<std::uint32_t>(p1 >> 32) ^ ctr.v[1] ^ k0, static_cast<std::uint32_t>(p1),
+			static_cast<std::uint32_t>(p0 >> 32) ^ ctr.v[3] ^ k1, static_cast<std::uint32_t>(p0) } };
+		ctr = out;
+	}
+};
+
+// Normal draws addressed by (trade seed, scenario index, time step).  The key is the seed and the
+// counter is (step pair, scenario, stream), so a scenario's draws -- or a whole sub-range of
+// scenarios -- can be generated directly, and come out the same however the work is split across
+// threads.  Each Philox block gives two uniforms and, by Box-Muller, the normals for steps
+// 2p (r cos) and 2p + 1 (r sin).  BatchPathGenerator uses the same mapping.
+class PhiloxNormals
+{
+public:
+	PhiloxNormals(int seed, std::uint64_t scenario, unsigned firstStep = 0) :key_(static_cast<std::uint32_t>(seed)),
+		scenario_(scenario), step_(firstStep), spare_(0.0)
+	{
+		if (step_ % 2 == 1)
+		{
+			double z1;
+			pair(step_ / 2, z1, spare_);
+		}
+	}
+
+	double operator()()
+	{
+		double z;
+		if (step_ % 2 == 0)
+		{
+			pair(step_ / 2, z, spare_);
+		}
+		else
+		{
+			z = spare_;
+		}
+		++step_;
+		return z;
+	}
+
+	// Uniforms (u1, u2) behind the normals for steps 2 * stepPair and 2 * stepPair + 1
+	void uniforms(std::uint32_t stepPair, double& u1, double& u2) const
+	{
+		Philox4x32::Block b = Philox4x32::generate(stepPair, static_cast<std::uint32_t>(scenario_),
+			static_cast<std::uint32_t>(scenario_ >> 32), normalStream_, key_, 0u);
+		u1 = uniformFromBits((static_cast<std::uint64_t>(b.v[1]) << 32) | b.v[0]);
+		u2 = uniformFromBits((static_cast<std::uint64_t>(b.v[3]) << 32) | b.v[2]);
+	}
+
+	void pair(std::uint32_t stepPair, double& z1, double& z2) const
+	{
+		const double twoPi = 6.28318530717958647692;
+		double u1, u2;
+		uniforms(stepPair, u1, u2);
+		double r = std::sqrt(-2.0 * std::log(u1));
+		z1 = r * std::cos(twoPi * u2);
+		z2 = r * std::sin(twoPi * u2);
+	}
+
+private:
+	static const std::uint32_t normalStream_ = 0;	// Counter word 3:  other streams are free for other draws
+
+	std::uint32_t key_;
+	std::uint64_t scenario_;
+	unsigned step_;
+	double spare_;
+};
+
+// Uniforms on (0, 1] addressed by (trade seed, scenario index, draw index), on the Philox stream
+// given by counter word 3 (0 is taken by PhiloxNormals, 1 by the QMC shifts), so that they are
+// independent of the scenario's normals whichever RandomStream generates those.
+class PhiloxUniforms
+{
+public:
+	PhiloxUniforms(int seed, std::uint64_t scenario, std::uint32_t stream) :key_(static_cast<std::uint32_t>(seed)),
+		scenario_(scenario), stream_(stream), pair_(0xFFFFFFFFu), u_{ 0.0, 0.0 } {}
+
+	double operator()(unsigned index)
+	{
+		if (index / 2 != pair_)
+		{
+			pair_ = index / 2;
+			Philox4x32::Block b = Philox4x32::generate(pair_, static_cast<std::uint32_t>(scenario_),
+				static_cast<std::uint32_t>(scenario_ >> 32), stream_, key_, 0u);
+			u_[0] = uniformFromBits((static_cast<std::uint64_t>(b.v[1]) << 32) | b.v[0]);
+			u_[1] = uniformFromBits((static_cast<std::uint64_t>(b.v[3]) << 32) | b.v[2]);
+		}
+		return u_[index % 2];
+	}
+
+private:
+	std::uint32_t key_;
+	std::uint64_t scenario_;
+	std::uint32_t stream_;
+	std::uint32_t pair_;	// Draws 2 pair_ and 2 pair_ + 1 are in u_
+	double u_[2];
+};
+
+// Draws already laid out in memory, one per time step (eg, a Brownian-bridge path built from
+// quasi-random numbers).  The caller keeps the storage alive.
+class StoredNormals
+{
+public:
+	explicit StoredNormals(const double* normals) :next_(normals) {}
+
+	double operator()()
+	{
+		return *next_++;
+	}
+
+private:
+	const double* next_;
+};
+
+// Antithetic partner of another source:  the same draws with the sign flipped
+template <typename NormalSource>
+class AntitheticNormals
+{
+public:
+	explicit AntitheticNormals(NormalSource& normals) :normals_(normals) {}
+
+	double operator()()
+	{
+		return -normals_();
+	}
+
+private:
+	NormalSource& normals_;
+};
+
+// The original scheme:  a fresh mt19937_64 seeded with (trade seed + scenario index) per scenario
+class MersenneNormals
+{
+public:
+	explicit MersenneNormals(int seed) :mtre_(seed) {}
+
+	double operator()()
+	{
+		return nd_(mtre_);
+	}
+
+private:
+	std::mt19937_64 mtre_;
+	std::normal_distribution<> nd_;
+};
+
+#endif
@@ -1,64 +1,194 @@
-#ifndef RESULT_SET_H
-#define RESULT_SET_H
-
-#include <map>
-#include <iostream>
-
-enum class OptionType
-{
-	CALL,
-	PUT
-};
-
-enum class Barrier 
-{
-	UP_AND_OUT,
-	DOWN_AND_OUT
-};
-
-struct OptionResults
-{
-	enum Value	// Keep as regular (integer) enum so that we can use as the key value in an std::map
-	{
-		// Since it is encapsulated within the struct, it does not pollute the global namespace.
-		// Result set will be the price of the option and the 1st order risk values (ie, omit gamma)
-		PRICE, // The value of the option as a result of the pricing model
-		DELTA, // Option delta
-		VEGA,  // Option vega
-		RHO    // Option rho
-	};
-
-	std::map<Value, double> resultSet;
-
-	void print()
-	{
-		std::cout << std::endl;
-		std::cout << "Option Price = " << resultSet.at(PRICE) << std::endl;
-		std::cout << "Option Delta = " << resultSet.at(DELTA) << std::endl;
-		std::cout << "Option Vega = " << resultSet.at(VEGA) << std::endl;
-		std::cout << "Option Rho = " << resultSet.at(RHO) << std::endl << std::endl;
-	};
-};
-
-struct BondResults
-{
-	enum Value	// Keep as regular (integer) enum so that we can use as the key value in an std::map
-	{
-		// Since it is encapsulated within the struct, it does not pollute the global namespace.
-		PRICE,		// The value of the bond
-		YTM,		// Yield to Maturity
-		DURATION	// Bond duration (requires YTM value)
-	};
-
-	std::map<Value, double> resultSet;
-
-	void print()
-	{
-		std::cout << std::endl;
-		std::cout << "Bond Price = " << resultSet.at(PRICE) << std::endl;
-		std::cout << "Bond Duration = " << resultSet.at(DURATION) << std::endl;
-		std::cout << "Yield to Maturity = " << resultSet.at(YTM) << std::endl << std::endl;
-	};
-};
-
-#endif
+#ifndef RESULT_SET_H
+#define RESULT_SET_H
+
+#include "RunStatistics.h"
+#include <map>
+#include <iostream>
+#include <utility>
+#include <stdexcept>
+#include <type_traits>
+#include <cstddef>
+
+enum class OptionType
+{
+	CALL,
+	PUT
+};
+
+enum class Barrier 
+{
+	UP_AND_OUT,
+	DOWN_AND_OUT,
+	UP_AND_IN,
+	DOWN_AND_IN
+};
+
+// One option's values in a fixed layout, with no heap storage:  trivially copyable, so that a
+// batch of them can be kept (and written out) as contiguous blocks (see OptionResultTable).
+// Bit v of present is set once value v (an OptionResults::Value) has been set.
+struct OptionValues
+{
+	double price = 0.0;
+	double delta = 0.0;
+	double vega = 0.0;
+	double rho = 0.0;
+	double strikeSensitivity = 0.0;
+	double barrierSensitivity = 0.0;
+	double gamma = 0.0;
+	double vanna = 0.0;
+	double volga = 0.0;
+	double stdError = 0.0;
+	double numScenarios = 0.0;
+	double time = 0.0;
+	unsigned present = 0;
+};
+
+static_assert(std::is_trivially_copyable<OptionValues>::value, "OptionValues must stay a flat record");
+
+struct OptionResults
+{
+	enum Value	// Keep as regular (integer) enum so that it can index the fields of OptionValues
+	{
+		// Since it is encapsulated within the struct, it does not pollute the global namespace.
+		// Result set will be the price of the option and its risk values:  the 1st order ones (to the
+		// contract terms as well as the market, when asked for), and the 2nd order ones in spot and
+		// volatility when they are asked for
+		PRICE, // The value of the option as a result of the pricing model
+		DELTA, // Option delta
+		VEGA,  // Option vega
+		RHO,   // Option rho
+		STRIKE_SENSITIVITY,		// d(price)/d(strike)
+		BARRIER_SENSITIVITY,	// d(price)/d(barrier level)
+		GAMMA, // Option gamma
+		VANNA, // d(delta)/d(volatility)
+		VOLGA, // d(vega)/d(volatility)
+		STD_ERROR,		// Standard error of the price (0 from a closed form)
+		NUM_SCENARIOS,	// Number of Monte Carlo scenarios the values came from (0 from a closed form; all levels' with multilevel)
+		TIME,			// Wall-clock time of the run, in seconds
+		NUM_VALUES
+	};
+
+	// Masks of values, bit v for Value v:  what a valuation is asked for (eg, by
+	// BarrierOption::operator()(request)), and which values an OptionValues record holds
+	static constexpr unsigned PRICE_ONLY = 1u << PRICE;
+	static constexpr unsigned PRICE_AND_DELTA = PRICE_ONLY | 1u << DELTA;
+	static constexpr unsigned FIRST_ORDER = PRICE_AND_DELTA | 1u << VEGA | 1u << RHO;
+	static constexpr unsigned CONTRACT_SENSITIVITIES = 1u << STRIKE_SENSITIVITY | 1u << BARRIER_SENSITIVITY;
+	static constexpr unsigned SECOND_ORDER = 1u << GAMMA | 1u << VANNA | 1u << VOLGA;
+
+	// The values keyed by Value, with the interface of the std::map<Value, double> this used to
+	// be, over a flat OptionValues record
+	class ResultSet
+	{
+	public:
+		// As std::map::at(.):  throws std::out_of_range if value has not been set
+		double at(Value value) const
+		{
+			if (count(value) == 0)
+			{
+				throw std::out_of_range("OptionResults:  value not set");
+			}
+			return values_.*fields_[value];
+		}
+
+		std::size_t count(Value value) const
+		{
+			return (values_.present >> value) & 1u;
+		}
+
+		// As std::map::insert(.):  leaves a value that is already set alone; returns whether it set it
+		bool insert(const std::pair<Value, double>& entry)
+		{
+			if (count(entry.first) != 0)
+			{
+				return false;
+			}
+			(*this)[entry.first] = entry.second;
+			return true;
+		}
+
+		double& operator [] (Value value)
+		{
+			values_.present |= 1u << value;
+			return values_.*fields_[value];
+		}
+
+		const OptionValues& values() const
+		{
+			return values_;
+		}
+
+		OptionValues& values()
+		{
+			return values_;
+		}
+
+	private:
+		static constexpr double OptionValues::* fields_[NUM_VALUES] = { &OptionValues::price, &OptionValues::delta,
+			&OptionValues::vega, &OptionValues::rho, &OptionValues::strikeSensitivity, &OptionValues::barrierSensitivity,
+			&OptionValues::gamma, &OptionValues::vanna, &OptionValues::volga,
+			&OptionValues::stdError, &OptionValues::numScenarios,
+			&OptionValues::time };
+
+		OptionValues values_;
+	};
+
+	ResultSet resultSet;
+	RunStatistics statistics;	// Where the run's time went (only if EngineSettings::collectStatistics was set)
+
+	void print()
+	{
+		// Only the values that were requested (and so computed) are in resultSet
+		auto printValue = [this](const char* name, Value value)
+		{
+			if (resultSet.count(value) != 0)
+			{
+				std::cout << name << " = " << resultSet.at(value) << std::endl;
+			}
+		};
+
+		std::cout << std::endl;
+		printValue("Option Price", PRICE);
+		printValue("Option Delta", DELTA);
+		printValue("Option Vega", VEGA);
+		printValue("Option Rho", RHO);
+		printValue("Option d/dStrike", STRIKE_SENSITIVITY);
+		printValue("Option d/dBarrier", BARRIER_SENSITIVITY);
+		printValue("Option Gamma", GAMMA);
+		printValue("Option Vanna", VANNA);
+		printValue("Option Volga", VOLGA);
+		if (resultSet.count(STD_ERROR) != 0)
+		{
+			std::cout << "Standard Error = " << resultSet.at(STD_ERROR) << " (" << resultSet.at(NUM_SCENARIOS)
+				<< " scenarios)" << std::endl;
+		}
+		if (statistics.collected)
+		{
+			statistics.print();
+		}
+		std::cout << std::endl;
+	};
+};
+
+struct BondResults
+{
+	enum Value	// Keep as regular (integer) enum so that we can use as the key value in an std::map
+	{
+		// Since it is encapsulated within the struct, it does not pollute the global namespace.
+		PRICE,		// The value of the bond
+		YTM,		// Yield to Maturity
+		DURATION	// Bond duration (requires YTM value)
+	};
+
+	std::map<Value, double> resultSet;
+
+	void print()
+	{
+		std::cout << std::endl;
+		std::cout << "Bond Price = " << resultSet.at(PRICE) << std::endl;
+		std::cout << "Bond Duration = " << resultSet.at(DURATION) << std::endl;
+		std::cout << "Yield to Maturity = " << resultSet.at(YTM) << std::endl << std::endl;
+	};
+};
+
+#endif
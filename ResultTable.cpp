@@ -0,0 +1,142 @@
+#include "ResultTable.h"
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdint>
+
+using std::size_t;
+
+namespace
+{
+	const char* columnNames[OptionResults::NUM_VALUES] = { "price", "delta", "vega", "rho",
+		"strikeSensitivity", "barrierSensitivity", "gamma", "vanna", "volga", "stdError", "numScenarios", "time" };
+}
+
+OptionResultTable::OptionResultTable(size_t numRows) :numRows_(numRows), present_(0),
+	columns_(OptionResults::NUM_VALUES * numRows, 0.0) {}
+
+size_t OptionResultTable::size() const
+{
+	return numRows_;
+}
+
+void OptionResultTable::resize(size_t numRows)
+{
+	std::vector<double> columns(OptionResults::NUM_VALUES * numRows, 0.0);
+	const size_t rowsKept = std::min(numRows, numRows_);
+	for (size_t v = 0; v < OptionResults::NUM_VALUES; ++v)
+	{
+		std::copy(columns_.begin() + v * numRows_, columns_.begin() + v * numRows_ + rowsKept,
+			columns.begin() + v * numRows);
+	}
+	columns_.swap(columns);
+	numRows_ = numRows;
+}
+
+double& OptionResultTable::operator()(size_t row, OptionResults::Value value)
+{
+	present_ |= 1u << value;
+	return columns_[value * numRows_ + row];
+}
+
+double OptionResultTable::operator()(size_t row, OptionResults::Value value) const
+{
+	return columns_[value * numRows_ + row];
+}
+
+bool OptionResultTable::has(OptionResults::Value value) const
+{
+	return ((present_ >> value) & 1u) != 0;
+}
+
+const double* OptionResultTable::column(OptionResults::Value value) const
+{
+	return columns_.data() + value * numRows_;
+}
+
+void OptionResultTable::setRow(size_t row, const OptionValues& values)
+{
+	OptionResults::ResultSet view;
+	view.values() = values;
+	for (int v = 0; v < OptionResults::NUM_VALUES; ++v)
+	{
+		OptionResults::Value value = static_cast<OptionResults::Value>(v);
+		if (view.count(value) != 0)
+		{
+			(*this)(row, value) = view.at(value);
+		}
+	}
+}
+
+OptionValues OptionResultTable::row(size_t row) const
+{
+	OptionResults::ResultSet view;
+	for (int v = 0; v < OptionResults::NUM_VALUES; ++v)
+	{
+		OptionResults::Value value = static_cast<OptionResults::Value>(v);
+		if (has(value))
+		{
+			view[value] = (*this)(row, value);
+		}
+	}
+	return view.values();
+}
+
+OptionResults OptionResultTable::results(size_t row) const
+{
+	OptionResults results;
+	results.resultSet.values() = this->row(row);
+	return results;
+}
+
+void OptionResultTable::write(std::ostream& os) const
+{
+	const std::uint64_t header[3] = { numRows_, OptionResults::NUM_VALUES, present_ };
+	os.write(reinterpret_cast<const char*>(header), sizeof(header));
+	os.write(reinterpret_cast<const char*>(columns_.data()), columns_.size() * sizeof(double));
+}
+
+OptionResultTable OptionResultTable::read(std::istream& is)
+{
+	std::uint64_t header[3];
+	if (!is.read(reinterpret_cast<char*>(header), sizeof(header)) || header[1] != OptionResults::NUM_VALUES)
+	{
+		throw std::runtime_error("OptionResultTable::read:  not a result table");
+	}
+
+	OptionResultTable table(static_cast<size_t>(header[0]));
+	table.present_ = static_cast<unsigned>(header[2]);
+	if (!is.read(reinterpret_cast<char*>(table.columns_.data()), table.columns_.size() * sizeof(double)))
+	{
+		throw std::runtime_error("OptionResultTable::read:  table is truncated");
+	}
+	return table;
+}
+
+void OptionResultTable::writeCsv(std::ostream& os) const
+{
+	const char* separator = "";
+	for (int v = 0; v < OptionResults::NUM_VALUES; ++v)
+	{
+		if (has(static_cast<OptionResults::Value>(v)))
+		{
+			os << separator << columnNames[v];
+			separator = ",";
+		}
+	}
+	os << "\n";
+
+	for (size_t r = 0; r < numRows_; ++r)
+	{
+		separator = "";
+		for (int v = 0; v < OptionResults::NUM_VALUES; ++v)
+		{
+			if (has(static_cast<OptionResults::Value>(v)))
+			{
+				os << separator << columns_[v * numRows_ + r];
+				separator = ",";
+			}
+		}
+		os << "\n";
+	}
+}
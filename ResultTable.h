@@ -0,0 +1,49 @@
+#ifndef RESULT_TABLE_H
+#define RESULT_TABLE_H
+
+#include "ResultSet.h"
+#include <vector>
+#include <iosfwd>
+#include <cstddef>
+
+// The results of a batch of options, by column:  the prices of every row, then their deltas,
+// and so on (in OptionResults::Value order), in one contiguous block of doubles.  A column can
+// then be scanned or aggregated without touching the others, and the whole table goes out in
+// one bulk write.  The table records which columns have been set, not which rows.
+class OptionResultTable
+{
+public:
+	explicit OptionResultTable(std::size_t numRows = 0);
+
+	std::size_t size() const;
+	void resize(std::size_t numRows);		// Keeps the values of the rows that remain
+
+	// Value value of row row; the non-const version marks the column as set
+	double& operator()(std::size_t row, OptionResults::Value value);
+	double operator()(std::size_t row, OptionResults::Value value) const;
+	bool has(OptionResults::Value value) const;
+
+	// Value value of every row, contiguous
+	const double* column(OptionResults::Value value) const;
+
+	// One row as a flat record, or as an OptionResults (with no run statistics)
+	void setRow(std::size_t row, const OptionValues& values);
+	OptionValues row(std::size_t row) const;
+	OptionResults results(std::size_t row) const;
+
+	// Binary:  a header of three 64-bit words (rows, columns, the mask of the columns set), then
+	// the columns, as doubles in the machine's byte order.  read() reverses it, and throws
+	// std::runtime_error if the stream does not hold a table.
+	void write(std::ostream& os) const;
+	static OptionResultTable read(std::istream& is);
+
+	// One line per row, with a header line naming the columns set
+	void writeCsv(std::ostream& os) const;
+
+private:
+	std::size_t numRows_;
+	unsigned present_;				// Bit v set once column v has been set
+	std::vector<double> columns_;	// Value v of row r is at v * numRows_ + r
+};
+
+#endif
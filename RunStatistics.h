@@ -0,0 +1,258 @@
+#ifndef RUN_STATISTICS_H
+#define RUN_STATISTICS_H
+
+#include <cstddef>
+#include <ctime>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// What one pricing run spent its time on, and what its paths did.  Filled in by BarrierOption
+// only when EngineSettings::collectStatistics is set; otherwise collected stays false and the
+// hot paths do no extra work.  The path counts are taken once per path (the phases once per
+// phase), never per time step, so they do not perturb what they measure.  For the cost of the
+// individual kernels (draws, exp, barrier checks), see the microbenchmarks in bench/.
+struct RunStatistics
+{
+	enum Phase
+	{
+		SETUP,		// Path generators, Sobol tables, closed-form control values
+		SIMULATION,	// Generating the paths and evaluating the payoffs (including the fan-out to the pool)
+		REDUCTION,	// Control variate, sums and standard error
+		NUM_PHASES
+	};
+
+	bool collected = false;
+
+	// Per phase, summed over the run (a bump-and-reprice run goes through each phase four times)
+	double wallTime[NUM_PHASES] = {};
+	double cpuTime[NUM_PHASES] = {};	// Process CPU time, ie summed over every thread
+
+	// Time spent inside the scenario tasks, summed over the tasks:  busy time / (simulation wall
+	// time x threads used) is the efficiency of the fan-out
+	double taskTime = 0.0;
+	unsigned long long tasks = 0;		// Units of work run (chunks of scenarios, or 1 if not parallel)
+	unsigned threadsUsed = 0;			// Distinct threads that ran at least one task
+
+	// Over every path simulated, bumped revaluations included, but not the extra market states
+	// of a single-pass run (which follow the base path)
+	unsigned long long pathsSimulated = 0;
+	unsigned long long stepsSimulated = 0;	// Time steps generated (a knocked-out path stops early)
+	unsigned long long barrierHits = 0;		// Paths that hit the barrier (knocked out, or knocked in)
+	unsigned long long hitStepTotal = 0;	// Sum of the time steps at which those paths hit it
+	unsigned long long hitStepCount = 0;	// Hits whose time step is known (the SIMD kernel does not report it)
+	std::size_t bufferBytes = 0;			// Largest per-scenario buffer (payoffs and controls) allocated
+
+	double stdError = 0.0;
+
+	// Single precision (EngineSettings::precision):  the price of the first precisionScenarios scenarios
+	// in single less that in double, on the same draws (0 scenarios if not checked)
+	unsigned long long precisionScenarios = 0;
+	double precisionDifference = 0.0;
+
+	// Multilevel runs (EngineSettings::multilevel), coarsest level first.  These are the price run's
+	// levels:  the bumped revaluations reuse its scenarios per level.
+	struct Level
+	{
+		unsigned fineSteps = 0;
+		unsigned coarseSteps = 0;			// 0 on level 0, which prices the coarsest grid alone
+		unsigned long long scenarios = 0;
+		double mean = 0.0;					// Of the discounted P_fine - P_coarse, per unit
+		double variance = 0.0;
+		double fineVariance = 0.0;			// Of the discounted P_fine alone
+		double wallTime = 0.0;
+	};
+	std::vector<Level> levels;
+
+	// Time steps the levels simulated (a coarse path is its fine path subsampled, so costs nothing
+	// more), and those one level at the finest grid would need for the same standard error
+	double multilevelSteps() const
+	{
+		double steps = 0.0;
+		for (const Level& level : levels)
+		{
+			steps += double(level.scenarios) * level.fineSteps;
+		}
+		return steps;
+	}
+
+	double singleLevelSteps() const
+	{
+		double variance = 0.0;
+		for (const Level& level : levels)
+		{
+			variance += (level.scenarios > 0) ? level.variance / level.scenarios : 0.0;
+		}
+		return (variance > 0.0) ? levels.back().fineVariance / variance * levels.back().fineSteps : 0.0;
+	}
+
+	// Counts of a block of paths, merged into the run's
+	struct PathCounts
+	{
+		unsigned long long paths = 0;
+		unsigned long long steps = 0;
+		unsigned long long hits = 0;
+		unsigned long long hitSteps = 0;
+		unsigned long long hitStepCount = 0;
+
+		// A path that ran for steps time steps, and hit the barrier at time step hitStep if hit
+		void add(unsigned steps, bool hit, unsigned hitStep)
+		{
+			++paths;
+			this->steps += steps;
+			if (hit)
+			{
+				++hits;
+				hitSteps += hitStep;
+				++hitStepCount;
+			}
+		}
+
+		// numPaths paths that ran for steps time steps between them, hits of which hit the barrier
+		// (at steps not known)
+		void addBlock(unsigned long long numPaths, unsigned long long steps, unsigned long long hits)
+		{
+			paths += numPaths;
+			this->steps += steps;
+			this->hits += hits;
+		}
+	};
+
+	void add(const PathCounts& counts)
+	{
+		pathsSimulated += counts.paths;
+		stepsSimulated += counts.steps;
+		barrierHits += counts.hits;
+		hitStepTotal += counts.hitSteps;
+		hitStepCount += counts.hitStepCount;
+	}
+
+	double barrierHitFraction() const
+	{
+		return (pathsSimulated > 0) ? double(barrierHits) / pathsSimulated : 0.0;
+	}
+
+	double meanHitStep() const
+	{
+		return (hitStepCount > 0) ? double(hitStepTotal) / hitStepCount : 0.0;
+	}
+
+	double meanStepsPerPath() const
+	{
+		return (pathsSimulated > 0) ? double(stepsSimulated) / pathsSimulated : 0.0;
+	}
+
+	double fanOutEfficiency() const
+	{
+		double available = wallTime[SIMULATION] * threadsUsed;
+		return (available > 0.0) ? taskTime / available : 0.0;
+	}
+
+	void print() const
+	{
+		static const char* phaseNames[NUM_PHASES] = { "Setup", "Simulation", "Reduction" };
+		std::cout << "Run statistics:" << std::endl;
+		for (int p = 0; p < NUM_PHASES; ++p)
+		{
+			std::cout << "  " << phaseNames[p] << ": wall " << wallTime[p] << " s, CPU " << cpuTime[p] << " s" << std::endl;
+		}
+		std::cout << "  Tasks: " << tasks << " on " << threadsUsed << " threads, " << taskTime << " s busy ("
+			<< 100.0 * fanOutEfficiency() << "% of the simulation wall time x threads)" << std::endl;
+		std::cout << "  Paths: " << pathsSimulated << ", " << meanStepsPerPath() << " steps per path, "
+			<< 100.0 * barrierHitFraction() << "% hit the barrier (at step " << meanHitStep() << " on average)" << std::endl;
+		std::cout << "  Scenario buffers: " << bufferBytes << " bytes;  standard error " << stdError << std::endl;
+		if (precisionScenarios > 0)
+		{
+			std::cout << "  Single precision: " << precisionDifference << " from double over the first "
+				<< precisionScenarios << " scenarios" << std::endl;
+		}
+		for (std::size_t l = 0; l < levels.size(); ++l)
+		{
+			const Level& level = levels[l];
+			std::cout << "  Level " << l << " (" << level.coarseSteps << " -> " << level.fineSteps << " steps): "
+				<< level.scenarios << " scenarios, mean " << level.mean << ", variance " << level.variance << ", "
+				<< level.wallTime << " s" << std::endl;
+		}
+		if (!levels.empty())
+		{
+			std::cout << "  Multilevel: " << multilevelSteps() << " steps;  one level at " << levels.back().fineSteps
+				<< " steps would need " << singleLevelSteps() << std::endl;
+		}
+	}
+
+	// Prometheus text format, one sample per line, each labelled with trade="<label>"
+	void writeMetrics(std::ostream& os, const std::string& label) const
+	{
+		static const char* phaseNames[NUM_PHASES] = { "setup", "simulation", "reduction" };
+		const std::string trade = "trade=\"" + label + "\"";
+		for (int p = 0; p < NUM_PHASES; ++p)
+		{
+			os << "barrier_option_phase_wall_seconds{" << trade << ",phase=\"" << phaseNames[p] << "\"} " << wallTime[p] << "\n";
+			os << "barrier_option_phase_cpu_seconds{" << trade << ",phase=\"" << phaseNames[p] << "\"} " << cpuTime[p] << "\n";
+		}
+		os << "barrier_option_task_seconds{" << trade << "} " << taskTime << "\n";
+		os << "barrier_option_tasks{" << trade << "} " << tasks << "\n";
+		os << "barrier_option_threads_used{" << trade << "} " << threadsUsed << "\n";
+		os << "barrier_option_paths_simulated{" << trade << "} " << pathsSimulated << "\n";
+		os << "barrier_option_steps_simulated{" << trade << "} " << stepsSimulated << "\n";
+		os << "barrier_option_barrier_hit_fraction{" << trade << "} " << barrierHitFraction() << "\n";
+		os << "barrier_option_mean_hit_step{" << trade << "} " << meanHitStep() << "\n";
+		os << "barrier_option_buffer_bytes{" << trade << "} " << bufferBytes << "\n";
+		os << "barrier_option_std_error{" << trade << "} " << stdError << "\n";
+		if (precisionScenarios > 0)
+		{
+			os << "barrier_option_precision_difference{" << trade << "} " << precisionDifference << "\n";
+		}
+		for (std::size_t l = 0; l < levels.size(); ++l)
+		{
+			const std::string level = trade + ",level=\"" + std::to_string(l) + "\"";
+			os << "barrier_option_level_scenarios{" << level << "} " << levels[l].scenarios << "\n";
+			os << "barrier_option_level_variance{" << level << "} " << levels[l].variance << "\n";
+			os << "barrier_option_level_wall_seconds{" << level << "} " << levels[l].wallTime << "\n";
+		}
+	}
+};
+
+// Adds the wall and CPU time from construction to destruction (or stop()) to a phase of
+// statistics; does nothing if statistics is null
+class PhaseTimer
+{
+public:
+	PhaseTimer(RunStatistics* statistics, RunStatistics::Phase phase) :statistics_(statistics), phase_(phase), cpuBegin_(0)
+	{
+		if (statistics_ != nullptr)
+		{
+			wallBegin_ = std::chrono::steady_clock::now();
+			cpuBegin_ = std::clock();
+		}
+	}
+
+	~PhaseTimer()
+	{
+		stop();
+	}
+
+	// Ends the phase early
+	void stop()
+	{
+		if (statistics_ != nullptr)
+		{
+			std::chrono::duration<double> wall = std::chrono::steady_clock::now() - wallBegin_;
+			statistics_->wallTime[phase_] += wall.count();
+			statistics_->cpuTime[phase_] += double(std::clock() - cpuBegin_) / CLOCKS_PER_SEC;
+			statistics_ = nullptr;
+		}
+	}
+
+	PhaseTimer(const PhaseTimer&) = delete;
+	PhaseTimer& operator = (const PhaseTimer&) = delete;
+
+private:
+	RunStatistics* statistics_;
+	RunStatistics::Phase phase_;
+	std::chrono::steady_clock::time_point wallBegin_;
+	std::clock_t cpuBegin_;
+};
+
+#endif
@@ -0,0 +1,106 @@
+#include "SobolSequence.h"
+#include "JoeKuoTable.h"
+#include <stdexcept>
+#include <string>
+#include <cassert>
+
+using std::uint32_t;
+using std::uint64_t;
+using std::vector;
+
+const unsigned SobolSequence::maxDimension = joeKuoMaxDimension;
+
+SobolSequence::SobolSequence(unsigned dimension) :dimension_(dimension), directions_(dimension * numBits)
+{
+	assert(dimension > 0);
+	if (dimension > maxDimension)
+	{
+		throw std::invalid_argument("SobolSequence:  " + std::to_string(dimension) + " dimensions, more than the "
+			+ std::to_string(maxDimension) + " of the direction number table");
+	}
+
+	// Dimension 1 is the van der Corput sequence in base 2
+	for (unsigned k = 0; k < numBits; ++k)
+	{
+		directions_[k] = uint32_t(1) << (numBits - 1 - k);
+	}
+
+	for (unsigned d = 1; d < dimension_; ++d)
+	{
+		const JoeKuoEntry& entry = joeKuoTable[d - 1];
+		const uint32_t p = entry.polynomial;
+		unsigned degree = 0;
+		while ((p >> (degree + 1)) != 0)
+		{
+			++degree;
+		}
+
+		vector<uint32_t> m(numBits + 1);		// m[1..numBits]
+		for (unsigned k = 1; k <= degree; ++k)
+		{
+			m[k] = entry.m[k - 1];
+		}
+
+		// m_k = 2 a_1 m_{k-1} ^ 4 a_2 m_{k-2} ^ ... ^ 2^s m_{k-s} ^ m_{k-s}
+		for (unsigned k = degree + 1; k <= numBits; ++k)
+		{
+			uint32_t mk = m[k - degree] ^ (m[k - degree] << degree);
+			for (unsigned i = 1; i < degree; ++i)
+			{
+				if ((p >> (degree - i)) & 1)
+				{
+					mk ^= m[k - i] << i;
+				}
+			}
+			m[k] = mk;
+		}
+
+		for (unsigned k = 1; k <= numBits; ++k)
+		{
+			directions_[d * numBits + k - 1] = m[k] << (numBits - k);
+		}
+	}
+}
+
+unsigned SobolSequence::dimension() const
+{
+	return dimension_;
+}
+
+void SobolSequence::point(uint64_t index, uint32_t* x) const
+{
+	uint64_t gray = index ^ (index >> 1);
+	for (unsigned d = 0; d < dimension_; ++d)
+	{
+		x[d] = 0;
+	}
+
+	for (unsigned k = 0; gray != 0 && k < numBits; ++k, gray >>= 1)
+	{
+		if (gray & 1)
+		{
+			for (unsigned d = 0; d < dimension_; ++d)
+			{
+				x[d] ^= directions_[d * numBits + k];
+			}
+		}
+	}
+}
+
+void SobolSequence::next(uint64_t index, uint32_t* x) const
+{
+	assert(index > 0);
+
+	// Gray codes of index - 1 and index differ in the lowest zero bit of index - 1
+	unsigned k = 0;
+	for (uint64_t n = index - 1; n & 1; n >>= 1)
+	{
+		++k;
+	}
+	assert(k < numBits);
+
+	for (unsigned d = 0; d < dimension_; ++d)
+	{
+		x[d] ^= directions_[d * numBits + k];
+	}
+}
@@ -0,0 +1,35 @@
+#ifndef SOBOL_SEQUENCE_H
+#define SOBOL_SEQUENCE_H
+
+#include <cstdint>
+#include <vector>
+
+// Sobol low-discrepancy sequence in any number of dimensions (Bratley and Fox's Gray code
+// construction, 32 bits per coordinate, so up to 2^32 points).
+//
+// Each dimension after the first is built from a primitive polynomial over GF(2) and a set of
+// initial direction numbers, both from Joe and Kuo's (2008) table (see JoeKuoTable.h), which is
+// chosen for good two-dimensional projections.  The table covers maxDimension dimensions; more
+// throw std::invalid_argument.
+class SobolSequence
+{
+public:
+	explicit SobolSequence(unsigned dimension);
+
+	unsigned dimension() const;
+
+	// Coordinates of point index, scaled by 2^32, computed directly from its Gray code
+	void point(std::uint64_t index, std::uint32_t* x) const;
+
+	// Moves x from point index - 1 to point index:  one XOR per coordinate
+	void next(std::uint64_t index, std::uint32_t* x) const;
+
+	static const unsigned numBits = 32;
+	static const unsigned maxDimension;
+
+private:
+	unsigned dimension_;
+	std::vector<std::uint32_t> directions_;		// dimension_ rows of numBits direction numbers
+};
+
+#endif
@@ -0,0 +1,126 @@
+#include "TermStructure.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+using std::vector;
+using std::size_t;
+
+TermStructure::TermStructure(double riskFreeRate, double volatility) :times_(1, std::numeric_limits<double>::infinity()),
+	rates_(1, riskFreeRate), vols_(1, volatility) {}
+
+TermStructure::TermStructure(const vector<double>& times, const vector<double>& rates, const vector<double>& vols)
+	:times_(times), rates_(rates), vols_(vols)
+{
+	if (times_.empty() || rates_.size() != times_.size() || vols_.size() != times_.size())
+	{
+		throw std::invalid_argument("TermStructure:  times, rates and vols must be the same nonzero length");
+	}
+	for (size_t k = 0; k < times_.size(); ++k)
+	{
+		if (times_[k] <= ((k > 0) ? times_[k - 1] : 0.0))
+		{
+			throw std::invalid_argument("TermStructure:  times must increase from above 0");
+		}
+	}
+
+	// The last piece runs on
+	times_.back() = std::numeric_limits<double>::infinity();
+}
+
+template <typename PieceFn>
+void TermStructure::forEachPiece_(double t1, double t2, PieceFn piece) const
+{
+	// The first piece ending after t1
+	size_t k = std::upper_bound(times_.begin(), times_.end(), t1) - times_.begin();
+	double start = t1;
+	for (; k < times_.size() && start < t2; ++k)
+	{
+		const double end = std::min(times_[k], t2);
+		piece(k, end - start);
+		start = end;
+	}
+}
+
+double TermStructure::integratedRate(double t1, double t2) const
+{
+	double sum = 0.0;
+	forEachPiece_(t1, t2, [this, &sum](size_t k, double length)
+	{
+		sum += rates_[k] * length;
+	});
+	return sum;
+}
+
+double TermStructure::integratedVariance(double t1, double t2) const
+{
+	double sum = 0.0;
+	forEachPiece_(t1, t2, [this, &sum](size_t k, double length)
+	{
+		sum += vols_[k] * vols_[k] * length;
+	});
+	return sum;
+}
+
+double TermStructure::discountFactor(double t1, double t2) const
+{
+	return std::exp(-integratedRate(t1, t2));
+}
+
+TermStructure TermStructure::shifted(double rateShift, double volShift) const
+{
+	TermStructure result(*this);
+	for (size_t k = 0; k < times_.size(); ++k)
+	{
+		result.rates_[k] += rateShift;
+		result.vols_[k] += volShift;
+	}
+	return result;
+}
+
+size_t TermStructure::numPieces() const
+{
+	return times_.size();
+}
+
+TimeStepTable::TimeStepTable(const TermStructure& termStructure, double timeToMaturity, unsigned numTimeSteps)
+	:logDrifts_(numTimeSteps), diffusions_(numTimeSteps), discountFactors_(numTimeSteps + 1)
+{
+	const double dt = timeToMaturity / numTimeSteps;
+	double logDiscount = 0.0;
+	discountFactors_[0] = 1.0;
+	for (unsigned k = 1; k <= numTimeSteps; ++k)
+	{
+		const double t1 = (k - 1) * dt;
+		const double t2 = (k == numTimeSteps) ? timeToMaturity : k * dt;
+		double rate = 0.0, variance = 0.0;
+		unsigned numPieces = 0;
+		termStructure.forEachPiece_(t1, t2, [&](size_t piece, double length)
+		{
+			rate += termStructure.rates_[piece] * length;
+			variance += termStructure.vols_[piece] * termStructure.vols_[piece] * length;
+			++numPieces;
+		});
+
+		if (numPieces == 1)
+		{
+			// Exactly as the constant generator's step
+			const size_t piece = std::upper_bound(termStructure.times_.begin(), termStructure.times_.end(), t1)
+				- termStructure.times_.begin();
+			const double r = termStructure.rates_[piece];
+			const double vol = termStructure.vols_[piece];
+			logDrifts_[k - 1] = (r - ((vol * vol) / 2.0)) * dt;
+			diffusions_[k - 1] = vol * std::sqrt(dt);
+		}
+		else
+		{
+			logDrifts_[k - 1] = rate - variance / 2.0;
+			diffusions_[k - 1] = std::sqrt(variance);
+		}
+		logDiscount += rate;
+		discountFactors_[k] = std::exp(-logDiscount);
+	}
+	singleLogDrifts_.assign(logDrifts_.begin(), logDrifts_.end());
+	singleDiffusions_.assign(diffusions_.begin(), diffusions_.end());
+}
@@ -0,0 +1,124 @@
+#ifndef TERM_STRUCTURE_H
+#define TERM_STRUCTURE_H
+
+#include <cstddef>
+#include <vector>
+
+// Piecewise-constant risk-free rate and volatility, in years from the value date:  rates[k] and
+// vols[k] hold up to times[k] (from times[k - 1], or from 0 for k = 0), and the last pair holds
+// beyond times.back() as well.  A flat market is a single piece.
+class TermStructure
+{
+public:
+	TermStructure(double riskFreeRate, double volatility);
+
+	// Throws std::invalid_argument unless the three are the same nonzero length and times increase
+	// from above 0
+	TermStructure(const std::vector<double>& times, const std::vector<double>& rates, const std::vector<double>& vols);
+
+	// Integrals of the rate and of the variance vol^2 over [t1, t2]
+	double integratedRate(double t1, double t2) const;
+	double integratedVariance(double t1, double t2) const;
+
+	// P(t1, t2) = exp(-integratedRate(t1, t2))
+	double discountFactor(double t1, double t2) const;
+
+	// Every rate moved by rateShift and every vol by volShift (a parallel shift of the curves)
+	TermStructure shifted(double rateShift, double volShift) const;
+
+	std::size_t numPieces() const;
+
+private:
+	friend class TimeStepTable;
+
+	// Calls piece(k, length) for each piece k overlapping [t1, t2], with the length of the overlap
+	template <typename PieceFn>
+	void forEachPiece_(double t1, double t2, PieceFn piece) const;
+
+	std::vector<double> times_;
+	std::vector<double> rates_;
+	std::vector<double> vols_;
+};
+
+// The per-step tables of a path on numTimeSteps equal steps to timeToMaturity, built once per
+// valuation so that a path step is a table lookup and a multiply-add:  step k (1, ..., numTimeSteps)
+// moves the log price by logDrift(k) + diffusion(k) z, and discountFactor(k) is P(0, t_k).  A step
+// within one piece of the curves takes that piece's rate and vol, as a constant market would
+// ((rate - vol^2/2) dt and vol sqrt(dt)); one straddling a knot takes their integrals over the step.
+class TimeStepTable
+{
+public:
+	TimeStepTable(const TermStructure& termStructure, double timeToMaturity, unsigned numTimeSteps);
+
+	unsigned numTimeSteps() const
+	{
+		return static_cast<unsigned>(logDrifts_.size());
+	}
+
+	// Indexed by k - 1 for step k
+	const double* logDrifts() const
+	{
+		return logDrifts_.data();
+	}
+
+	const double* diffusions() const
+	{
+		return diffusions_.data();
+	}
+
+	double logDrift(unsigned step) const
+	{
+		return logDrifts_[step - 1];
+	}
+
+	double diffusion(unsigned step) const
+	{
+		return diffusions_[step - 1];
+	}
+
+	// step = 0, ..., numTimeSteps
+	double discountFactor(unsigned step) const
+	{
+		return discountFactors_[step];
+	}
+
+	// The log drifts and diffusions in Real:  the tables above for double, and a copy rounded to float
+	// for the single-precision kernels (see Precision)
+	template <typename Real>
+	const Real* logDriftsIn() const;
+	template <typename Real>
+	const Real* diffusionsIn() const;
+
+private:
+	std::vector<double> logDrifts_;
+	std::vector<double> diffusions_;
+	std::vector<double> discountFactors_;
+	std::vector<float> singleLogDrifts_;
+	std::vector<float> singleDiffusions_;
+};
+
+template <>
+inline const double* TimeStepTable::logDriftsIn<double>() const
+{
+	return logDrifts_.data();
+}
+
+template <>
+inline const double* TimeStepTable::diffusionsIn<double>() const
+{
+	return diffusions_.data();
+}
+
+template <>
+inline const float* TimeStepTable::logDriftsIn<float>() const
+{
+	return singleLogDrifts_.data();
+}
+
+template <>
+inline const float* TimeStepTable::diffusionsIn<float>() const
+{
+	return singleDiffusions_.data();
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,625 @@
+// Microbenchmarks for the pricing hot paths.  A separate executable from Main.cpp; build it from
+// this file and every source file in the parent directory except Main.cpp, eg
+//
+//   g++ -std=c++17 -O2 -pthread -I.. PricingBenchmarks.cpp $(ls ../*.cpp | grep -v Main.cpp)
+//
+// Usage:  PricingBenchmarks [--quick] [--json <file>]
+//
+// Every benchmark reports the best wall-clock time over a few repetitions, the work items (paths,
+// payoffs, dates, ...) per second, and the heap allocations per repetition, counted by the
+// replacement operator new below.  --json writes the same figures as a JSON document, so that
+// runs from different releases can be compared; --quick cuts the sweeps down for a smoke test.
+
+#include "../BarrierOption.h"
+#include "../EquityPriceGenerator.h"
+#include "../BarrierPayoff.h"
+#include "../RandomStreams.h"
+#include "../PricingThreadPool.h"
+#include "../Date.h"
+#include "../DayCount.h"
+#include "../Egarch.h"
+#include "../BatchPathGenerator.h"
+#include "../EgarchCalibrator.h"
+#include "../TermStructure.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <utility>
+#include <chrono>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include <functional>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+using std::vector;
+using std::string;
+using std::cout;
+using std::endl;
+
+// ---- Allocation counting:  every operator new in the process goes through here ----
+//
+// Every form of operator new and delete is replaced together (plain, array, nothrow, sized and
+// aligned), so whichever pair the compiler or the library picks, the memory comes from malloc (or
+// its aligned form) and goes back to the matching free.
+
+namespace
+{
+	std::atomic<std::size_t> allocationCount(0);
+
+	void* countedMalloc(std::size_t size) noexcept
+	{
+		allocationCount.fetch_add(1, std::memory_order_relaxed);
+		return std::malloc(size != 0 ? size : 1);
+	}
+
+	void* countedAlignedMalloc(std::size_t size, std::align_val_t alignment) noexcept
+	{
+		allocationCount.fetch_add(1, std::memory_order_relaxed);
+		const std::size_t bytes = static_cast<std::size_t>(alignment);
+#if defined(_MSC_VER)
+		return _aligned_malloc(size != 0 ? size : 1, bytes);
+#else
+		// aligned_alloc takes a whole number of alignments
+		return std::aligned_alloc(bytes, (std::max<std::size_t>(size, 1) + bytes - 1) / bytes * bytes);
+#endif
+	}
+
+	void alignedFree(void* p) noexcept
+	{
+#if defined(_MSC_VER)
+		_aligned_free(p);
+#else
+		std::free(p);
+#endif
+	}
+
+	void* orThrow(void* p)
+	{
+		if (p == nullptr)
+		{
+			throw std::bad_alloc();
+		}
+		return p;
+	}
+}
+
+void* operator new(std::size_t size) { return orThrow(countedMalloc(size)); }
+void* operator new[](std::size_t size) { return orThrow(countedMalloc(size)); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return countedMalloc(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return countedMalloc(size); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return orThrow(countedAlignedMalloc(size, alignment)); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return orThrow(countedAlignedMalloc(size, alignment)); }
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return countedAlignedMalloc(size, alignment);
+}
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return countedAlignedMalloc(size, alignment);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { alignedFree(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { alignedFree(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { alignedFree(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { alignedFree(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { alignedFree(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { alignedFree(p); }
+
+namespace
+{
+	struct BenchmarkResult
+	{
+		string name;
+		vector<std::pair<string, double> > parameters;
+		double wallSeconds;		// Best of the repetitions
+		double items;			// Work items per repetition
+		string itemName;
+		double allocations;		// Heap allocations per repetition
+	};
+
+	// Runs fn() repetitions times (after one warm-up run) and keeps the best wall time
+	BenchmarkResult measure(const string& name, const vector<std::pair<string, double> >& parameters, double items,
+		const string& itemName, int repetitions, const std::function<void()>& fn)
+	{
+		fn();
+		double best = 0.0;
+		std::size_t allocations = 0;
+		for (int r = 0; r < repetitions; ++r)
+		{
+			std::size_t allocationsBefore = allocationCount.load();
+			auto begin = std::chrono::steady_clock::now();
+			fn();
+			std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+			allocations = allocationCount.load() - allocationsBefore;
+			best = (r == 0) ? elapsed.count() : std::min(best, elapsed.count());
+		}
+
+		BenchmarkResult result{ name, parameters, best, items, itemName, static_cast<double>(allocations) };
+		cout << "  " << name;
+		for (const auto& p : parameters)
+		{
+			cout << " " << p.first << "=" << p.second;
+		}
+		cout << ":  " << best << " s, " << items / best << " " << itemName << "/s, " << allocations << " allocations" << endl;
+		return result;
+	}
+
+	string toJson(const vector<BenchmarkResult>& results)
+	{
+		std::ostringstream os;
+		os.precision(10);
+		os << "{\n  \"hardwareThreads\": " << std::thread::hardware_concurrency() << ",\n  \"benchmarks\": [\n";
+		for (std::size_t i = 0; i < results.size(); ++i)
+		{
+			const BenchmarkResult& r = results[i];
+			os << "    { \"name\": \"" << r.name << "\", \"parameters\": {";
+			for (std::size_t p = 0; p < r.parameters.size(); ++p)
+			{
+				os << (p == 0 ? " " : ", ") << "\"" << r.parameters[p].first << "\": " << r.parameters[p].second;
+			}
+			os << " }, \"wallSeconds\": " << r.wallSeconds << ", \"items\": " << r.items << ", \"itemName\": \""
+				<< r.itemName << "\", \"itemsPerSecond\": " << r.items / r.wallSeconds << ", \"allocations\": "
+				<< r.allocations << " }" << (i + 1 < results.size() ? "," : "") << "\n";
+		}
+		os << "  ]\n}\n";
+		return os.str();
+	}
+
+	// The demo trade:  2 years, up-and-out put, spot 100, barrier 103
+	const double spot = 100.0, strike = 102.0, barrierLevel = 103.0, rate = 0.025, vol = 0.06;
+	const double tau = 2.0;
+	volatile double sink;		// Keeps the optimizer from discarding the work
+}
+
+int main(int argc, char* argv[])
+{
+	bool quick = false;
+	string jsonFile;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--quick") == 0)
+		{
+			quick = true;
+		}
+		else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+		{
+			jsonFile = argv[++i];
+		}
+		else
+		{
+			std::cerr << "Usage: " << argv[0] << " [--quick] [--json <file>]" << endl;
+			return 1;
+		}
+	}
+
+	const int repetitions = quick ? 1 : 3;
+	const vector<unsigned> stepCounts = quick ? vector<unsigned>{ 50, 720 } : vector<unsigned>{ 50, 180, 720 };
+	const vector<unsigned> scenarioCounts = quick ? vector<unsigned>{ 1000 } : vector<unsigned>{ 1000, 10000 };
+	vector<unsigned> threadCounts;
+	for (unsigned t = 1; t < std::max(std::thread::hardware_concurrency(), 1u); t *= 2)
+	{
+		threadCounts.push_back(t);
+	}
+	threadCounts.push_back(std::max(std::thread::hardware_concurrency(), 1u));
+
+	vector<BenchmarkResult> results;
+	const unsigned numPaths = quick ? 500 : 2000;
+
+	cout << "Path generation and payoff evaluation (one thread):" << endl;
+	for (unsigned steps : stepCounts)
+	{
+		const EquityPriceGenerator epg(spot, steps, tau, rate, vol);
+		const double params = steps;
+
+		results.push_back(measure("EquityPriceGenerator::operator()", { { "steps", params } }, numPaths, "paths",
+			repetitions, [&]()
+		{
+			double sum = 0.0;
+			for (unsigned i = 0; i < numPaths; ++i)
+			{
+				sum += epg(static_cast<int>(i)).back();
+			}
+			sink = sum;
+		}));
+
+		// Barrier far away, so that every path runs to expiry
+		results.push_back(measure("EquityPriceGenerator::simulate (fused, Philox)", { { "steps", params } }, numPaths,
+			"paths", repetitions, [&]()
+		{
+			double sum = 0.0;
+			for (unsigned i = 0; i < numPaths; ++i)
+			{
+				PhiloxNormals normals(0, i);
+				BarrierPayoff payoff(Barrier::UP_AND_OUT, OptionType::PUT, 1.0e9, strike);
+				epg.simulate(normals, payoff);
+				sum += payoff.payoff();
+			}
+			sink = sum;
+		}));
+
+		// EGARCH volatility (log variance reverting to about log(vol^2)):  per path, and in blocks
+		// of lanes with the batch kernel, against the batch kernel at a constant vol
+		const std::shared_ptr<const Egarch> egarch = std::make_shared<const Egarch>(-0.1363, 0.1123, -0.0925, 0.9855, 0);
+		const EquityPriceGenerator egarchPaths(spot, steps, tau, rate, vol, egarch);
+		results.push_back(measure("EquityPriceGenerator::simulate (fused, Philox, EGARCH)", { { "steps", params } },
+			numPaths, "paths", repetitions, [&]()
+		{
+			double sum = 0.0;
+			for (unsigned i = 0; i < numPaths; ++i)
+			{
+				PhiloxNormals normals(0, i);
+				BarrierPayoff payoff(Barrier::UP_AND_OUT, OptionType::PUT, 1.0e9, strike);
+				egarchPaths.simulate(normals, payoff);
+				sum += payoff.payoff();
+			}
+			sink = sum;
+		}));
+
+		// Rate and vol curves with a knot every quarter:  the step reads its drift and diffusion from
+		// the tables, and the tables are built once per valuation
+		vector<double> times, rates, vols;
+		for (int q = 1; q <= 8; ++q)
+		{
+			times.push_back(0.25 * q);
+			rates.push_back(rate + 0.001 * q);
+			vols.push_back(vol + 0.005 * q);
+		}
+		const TermStructure termStructure(times, rates, vols);
+		const EquityPriceGenerator curvePaths(spot, steps, tau, termStructure);
+		results.push_back(measure("EquityPriceGenerator::simulate (fused, Philox, term structure)", { { "steps", params } },
+			numPaths, "paths", repetitions, [&]()
+		{
+			double sum = 0.0;
+			for (unsigned i = 0; i < numPaths; ++i)
+			{
+				PhiloxNormals normals(0, i);
+				BarrierPayoff payoff(Barrier::UP_AND_OUT, OptionType::PUT, 1.0e9, strike);
+				curvePaths.simulate(normals, payoff);
+				sum += payoff.payoff();
+			}
+			sink = sum;
+		}));
+
+		const unsigned numTables = quick ? 1000 : 10000;
+		results.push_back(measure("TimeStepTable (8 pieces)", { { "steps", params } }, numTables, "tables", repetitions, [&]()
+		{
+			double sum = 0.0;
+			for (unsigned i = 0; i < numTables; ++i)
+			{
+				sum += TimeStepTable(termStructure, tau, steps).discountFactor(steps);
+			}
+			sink = sum;
+		}));
+
+		const BatchPathGenerator batches[] = { BatchPathGenerator(spot, steps, tau, rate, vol),
+			BatchPathGenerator(spot, steps, tau, rate, vol, egarch), BatchPathGenerator(spot, steps, tau, termStructure),
+			BatchPathGenerator(spot, steps, tau, rate, vol, RandomStream::PHILOX, BatchPathGenerator::bestKernel(),
+				Precision::SINGLE) };
+		const char* batchNames[] = { "BatchPathGenerator::simulate (best kernel)",
+			"BatchPathGenerator::simulate (best kernel, EGARCH)", "BatchPathGenerator::simulate (best kernel, term structure)",
+			"BatchPathGenerator::simulate (best kernel, single precision)" };
+		for (int b = 0; b < 4; ++b)
+		{
+			results.push_back(measure(batchNames[b], { { "steps", params } }, numPaths, "paths", repetitions, [&]()
+			{
+				double terminalPrices[BatchPathGenerator::maxLanes];
+				bool hitBarrier[BatchPathGenerator::maxLanes];
+				double sum = 0.0;
+				for (unsigned i = 0; i < numPaths; i += batches[b].lanes())
+				{
+					unsigned lanes = std::min(batches[b].lanes(), numPaths - i);
+					batches[b].simulate(0, i, lanes, Barrier::UP_AND_OUT, 1.0e9, terminalPrices, hitBarrier);
+					sum += terminalPrices[0];
+				}
+				sink = sum;
+			}));
+		}
+	}
+
+	{
+		// The payoff alone, over one stored path (as knock-ins, which see every price)
+		const EquityPriceGenerator generator(spot, 720, tau, rate, vol);
+		const vector<double> path = generator(1);
+		const unsigned numEvaluations = quick ? 2000 : 20000;
+		results.push_back(measure("BarrierPayoff over a stored path", { { "steps", 720.0 } },
+			static_cast<double>(numEvaluations) * path.size(), "prices", repetitions, [&]()
+		{
+			double sum = 0.0;
+			for (unsigned i = 0; i < numEvaluations; ++i)
+			{
+				BarrierPayoff payoff(Barrier::UP_AND_IN, OptionType::PUT, barrierLevel + 1.0e-6 * i, strike);
+				for (double price : path)
+				{
+					payoff(price);
+				}
+				sum += payoff.payoff();
+			}
+			sink = sum;
+		}));
+		results.push_back(measure("PolicyBarrierPayoff over a stored path", { { "steps", 720.0 } },
+			static_cast<double>(numEvaluations) * path.size(), "prices", repetitions, [&]()
+		{
+			typedef PolicyBarrierPayoff<BarrierPolicy<Barrier::UP_AND_IN, OptionType::PUT> > Payoff;
+			double sum = 0.0;
+			for (unsigned i = 0; i < numEvaluations; ++i)
+			{
+				Payoff payoff(barrierLevel + 1.0e-6 * i, strike, 0.0, generator.steps());
+				for (double price : path)
+				{
+					payoff(price);
+				}
+				sum += payoff.payoff();
+			}
+			sink = sum;
+		}));
+		results.push_back(measure("ContinuousBarrierPayoff over a stored path", { { "steps", 720.0 } },
+			static_cast<double>(numEvaluations) * path.size(), "prices", repetitions, [&]()
+		{
+			typedef ContinuousBarrierPayoff<BarrierPolicy<Barrier::UP_AND_IN, OptionType::PUT> > Payoff;
+			double sum = 0.0;
+			for (unsigned i = 0; i < numEvaluations; ++i)
+			{
+				Payoff payoff(barrierLevel + 1.0e-6 * i, strike, vol, tau / 720);
+				for (double price : path)
+				{
+					payoff(price);
+				}
+				sum += payoff.payoff();
+			}
+			sink = sum;
+		}));
+		results.push_back(measure("CorridorBarrierPayoff (double, bridge) over a stored path", { { "steps", 720.0 } },
+			static_cast<double>(numEvaluations) * path.size(), "prices", repetitions, [&]()
+		{
+			typedef CorridorBarrierPayoff<BarrierPolicy<Barrier::UP_AND_IN, OptionType::PUT> > Payoff;
+			double sum = 0.0;
+			for (unsigned i = 0; i < numEvaluations; ++i)
+			{
+				Payoff payoff(spot * spot / barrierLevel, barrierLevel + 1.0e-6 * i, strike, 0.0, 0, 720, vol, tau / 720,
+					generator.steps());
+				for (double price : path)
+				{
+					payoff(price);
+				}
+				sum += payoff.payoff();
+			}
+			sink = sum;
+		}));
+	}
+
+	// Whole valuations:  serial (runParallel = false) against the pool (runParallel = true) on
+	// 1, 2, 4, ... threads, with the greeks by bump-and-reprice (four price runs) and in one pass
+	cout << "BarrierOption valuation (price + 3 greeks):" << endl;
+	const Date valueDate(2015, 10, 1);
+	const Date expiryDate(2017, 9, 30);
+	const Date settlementDate(Date(expiryDate).addDays(1));
+	const Act365 act365;
+	const GreeksMethod greeksMethods[] = { GreeksMethod::BUMP_AND_REPRICE, GreeksMethod::SINGLE_PASS };
+	const char* greeksNames[] = { "bump and reprice", "single pass" };
+	for (int g = 0; g < 2; ++g)
+	{
+		EngineSettings settings;
+		settings.greeksMethod = greeksMethods[g];
+		const double valuations = (greeksMethods[g] == GreeksMethod::BUMP_AND_REPRICE) ? 4.0 : 1.0;
+
+		for (unsigned steps : stepCounts)
+		{
+			for (unsigned scenarios : scenarioCounts)
+			{
+				const double paths = valuations * scenarios;
+				results.push_back(measure(string("BarrierOption serial, ") + greeksNames[g],
+					{ { "steps", double(steps) }, { "scenarios", double(scenarios) }, { "threads", 1.0 } }, paths, "paths",
+					repetitions, [&]()
+				{
+					BarrierOption option(barrierLevel, strike, spot, rate, vol, 1.0, Barrier::UP_AND_OUT, valueDate,
+						expiryDate, settlementDate, steps, scenarios, false, -106, 0.01, act365, nullptr, settings);
+					sink = option().resultSet.at(OptionResults::PRICE);
+				}));
+
+				for (unsigned threads : threadCounts)
+				{
+					PricingThreadPool pool(threads);
+					results.push_back(measure(string("BarrierOption async, ") + greeksNames[g],
+						{ { "steps", double(steps) }, { "scenarios", double(scenarios) }, { "threads", double(threads) } },
+						paths, "paths", repetitions, [&]()
+					{
+						BarrierOption option(barrierLevel, strike, spot, rate, vol, 1.0, Barrier::UP_AND_OUT, valueDate,
+							expiryDate, settlementDate, steps, scenarios, true, -106, 0.01, act365, &pool, settings);
+						sink = option().resultSet.at(OptionResults::PRICE);
+					}));
+				}
+			}
+		}
+	}
+
+	// Sensitivities to spot, vol, rate, strike and barrier:  two price runs per bumped input against
+	// one adjoint pass, for a down-and-out call near its barrier (serial)
+	cout << "BarrierOption sensitivities to five inputs (serial):" << endl;
+	for (unsigned steps : stepCounts)
+	{
+		const unsigned scenarios = scenarioCounts.front();
+		const vector<std::pair<string, double> > params = { { "steps", double(steps) }, { "scenarios", double(scenarios) } };
+		auto downAndOut = [&](const double* x, const EngineSettings& settings)
+		{
+			return BarrierOption(x[4], x[3], x[0], x[2], x[1], 1.0, Barrier::DOWN_AND_OUT, OptionType::CALL, valueDate,
+				expiryDate, settlementDate, steps, scenarios, false, -106, 0.01, act365, nullptr, settings);
+		};
+		const double inputs[5] = { spot, 0.20, rate, strike, 96.0 };
+
+		results.push_back(measure("BarrierOption bump and reprice, 5 inputs", params, 10.0 * scenarios, "paths",
+			repetitions, [&]()
+		{
+			double sum = 0.0;
+			for (int k = 0; k < 10; ++k)
+			{
+				double x[5];
+				std::copy(inputs, inputs + 5, x);
+				x[k / 2] *= (k % 2 == 0) ? 1.01 : 0.99;		// Central differences
+				sum += downAndOut(x, EngineSettings())(OptionResults::PRICE_ONLY).resultSet.at(OptionResults::PRICE);
+			}
+			sink = sum;
+		}));
+
+		EngineSettings adjoint;
+		adjoint.greeksMethod = GreeksMethod::ADJOINT;
+		results.push_back(measure("BarrierOption adjoint, 5 inputs", params, scenarios, "paths", repetitions, [&]()
+		{
+			sink = downAndOut(inputs, adjoint)(OptionResults::FIRST_ORDER | OptionResults::CONTRACT_SENSITIVITIES)
+				.resultSet.at(OptionResults::BARRIER_SENSITIVITY);
+		}));
+	}
+
+	// The same standard error from one level of 720 steps and from multilevel Monte Carlo over 12 ..
+	// 720 steps, for a down-and-out call whose paths mostly live to expiry (serial)
+	cout << "BarrierOption to a target standard error (serial):" << endl;
+	{
+		const double targetStdError = quick ? 0.1 : 0.05;
+		const vector<std::pair<string, double> > params = { { "steps", 720.0 }, { "target", targetStdError } };
+		const char* names[] = { "BarrierOption one level", "BarrierOption multilevel" };
+		for (int k = 0; k < 2; ++k)
+		{
+			EngineSettings settings;
+			settings.targetStdError = targetStdError;
+			settings.multilevel = (k == 1);
+			results.push_back(measure(names[k], params, 1.0, "valuations", repetitions, [&]()
+			{
+				BarrierOption option(85.0, strike, spot, rate, 0.20, 1.0, Barrier::DOWN_AND_OUT, OptionType::CALL,
+					valueDate, expiryDate, settlementDate, 720, 10000000, false, -106, 0.01, act365, nullptr, settings);
+				sink = option(OptionResults::PRICE_ONLY).resultSet.at(OptionResults::PRICE);
+			}));
+		}
+	}
+
+	cout << "Dates and EGARCH:" << endl;
+	const unsigned numDates = quick ? 100000 : 1000000;
+	results.push_back(measure("Date(year, month, day)", {}, numDates, "dates", repetitions, [&]()
+	{
+		long long sum = 0;
+		for (unsigned i = 0; i < numDates; ++i)
+		{
+			sum += Date(1950 + i % 200, 1 + i % 12, 1 + i % 28).serialDate();
+		}
+		sink = static_cast<double>(sum);
+	}));
+	results.push_back(measure("Date(serial)", {}, numDates, "dates", repetitions, [&]()
+	{
+		long long sum = 0;
+		for (unsigned i = 0; i < numDates; ++i)
+		{
+			sum += Date(1 + static_cast<int>(i % 100000)).day();
+		}
+		sink = static_cast<double>(sum);
+	}));
+	results.push_back(measure("Date::addMonths", {}, numDates, "dates", repetitions, [&]()
+	{
+		Date date(2015, 1, 31);
+		long long sum = 0;
+		for (unsigned i = 0; i < numDates; ++i)
+		{
+			date.addMonths((i % 2 == 0) ? 1 : -1);
+			sum += date.day();
+		}
+		sink = static_cast<double>(sum);
+	}));
+	results.push_back(measure("Act365::yearFraction", {}, numDates, "dates", repetitions, [&]()
+	{
+		double sum = 0.0;
+		for (unsigned i = 0; i < numDates; ++i)
+		{
+			sum += act365.yearFraction(valueDate, expiryDate);
+		}
+		sink = sum;
+	}));
+
+	const unsigned numEgarchSteps = quick ? 100000 : 1000000;
+	results.push_back(measure("Egarch step", {}, numEgarchSteps, "steps", repetitions, [&]()
+	{
+		Egarch egarch(-0.0883, 0.1123, -0.0925, 0.9855, 520);
+		PhiloxNormals normals(520, 0);
+		double sigma = 0.25;
+		for (unsigned i = 0; i < numEgarchSteps; ++i)
+		{
+			sigma = std::sqrt(std::exp(egarch(sigma, normals())));
+		}
+		sink = sigma;
+	}));
+	results.push_back(measure("Egarch step in log variance", {}, numEgarchSteps, "steps", repetitions, [&]()
+	{
+		Egarch egarch(-0.0883, 0.1123, -0.0925, 0.9855, 520);
+		PhiloxNormals normals(520, 0);
+		double logVariance = std::log(0.25 * 0.25);
+		for (unsigned i = 0; i < numEgarchSteps; ++i)
+		{
+			logVariance = egarch.logVariance(logVariance, normals());
+		}
+		sink = std::exp(0.5 * logVariance);
+	}));
+
+	// Maximum-likelihood fits of ten years of daily returns per series, one series per task
+	const unsigned numSeries = quick ? 16 : 64;
+	const unsigned numReturns = 2520;
+	vector<double> returns(static_cast<std::size_t>(numSeries) * numReturns);
+	vector<ReturnSeries> series;
+	{
+		Egarch process(-0.38, 0.15, -0.4, 0.97, 0);
+		for (unsigned k = 0; k < numSeries; ++k)
+		{
+			PhiloxNormals normals(7, k);
+			double logVariance = -8.7;
+			double* r = &returns[static_cast<std::size_t>(k) * numReturns];
+			for (unsigned t = 0; t < numReturns; ++t)
+			{
+				double z = normals();
+				r[t] = std::exp(0.5 * logVariance) * z;
+				logVariance = process.logVariance(logVariance, z);
+			}
+			series.push_back(ReturnSeries{ r, numReturns });
+		}
+	}
+	results.push_back(measure("EgarchCalibrator::logLikelihood and gradient", { { "returns", double(numReturns) } },
+		numSeries, "series", repetitions, [&]()
+	{
+		const double parameters[EgarchCalibrator::NUM_PARAMETERS] = { -0.38, 0.15, -0.4, 0.97 };
+		double gradient[EgarchCalibrator::NUM_PARAMETERS];
+		double sum = 0.0;
+		for (const ReturnSeries& s : series)
+		{
+			sum += EgarchCalibrator::logLikelihood(s.returns, s.numReturns, parameters, gradient);
+		}
+		sink = sum;
+	}));
+	for (unsigned threads : threadCounts)
+	{
+		PricingThreadPool pool(threads);
+		results.push_back(measure("EgarchCalibrator fit", { { "returns", double(numReturns) }, { "threads", double(threads) } },
+			numSeries, "series", repetitions, [&]()
+		{
+			vector<EgarchFit> fits = EgarchCalibrator(200, 1.0e-7, &pool)(series);
+			sink = fits[0].beta;
+		}));
+	}
+
+	if (!jsonFile.empty())
+	{
+		std::ofstream out(jsonFile);
+		out << toJson(results);
+		if (!out)
+		{
+			std::cerr << "Could not write " << jsonFile << endl;
+			return 1;
+		}
+		cout << "Results written to " << jsonFile << endl;
+	}
+	return 0;
+}
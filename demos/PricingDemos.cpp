@@ -0,0 +1,964 @@
+// Demonstrations of the engine's estimators and settings, one function per feature, each printing
+// its figures against a reference (a closed form, a finer grid, another engine on the same draws).
+// A separate executable from Main.cpp; build it from this file and every source file in the parent
+// directory except Main.cpp, eg
+//
+//   g++ -std=c++17 -O2 -pthread -I.. PricingDemos.cpp $(ls ../*.cpp | grep -v Main.cpp)
+//
+// Usage:  PricingDemos [<demo> ...]
+//
+// With no arguments every demo runs, in the order below; otherwise only those named.
+
+#include "../EquityPriceGenerator.h"
+#include "../BarrierOption.h"
+#include "../ResultSet.h"
+#include "../Date.h"
+#include "../Egarch.h"
+#include "../PricingThreadPool.h"
+#include "../BatchPathGenerator.h"
+#include "../AnalyticBarrier.h"
+#include "../DiscreteBarrier.h"
+#include "../PortfolioPricer.h"
+#include "../NormalStore.h"
+#include "../EgarchCalibrator.h"
+#include "../TermStructure.h"
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+using std::vector;
+using std::cout;
+using std::endl;
+
+void threadPoolScaling(unsigned maxThreads);
+void pathGeneratorThroughput(unsigned numPaths);
+void qmcConvergence();
+void analyticBarrier();
+void bridgeCorrection();
+void targetPrecision(double targetStdError);
+void portfolioPricing(unsigned numTrades);
+void runStatistics();
+void selectiveValuation();
+void marketTicks(unsigned numTicks);
+void normalStore(unsigned numScenarios);
+void secondOrderGreeks();
+void adjointSensitivities();
+void egarchBarrier();
+void egarchCalibration(unsigned numSymbols);
+void multilevelMonteCarlo(double targetStdError);
+void termStructure();
+void payoffPolicies();
+void doubleAndWindowBarriers();
+void singlePrecision();
+
+int main(int argc, char** argv)
+{
+	const struct { const char* name; void (*run)(); } demos[] = {
+		{ "threadPoolScaling", [] { threadPoolScaling(std::thread::hardware_concurrency()); } },
+		{ "pathGeneratorThroughput", [] { pathGeneratorThroughput(20000); } },
+		{ "qmcConvergence", [] { qmcConvergence(); } },
+		{ "analyticBarrier", [] { analyticBarrier(); } },
+		{ "bridgeCorrection", [] { bridgeCorrection(); } },
+		{ "targetPrecision", [] { targetPrecision(100.0); } },
+		{ "portfolioPricing", [] { portfolioPricing(1000); } },
+		{ "runStatistics", [] { runStatistics(); } },
+		{ "selectiveValuation", [] { selectiveValuation(); } },
+		{ "marketTicks", [] { marketTicks(20); } },
+		{ "normalStore", [] { normalStore(2000); } },
+		{ "secondOrderGreeks", [] { secondOrderGreeks(); } },
+		{ "adjointSensitivities", [] { adjointSensitivities(); } },
+		{ "egarchBarrier", [] { egarchBarrier(); } },
+		{ "egarchCalibration", [] { egarchCalibration(200); } },
+		{ "multilevelMonteCarlo", [] { multilevelMonteCarlo(200.0); } },
+		{ "termStructure", [] { termStructure(); } },
+		{ "payoffPolicies", [] { payoffPolicies(); } },
+		{ "doubleAndWindowBarriers", [] { doubleAndWindowBarriers(); } },
+		{ "singlePrecision", [] { singlePrecision(); } } };
+
+	bool any = false;
+	for (const auto& demo : demos)
+	{
+		const bool named = std::find_if(argv + 1, argv + argc, [&demo](const char* arg)
+		{
+			return std::strcmp(arg, demo.name) == 0;
+		}) != argv + argc;
+		if (argc == 1 || named)
+		{
+			demo.run();
+			any = true;
+		}
+	}
+	if (!any)
+	{
+		std::cerr << "Usage:  PricingDemos [<demo> ...], the demos being";
+		for (const auto& demo : demos)
+		{
+			std::cerr << " " << demo.name;
+		}
+		std::cerr << endl;
+		return 1;
+	}
+	return 0;
+}
+
+void threadPoolScaling(unsigned maxThreads)
+{
+	// Wall-clock time for the same trade priced on pools of 1..maxThreads threads.
+	// (clock() would report CPU time summed over all threads, which hides the speedup.)
+	cout << "Thread pool scaling (wall time, price + 3 greeks): " << endl;
+	Date valueDate(2015, 10, 1);
+	Date expiryDate(2017, 9, 30);
+	Date settlementDate(expiryDate.addDays(1));
+	Act365 act365;
+	double baseTime = 0.0;
+
+	for (unsigned numThreads = 1; numThreads <= std::max(maxThreads, 1u); ++numThreads)
+	{
+		PricingThreadPool pool(numThreads);
+		auto begin = std::chrono::steady_clock::now();
+		BarrierOption upOutBarrier(103.0, 102.0, 100.0, 0.025, 0.06, 7000.0, Barrier::UP_AND_OUT,
+			valueDate, expiryDate, settlementDate, 720, 10000, true, -106, 0.01, act365, &pool);
+		const double price = upOutBarrier().resultSet.at(OptionResults::PRICE);
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+
+		if (numThreads == 1)
+		{
+			baseTime = elapsed.count();
+		}
+		cout << "  threads = " << numThreads << ": " << elapsed.count() << " s, speedup = "
+			<< baseTime / elapsed.count() << ", price = " << price << endl;
+	}
+	cout << endl;
+}
+
+void pathGeneratorThroughput(unsigned numPaths)
+{
+	// Single-threaded paths/sec for full-length 720 step paths (the barrier is never hit),
+	// comparing the scalar EquityPriceGenerator with each BatchPathGenerator kernel.
+	cout << "Path generator throughput (" << numPaths << " paths x 720 steps, one thread): " << endl;
+	const double spot = 100.0, tau = 2.0, rate = 0.025, vol = 0.06, farBarrier = 1.0e9;
+	EquityPriceGenerator epg(spot, 720, tau, rate, vol);
+	double checkSum = 0.0;		// Keeps the optimizer from discarding the work
+
+	auto report = [numPaths](const char* name, std::chrono::steady_clock::time_point begin)
+	{
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+		cout << "  " << name << ": " << numPaths / elapsed.count() << " paths/s" << endl;
+	};
+
+	auto begin = std::chrono::steady_clock::now();
+	for (unsigned i = 0; i < numPaths; ++i)
+	{
+		checkSum += epg(static_cast<int>(i)).back();
+	}
+	report("EquityPriceGenerator::operator()", begin);
+
+	const BatchPathGenerator::Kernel kernels[] = { BatchPathGenerator::Kernel::SCALAR,
+		BatchPathGenerator::Kernel::AVX2, BatchPathGenerator::Kernel::AVX512 };
+	const char* kernelNames[] = { "BatchPathGenerator (scalar)", "BatchPathGenerator (AVX2)", "BatchPathGenerator (AVX-512)" };
+	BatchPathGenerator::Kernel best = BatchPathGenerator::bestKernel();
+
+	for (int k = 0; k < 3; ++k)
+	{
+		if (kernels[k] > best)
+		{
+			cout << "  " << kernelNames[k] << ": not supported by this CPU" << endl;
+			continue;
+		}
+
+		BatchPathGenerator batch(spot, 720, tau, rate, vol, RandomStream::PHILOX, kernels[k]);
+		double terminalPrices[BatchPathGenerator::maxLanes];
+		bool knockedOut[BatchPathGenerator::maxLanes];
+
+		begin = std::chrono::steady_clock::now();
+		for (unsigned i = 0; i < numPaths; i += batch.lanes())
+		{
+			unsigned lanes = std::min(batch.lanes(), numPaths - i);
+			batch.simulate(0, i, lanes, Barrier::UP_AND_OUT, farBarrier, terminalPrices, knockedOut);
+			checkSum += terminalPrices[0];
+		}
+		report(kernelNames[k], begin);
+	}
+	cout << "  (checksum " << checkSum << ")" << endl << endl;
+}
+
+void qmcConvergence()
+{
+	// Error against wall time for pseudo-random (Philox) and Sobol paths on the demo trade.  The
+	// reference is a long Sobol run; the error column is the distance from it, the stderr column
+	// is each run's own estimate (sample variance for MC, spread of the 16 replications for QMC).
+	cout << "Convergence, MC vs randomized QMC (price + 3 greeks, one pass): " << endl;
+	Date valueDate(2015, 10, 1);
+	Date expiryDate(2017, 9, 30);
+	Date settlementDate(expiryDate.addDays(1));
+	Act365 act365;
+
+	auto price = [&](RandomStream randomStream, unsigned numScenarios, double& stdError, double& seconds)
+	{
+		EngineSettings settings;
+		settings.randomStream = randomStream;
+		auto begin = std::chrono::steady_clock::now();
+		BarrierOption upOutBarrier(103.0, 102.0, 100.0, 0.025, 0.06, 7000.0, Barrier::UP_AND_OUT,
+			valueDate, expiryDate, settlementDate, 720, numScenarios, true, -106, 0.01, act365, nullptr, settings);
+		const double price = upOutBarrier().resultSet.at(OptionResults::PRICE);
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+		stdError = upOutBarrier.stdError();
+		seconds = elapsed.count();
+		return price;
+	};
+
+	double refError, refTime;
+	const double reference = price(RandomStream::SOBOL, 1 << 18, refError, refTime);
+	cout << "  reference (Sobol, 2^18 paths) = " << reference << " +/- " << refError << endl;
+
+	const RandomStream streams[] = { RandomStream::PHILOX, RandomStream::SOBOL };
+	const char* streamNames[] = { "MC  ", "QMC " };
+	for (int k = 0; k < 2; ++k)
+	{
+		for (unsigned numScenarios = 1 << 10; numScenarios <= 1 << 16; numScenarios <<= 2)
+		{
+			double stdError, seconds;
+			double p = price(streams[k], numScenarios, stdError, seconds);
+			cout << "  " << streamNames[k] << "paths = " << numScenarios << ": price = " << p << ", error = "
+				<< std::abs(p - reference) << ", stderr = " << stdError << ", " << seconds << " s" << endl;
+		}
+	}
+	cout << endl;
+}
+
+void analyticBarrier()
+{
+	// The demo trade priced in closed form (continuous barrier), by Monte Carlo (barrier checked at
+	// the 720 steps), and by Monte Carlo with the closed form as a control variate; then the
+	// closed-form cost per trade over all eight barrier types.
+	cout << "Closed-form barrier pricing and control variate: " << endl;
+	Date valueDate(2015, 10, 1);
+	Date expiryDate(2017, 9, 30);
+	Date settlementDate(expiryDate.addDays(1));
+	Act365 act365;
+
+	EngineSettings analytic, monteCarlo, controlled;
+	analytic.pricingMethod = PricingMethod::ANALYTIC;
+	controlled.controlVariate = ControlVariate::ANALYTIC;
+	const EngineSettings settings[] = { analytic, monteCarlo, controlled };
+	const char* names[] = { "closed form (continuous)", "MC", "MC + control variate" };
+	for (int k = 0; k < 3; ++k)
+	{
+		auto begin = std::chrono::steady_clock::now();
+		BarrierOption upOutBarrier(103.0, 102.0, 100.0, 0.025, 0.06, 7000.0, Barrier::UP_AND_OUT, valueDate,
+			expiryDate, settlementDate, 720, 10000, true, -106, 0.01, act365, nullptr, settings[k]);
+		OptionResults res = upOutBarrier();
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+		cout << "  " << names[k] << ": price = " << res.resultSet.at(OptionResults::PRICE) << " +/- "
+			<< upOutBarrier.stdError() << ", delta = " << res.resultSet.at(OptionResults::DELTA) << ", "
+			<< elapsed.count() << " s" << endl;
+	}
+
+	const Barrier barriers[] = { Barrier::UP_AND_OUT, Barrier::DOWN_AND_OUT, Barrier::UP_AND_IN, Barrier::DOWN_AND_IN };
+	const unsigned numTrades = 100000;
+	double checkSum = 0.0;
+	auto begin = std::chrono::steady_clock::now();
+	for (unsigned i = 0; i < numTrades; ++i)
+	{
+		AnalyticBarrier trade(barriers[i % 4], (i % 8 < 4) ? OptionType::CALL : OptionType::PUT,
+			95.0 + (i % 11), 90.0 + (i % 21), 1.0);
+		checkSum += trade.values(100.0, 0.025, 0.06 + 0.001 * (i % 50), 2.0, 2.003).resultSet.at(OptionResults::PRICE);
+	}
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+	cout << "  closed form with greeks: " << 1.0e6 * elapsed.count() / numTrades << " us per trade (checksum "
+		<< checkSum << ")" << endl << endl;
+}
+
+void bridgeCorrection()
+{
+	// The demo trade taken as monitored at the 720 time steps, priced by plain Monte Carlo on the
+	// full grid and on a 50 step grid, and on the 50 step grid with each Brownian-bridge correction
+	// plus the Broadie-Glasserman shift for the 720 monitoring dates.
+	cout << "Brownian-bridge barrier correction (contract monitored at 720 dates): " << endl;
+	Date valueDate(2015, 10, 1);
+	Date expiryDate(2017, 9, 30);
+	Date settlementDate(expiryDate.addDays(1));
+	Act365 act365;
+
+	EngineSettings discrete, weighted, sampled, analytic;
+	weighted.barrierMonitoring = BarrierMonitoring::BRIDGE_WEIGHT;
+	sampled.barrierMonitoring = BarrierMonitoring::BRIDGE_SAMPLED;
+	analytic.pricingMethod = PricingMethod::ANALYTIC;
+	weighted.monitoringDates = sampled.monitoringDates = analytic.monitoringDates = 720;
+
+	const EngineSettings settings[] = { analytic, discrete, discrete, weighted, sampled };
+	const unsigned numTimeSteps[] = { 720, 720, 50, 50, 50 };
+	const char* names[] = { "closed form (shifted barrier)", "MC, 720 steps", "MC, 50 steps",
+		"MC + bridge weight, 50 steps", "MC + sampled crossings, 50 steps" };
+	for (int k = 0; k < 5; ++k)
+	{
+		auto begin = std::chrono::steady_clock::now();
+		BarrierOption upOutBarrier(103.0, 102.0, 100.0, 0.025, 0.06, 7000.0, Barrier::UP_AND_OUT, valueDate,
+			expiryDate, settlementDate, numTimeSteps[k], 10000, true, -106, 0.01, act365, nullptr, settings[k]);
+		OptionResults res = upOutBarrier();
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+		cout << "  " << names[k] << ": price = " << res.resultSet.at(OptionResults::PRICE) << " +/- "
+			<< upOutBarrier.stdError() << ", delta = " << res.resultSet.at(OptionResults::DELTA) << ", "
+			<< elapsed.count() << " s" << endl;
+	}
+	cout << endl;
+}
+
+void targetPrecision(double targetStdError)
+{
+	// Scenarios and wall time each variance reduction needs to bring the demo trade's standard error
+	// down to the target (at most 10^6 scenarios), and what a fixed time budget buys.
+	cout << "Target precision (standard error " << targetStdError << "): " << endl;
+	Date valueDate(2015, 10, 1);
+	Date expiryDate(2017, 9, 30);
+	Date settlementDate(expiryDate.addDays(1));
+	Act365 act365;
+
+	EngineSettings plain, antithetic, terminalSpot, analytic, budget;
+	plain.targetStdError = antithetic.targetStdError = terminalSpot.targetStdError = analytic.targetStdError = targetStdError;
+	antithetic.antithetic = terminalSpot.antithetic = analytic.antithetic = true;
+	terminalSpot.controlVariate = ControlVariate::TERMINAL_SPOT;
+	analytic.controlVariate = ControlVariate::ANALYTIC;
+	budget.timeBudget = 0.1;
+
+	const EngineSettings settings[] = { plain, antithetic, terminalSpot, analytic, budget };
+	const char* names[] = { "MC", "antithetic", "antithetic + terminal spot control", "antithetic + analytic control",
+		"MC, 0.1 s budget" };
+	for (int k = 0; k < 5; ++k)
+	{
+		auto begin = std::chrono::steady_clock::now();
+		BarrierOption upOutBarrier(103.0, 102.0, 100.0, 0.025, 0.06, 7000.0, Barrier::UP_AND_OUT, valueDate,
+			expiryDate, settlementDate, 720, 1000000, true, -106, 0.01, act365, nullptr, settings[k]);
+		OptionResults res = upOutBarrier();
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+		cout << "  " << names[k] << ": price = " << res.resultSet.at(OptionResults::PRICE) << " +/- "
+			<< res.resultSet.at(OptionResults::STD_ERROR) << ", scenarios = " << res.resultSet.at(OptionResults::NUM_SCENARIOS)
+			<< ", " << elapsed.count() << " s" << endl;
+	}
+	cout << endl;
+}
+
+void portfolioPricing(unsigned numTrades)
+{
+	// A book of numTrades barrier trades of every type on the demo market, priced with shared paths,
+	// against pricing the first few as separate BarrierOptions (same seed, so the same values).
+	cout << "Portfolio pricing (" << numTrades << " trades, 10000 paths x 720 steps): " << endl;
+	Date valueDate(2015, 10, 1);
+	Date expiryDate(2017, 9, 30);
+	Date settlementDate(expiryDate.addDays(1));
+	Act365 act365;
+
+	const Barrier barriers[] = { Barrier::UP_AND_OUT, Barrier::DOWN_AND_OUT, Barrier::UP_AND_IN, Barrier::DOWN_AND_IN };
+	vector<BarrierTrade> trades;
+	for (unsigned i = 0; i < numTrades; ++i)
+	{
+		Barrier barrier = barriers[i % 4];
+		trades.push_back(BarrierTrade(isUpBarrier(barrier) ? 103.0 + (i % 7) : 97.0 - (i % 7), 95.0 + (i % 11), 100.0,
+			0.025, 0.06, 7000.0, barrier, (i % 8 < 4) ? OptionType::CALL : OptionType::PUT, valueDate, expiryDate,
+			settlementDate, 720));
+	}
+
+	PortfolioPricer portfolio(10000, -106, 0.01, act365);
+	auto begin = std::chrono::steady_clock::now();
+	OptionResultTable rows = portfolio.table(trades);
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+	cout << "  shared paths: " << elapsed.count() << " s, path sets = " << portfolio.numPathSets(trades) << endl;
+
+	// Book totals straight off the columns, and the whole table in one write
+	const double* prices = rows.column(OptionResults::PRICE);
+	const double* deltas = rows.column(OptionResults::DELTA);
+	std::ostringstream out;
+	rows.write(out);
+	cout << "  book value = " << std::accumulate(prices, prices + rows.size(), 0.0) << ", book delta = "
+		<< std::accumulate(deltas, deltas + rows.size(), 0.0) << ", table = " << out.str().size() << " bytes" << endl;
+
+	const unsigned numSingle = 4;
+	begin = std::chrono::steady_clock::now();
+	for (unsigned i = 0; i < numSingle; ++i)
+	{
+		const BarrierTrade& t = trades[i];
+		BarrierOption option(t.barrierLevel, t.strike, t.spot, t.riskFreeRate, t.volatility, t.quantity, t.barrierType,
+			t.optionType, t.valueDate, t.expiryDate, t.settlementDate, t.numTimeSteps, 10000, true, -106, 0.01, act365);
+		cout << "  trade " << i << ": price = " << rows(i, OptionResults::PRICE) << " (BarrierOption "
+			<< option().resultSet.at(OptionResults::PRICE) << ")" << endl;
+	}
+	elapsed = std::chrono::steady_clock::now() - begin;
+	cout << "  one BarrierOption per trade: " << elapsed.count() / numSingle << " s per trade" << endl << endl;
+}
+
+void runStatistics()
+{
+	// The demo trade with statistics collected:  where the time went and what the paths did, for
+	// the single-pass and bump-and-reprice greeks, then the same as a metrics dump for monitoring.
+	cout << "Run statistics: " << endl;
+	Date valueDate(2015, 10, 1);
+	Date expiryDate(2017, 9, 30);
+	Date settlementDate(expiryDate.addDays(1));
+	Act365 act365;
+
+	EngineSettings singlePass, bumpAndReprice;
+	singlePass.collectStatistics = bumpAndReprice.collectStatistics = true;
+	bumpAndReprice.greeksMethod = GreeksMethod::BUMP_AND_REPRICE;
+
+	const EngineSettings settings[] = { singlePass, bumpAndReprice };
+	const char* names[] = { "single_pass", "bump_and_reprice" };
+	for (int k = 0; k < 2; ++k)
+	{
+		BarrierOption upOutBarrier(103.0, 102.0, 100.0, 0.025, 0.06, 7000.0, Barrier::UP_AND_OUT, valueDate,
+			expiryDate, settlementDate, 720, 10000, true, -106, 0.01, act365, nullptr, settings[k]);
+		OptionResults res = upOutBarrier();
+		cout << names[k] << ":";
+		res.print();
+		res.statistics.writeMetrics(cout, names[k]);
+		cout << endl;
+	}
+}
+
+void selectiveValuation()
+{
+	// The demo trade valued lazily:  the price alone for a screening run, then the greeks on top
+	// (reusing the price), a repeat request (memoized), and a new spot (which drops the values).
+	cout << "Selective valuation (bump and reprice): " << endl;
+	Date valueDate(2015, 10, 1);
+	Date expiryDate(2017, 9, 30);
+	Date settlementDate(expiryDate.addDays(1));
+	Act365 act365;
+	EngineSettings settings;
+	settings.greeksMethod = GreeksMethod::BUMP_AND_REPRICE;
+
+	BarrierOption upOutBarrier(103.0, 102.0, 100.0, 0.025, 0.06, 7000.0, Barrier::UP_AND_OUT, valueDate,
+		expiryDate, settlementDate, 720, 10000, true, -106, 0.01, act365, nullptr, settings);
+	auto report = [&upOutBarrier](const char* name, unsigned request)
+	{
+		auto begin = std::chrono::steady_clock::now();
+		OptionResults res = upOutBarrier(request);
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+		cout << "  " << name << ": price = " << res.resultSet.at(OptionResults::PRICE);
+		if (res.resultSet.count(OptionResults::DELTA) != 0)
+		{
+			cout << ", delta = " << res.resultSet.at(OptionResults::DELTA);
+		}
+		cout << ", " << elapsed.count() << " s" << endl;
+	};
+
+	report("price only", OptionResults::PRICE_ONLY);
+	report("price, delta, vega and rho", OptionResults::FIRST_ORDER);
+	report("again (memoized)", OptionResults::FIRST_ORDER);
+	upOutBarrier.setSpot(101.0);
+	report("spot 101, price and delta", OptionResults::PRICE_AND_DELTA);
+	cout << endl;
+}
+
+void marketTicks(unsigned numTicks)
+{
+	// The demo trade repriced on a run of spot and vol ticks, with and without cached paths:  the
+	// first valuation stores the paths, and every tick after it reprices from them.
+	cout << "Market ticks (mean wall time per tick, " << numTicks << " ticks): " << endl;
+	Date valueDate(2015, 10, 1);
+	Date expiryDate(2017, 9, 30);
+	Date settlementDate(expiryDate.addDays(1));
+	Act365 act365;
+
+	for (int cached = 0; cached < 2; ++cached)
+	{
+		EngineSettings settings;
+		settings.cachePaths = (cached != 0);
+		BarrierOption upOutBarrier(103.0, 102.0, 100.0, 0.025, 0.06, 7000.0, Barrier::UP_AND_OUT, valueDate,
+			expiryDate, settlementDate, 720, 10000, true, -106, 0.01, act365, nullptr, settings);
+		upOutBarrier();
+		cout << (cached ? "  Cached paths:  first valuation " : "  Uncached:  first valuation ") << upOutBarrier.time() << " s";
+
+		const unsigned requests[] = { OptionResults::PRICE_ONLY, OptionResults::FIRST_ORDER };
+		for (unsigned request : requests)
+		{
+			double price = 0.0;
+			auto begin = std::chrono::steady_clock::now();
+			for (unsigned t = 1; t <= numTicks; ++t)
+			{
+				upOutBarrier.setSpot(100.0 + 0.01 * t);
+				upOutBarrier.setVolatility(0.06 + 0.0001 * (t % 5));
+				price = upOutBarrier(request).resultSet.at(OptionResults::PRICE);
+			}
+			std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+			cout << ((request == OptionResults::PRICE_ONLY) ? ", price " : ", price and greeks ")
+				<< 1000.0 * elapsed.count() / numTicks << " ms (last " << price << ")";
+		}
+		cout << endl;
+	}
+	cout << endl;
+}
+
+void normalStore(unsigned numScenarios)
+{
+	// The demo trade's draws written to a store once, then read back in place:  the values are the
+	// same, without the random number generation.  A store that does not fit the trade is refused.
+	cout << "Normal store (" << numScenarios << " scenarios x 720 steps): " << endl;
+	Date valueDate(2015, 10, 1);
+	Date expiryDate(2017, 9, 30);
+	Date settlementDate(expiryDate.addDays(1));
+	Act365 act365;
+	const char* fileName = "BarrierOptionNormals.bin";
+
+	auto begin = std::chrono::steady_clock::now();
+	NormalStore::build(fileName, RandomStream::PHILOX, -106, numScenarios, 720);
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+	cout << "  Built " << NormalStore(fileName).description() << " in " << elapsed.count() << " s" << endl;
+
+	EngineSettings drawn;
+	EngineSettings stored;
+	stored.normalStore = fileName;
+	for (const EngineSettings& settings : { drawn, stored })
+	{
+		BarrierOption upOutBarrier(103.0, 102.0, 100.0, 0.025, 0.06, 7000.0, Barrier::UP_AND_OUT, valueDate,
+			expiryDate, settlementDate, 720, numScenarios, true, -106, 0.01, act365, nullptr, settings);
+		OptionResults res = upOutBarrier();
+		cout << (settings.normalStore.empty() ? "  Drawn:  price = " : "  Stored:  price = ")
+			<< res.resultSet.at(OptionResults::PRICE) << ", delta = " << res.resultSet.at(OptionResults::DELTA)
+			<< ", " << upOutBarrier.time() << " s" << endl;
+	}
+
+	BarrierOption otherGrid(103.0, 102.0, 100.0, 0.025, 0.06, 7000.0, Barrier::UP_AND_OUT, valueDate,
+		expiryDate, settlementDate, 360, numScenarios, true, -106, 0.01, act365, nullptr, stored);
+	try
+	{
+		otherGrid();
+	}
+	catch (const std::runtime_error& e)
+	{
+		cout << "  360 steps:  " << e.what() << endl;
+	}
+	std::remove(fileName);
+	cout << endl;
+}
+
+void secondOrderGreeks()
+{
+	// Gamma, vanna and volga of the demo trade, and of a down-and-out call with the barrier closer to
+	// the spot:  the single-pass Monte Carlo (one-step survival, in the same pass as the first-order
+	// greeks), with its standard errors, against the quadrature for the same 50 monitoring dates
+	cout << "Second-order greeks (50 steps, 10000 scenarios): " << endl;
+	Date valueDate(2015, 10, 1);
+	Date expiryDate(2017, 9, 30);
+	Date settlementDate(expiryDate.addDays(1));
+	Act365 act365;
+
+	struct Trade { const char* name; double barrierLevel; double volatility; Barrier barrierType; };
+	const Trade trades[] = { { "Up-and-out 103, vol 6%", 103.0, 0.06, Barrier::UP_AND_OUT },
+		{ "Down-and-out 96, vol 20%", 96.0, 0.20, Barrier::DOWN_AND_OUT } };
+	for (const Trade& trade : trades)
+	{
+		const OptionResults ref = DiscreteBarrier(trade.barrierType, OptionType::CALL, trade.barrierLevel, 102.0, 50)
+			.values(100.0, 0.025, trade.volatility, act365.yearFraction(valueDate, expiryDate),
+				act365.yearFraction(valueDate, settlementDate), 7000.0);
+		BarrierOption simulated(trade.barrierLevel, 102.0, 100.0, 0.025, trade.volatility, 7000.0, trade.barrierType,
+			OptionType::CALL, valueDate, expiryDate, settlementDate, 50, 10000, true, -106, 0.01, act365);
+		simulated(OptionResults::FIRST_ORDER);
+		const double firstOrderTime = simulated.time();
+		OptionResults res = simulated(OptionResults::FIRST_ORDER | OptionResults::SECOND_ORDER);
+
+		cout << "  " << trade.name << " (first order " << firstOrderTime << " s, second order "
+			<< simulated.time() - firstOrderTime << " s more):" << endl;
+		const OptionResults::Value values[] = { OptionResults::GAMMA, OptionResults::VANNA, OptionResults::VOLGA };
+		const char* names[] = { "gamma", "vanna", "volga" };
+		for (int v = 0; v < 3; ++v)
+		{
+			cout << "    " << names[v] << " = " << res.resultSet.at(values[v]) << " (+/- " << simulated.stdError(values[v])
+				<< ", quadrature " << ref.resultSet.at(values[v]) << ")" << endl;
+		}
+	}
+	cout << endl;
+}
+
+void adjointSensitivities()
+{
+	// A down-and-out call's sensitivities to spot, vol, rate, strike and barrier:  adjoint
+	// differentiation of each path (one pass for all five, with its standard errors) against bumping
+	// and repricing each input on the same scenarios, and the closed form for the same 720
+	// monitoring dates (at this many dates within 0.1% of DiscreteBarrier's quadrature).  The bumped
+	// values' standard errors are the spread of the same central differences over other seeds.
+	cout << "Sensitivities to five inputs (720 steps, 10000 scenarios): " << endl;
+	Date valueDate(2015, 10, 1);
+	Date expiryDate(2017, 9, 30);
+	Date settlementDate(expiryDate.addDays(1));
+	Act365 act365;
+	const double inputs[] = { 100.0, 0.20, 0.025, 102.0, 96.0 };	// Spot, vol, rate, strike, barrier
+	auto option = [&](const double* x, const EngineSettings& settings, int seed = -106)
+	{
+		return BarrierOption(x[4], x[3], x[0], x[2], x[1], 7000.0, Barrier::DOWN_AND_OUT, OptionType::CALL, valueDate,
+			expiryDate, settlementDate, 720, 10000, true, seed, 0.01, act365, nullptr, settings);
+	};
+	const OptionResults::Value values[] = { OptionResults::DELTA, OptionResults::VEGA, OptionResults::RHO,
+		OptionResults::STRIKE_SENSITIVITY, OptionResults::BARRIER_SENSITIVITY };
+	const char* names[] = { "spot", "vol", "rate", "strike", "barrier" };
+	const unsigned request = OptionResults::FIRST_ORDER | OptionResults::CONTRACT_SENSITIVITIES;
+
+	EngineSettings adjoint;
+	adjoint.greeksMethod = GreeksMethod::ADJOINT;
+	BarrierOption adjointOption = option(inputs, adjoint);
+	OptionResults adjointResults = adjointOption(request);
+
+	EngineSettings analytic;
+	analytic.pricingMethod = PricingMethod::ANALYTIC;
+	analytic.monitoringDates = 720;
+	BarrierOption analyticOption = option(inputs, analytic);
+	OptionResults analyticResults = analyticOption(request);
+
+	// Two price runs per input, bumped up and down by 1% (central differences).  The first seed is
+	// the adjoint run's and is the one timed; the others give the standard errors.
+	const int numSeeds = 8;
+	std::chrono::duration<double> bumpTime(0.0);
+	double bumped[numSeeds][5];
+	for (int seed = 0; seed < numSeeds; ++seed)
+	{
+		auto begin = std::chrono::steady_clock::now();
+		for (int k = 0; k < 5; ++k)
+		{
+			double prices[2];
+			for (int side = 0; side < 2; ++side)
+			{
+				double x[5];
+				std::copy(inputs, inputs + 5, x);
+				x[k] *= side == 0 ? 1.01 : 0.99;
+				BarrierOption bumpedOption = option(x, EngineSettings(), -106 - seed);
+				prices[side] = bumpedOption(OptionResults::PRICE_ONLY).resultSet.at(OptionResults::PRICE);
+			}
+			bumped[seed][k] = (prices[0] - prices[1]) / (0.02 * inputs[k]);
+		}
+		if (seed == 0)
+		{
+			bumpTime = std::chrono::steady_clock::now() - begin;
+		}
+	}
+
+	cout << "  Adjoint " << adjointOption.time() << " s, bump and reprice (10 runs) " << bumpTime.count() << " s"
+		<< endl;
+	for (int k = 0; k < 5; ++k)
+	{
+		double mean = 0.0, sumSq = 0.0;
+		for (int seed = 0; seed < numSeeds; ++seed)
+		{
+			mean += bumped[seed][k] / numSeeds;
+		}
+		for (int seed = 0; seed < numSeeds; ++seed)
+		{
+			sumSq += (bumped[seed][k] - mean) * (bumped[seed][k] - mean);
+		}
+		cout << "    d/d" << names[k] << ":  adjoint " << adjointResults.resultSet.at(values[k]) << " (+/- "
+			<< adjointOption.stdError(values[k]) << "), bumped " << bumped[0][k] << " (+/- "
+			<< std::sqrt(sumSq / (numSeeds - 1)) << "), closed form " << analyticResults.resultSet.at(values[k]) << endl;
+	}
+	cout << endl;
+}
+
+void egarchBarrier()
+{
+	// A down-and-out call with its volatility following EGARCH(1,1) from 20%, through each path
+	// engine, against the same trade at a constant 20%.  alphaZero is set so that the log variance
+	// reverts to about log(0.2^2); gamma < 0 makes a fall in the price raise the volatility.
+	cout << "Barrier under EGARCH volatility (720 steps, 20000 scenarios): " << endl;
+	Date valueDate(2015, 10, 1);
+	Date expiryDate(2017, 9, 30);
+	Date settlementDate(expiryDate.addDays(1));
+	Act365 act365;
+	const std::shared_ptr<const Egarch> egarch = std::make_shared<const Egarch>(-0.1363, 0.1123, -0.0925, 0.9855, 520);
+
+	auto report = [&](const char* name, const EngineSettings& settings)
+	{
+		BarrierOption option(96.0, 102.0, 100.0, 0.025, 0.20, 7000.0, Barrier::DOWN_AND_OUT, OptionType::CALL, valueDate,
+			expiryDate, settlementDate, 720, 20000, true, -106, 0.01, act365, nullptr, settings);
+		OptionResults res = option();
+		cout << "  " << name << ":  price " << res.resultSet.at(OptionResults::PRICE) << " (+/- " << option.stdError()
+			<< "), delta " << res.resultSet.at(OptionResults::DELTA) << ", " << option.time() << " s" << endl;
+	};
+
+	report("Constant vol, fused", EngineSettings());
+	const PathEngine engines[] = { PathEngine::FUSED, PathEngine::SIMD_BATCH };
+	const char* engineNames[] = { "EGARCH, fused, single pass", "EGARCH, SIMD batch, bump and reprice" };
+	for (int e = 0; e < 2; ++e)
+	{
+		// The batch kernel only takes the bumped price runs (single pass always uses the fused one)
+		EngineSettings settings;
+		settings.egarch = egarch;
+		settings.pathEngine = engines[e];
+		settings.greeksMethod = (engines[e] == PathEngine::SIMD_BATCH) ? GreeksMethod::BUMP_AND_REPRICE
+			: GreeksMethod::SINGLE_PASS;
+		report(engineNames[e], settings);
+	}
+	cout << endl;
+}
+
+void egarchCalibration(unsigned numSymbols)
+{
+	// Ten years of daily returns per symbol, simulated from a known EGARCH process (daily vol
+	// reverting to about 1.3%), fitted back by maximum likelihood:  on one thread, then one series
+	// per task on the shared pool.  The first symbol's fit then prices the demo down-and-out.
+	const double truth[EgarchCalibrator::NUM_PARAMETERS] = { -0.38, 0.15, -0.4, 0.97 };
+	const unsigned numReturns = 2520;
+	cout << "EGARCH calibration (" << numSymbols << " symbols x " << numReturns << " daily returns): " << endl;
+	const Egarch process(truth[0], truth[1], truth[2], truth[3], 0);
+	vector<double> returns(static_cast<size_t>(numSymbols) * numReturns);
+	vector<ReturnSeries> series;
+	for (unsigned s = 0; s < numSymbols; ++s)
+	{
+		PhiloxNormals normals(7, s);
+		double logVariance = (truth[0] + truth[1] * std::sqrt(2.0 / 3.14159265358979323846)) / (1.0 - truth[3]);
+		double* r = &returns[static_cast<size_t>(s) * numReturns];
+		for (unsigned t = 0; t < numReturns; ++t)
+		{
+			double z = normals();
+			r[t] = std::exp(0.5 * logVariance) * z;
+			logVariance = process.logVariance(logVariance, z);
+		}
+		series.push_back(ReturnSeries{ r, numReturns });
+	}
+
+	PricingThreadPool serialPool(1);
+	const char* names[] = { "1 thread", "shared pool" };
+	PricingThreadPool* pools[] = { &serialPool, &PricingThreadPool::shared() };
+	vector<EgarchFit> fits;
+	for (int p = 0; p < 2; ++p)
+	{
+		auto begin = std::chrono::steady_clock::now();
+		fits = EgarchCalibrator(200, 1.0e-7, pools[p])(series);
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+		cout << "  " << names[p] << " (" << pools[p]->numThreads() << " threads):  " << elapsed.count() << " s, "
+			<< numSymbols / elapsed.count() << " series/s" << endl;
+	}
+
+	double mean[EgarchCalibrator::NUM_PARAMETERS] = { 0.0, 0.0, 0.0, 0.0 };
+	unsigned converged = 0;
+	for (const EgarchFit& fit : fits)
+	{
+		mean[0] += fit.alphaZero / numSymbols;
+		mean[1] += fit.alphaOne / numSymbols;
+		mean[2] += fit.gamma / numSymbols;
+		mean[3] += fit.beta / numSymbols;
+		converged += fit.converged ? 1 : 0;
+	}
+	const char* parameterNames[] = { "alphaZero", "alphaOne", "gamma", "beta" };
+	cout << "  Converged " << converged << " of " << numSymbols << "; mean fit (true value):";
+	for (int k = 0; k < EgarchCalibrator::NUM_PARAMETERS; ++k)
+	{
+		cout << "  " << parameterNames[k] << " " << mean[k] << " (" << truth[k] << ")";
+	}
+	cout << endl;
+
+	// Paths stepping once a trading day for the demo's two years, from the fitted daily vol annualized
+	Date valueDate(2015, 10, 1);
+	Date expiryDate(2017, 9, 30);
+	Date settlementDate(expiryDate.addDays(1));
+	Act365 act365;
+	EngineSettings settings;
+	settings.egarch = std::make_shared<const Egarch>(fits[0].egarch(252.0));
+	const double volatility = std::sqrt(252.0) * std::exp(0.5 * (fits[0].alphaZero + fits[0].alphaOne
+		* std::sqrt(2.0 / 3.14159265358979323846)) / (1.0 - fits[0].beta));
+	BarrierOption option(96.0, 102.0, 100.0, 0.025, volatility, 7000.0, Barrier::DOWN_AND_OUT, OptionType::CALL,
+		valueDate, expiryDate, settlementDate, 504, 20000, true, -106, 0.01, act365, nullptr, settings);
+	cout << "  Down-and-out under the first fit (from vol " << volatility << "):  price "
+		<< option(OptionResults::PRICE_ONLY).resultSet.at(OptionResults::PRICE) << " (+/- " << option.stdError() << ")"
+		<< endl << endl;
+}
+
+void multilevelMonteCarlo(double targetStdError)
+{
+	// A down-and-out at 85, monitored about daily (768 steps), to the same standard error by one level
+	// of 768 steps and by multilevel Monte Carlo over 12, 24, ..., 768 steps, with the levels the
+	// multilevel run chose and the steps each needed.  Most paths live to expiry, so the single level
+	// pays for nearly every step.  Each level halves the step, and a discrete barrier's bias goes as
+	// sqrt(dt), so the levels' means and variances fall by about 1/sqrt(2) a level.
+	cout << "Multilevel Monte Carlo (standard error " << targetStdError << "): " << endl;
+	Date valueDate(2015, 10, 1);
+	Date expiryDate(2017, 9, 30);
+	Date settlementDate(expiryDate.addDays(1));
+	Act365 act365;
+
+	EngineSettings singleLevel, multilevel;
+	singleLevel.targetStdError = multilevel.targetStdError = targetStdError;
+	singleLevel.collectStatistics = multilevel.collectStatistics = true;
+	multilevel.multilevel = true;
+	multilevel.greeksMethod = GreeksMethod::BUMP_AND_REPRICE;
+
+	const EngineSettings settings[] = { singleLevel, multilevel };
+	const char* names[] = { "One level", "Multilevel" };
+	for (int k = 0; k < 2; ++k)
+	{
+		BarrierOption option(85.0, 102.0, 100.0, 0.025, 0.20, 7000.0, Barrier::DOWN_AND_OUT, OptionType::CALL, valueDate,
+			expiryDate, settlementDate, 768, 1000000, true, -106, 0.01, act365, nullptr, settings[k]);
+		OptionResults res = option(OptionResults::PRICE_ONLY);
+		const RunStatistics& statistics = res.statistics;
+		cout << "  " << names[k] << ":  price " << res.resultSet.at(OptionResults::PRICE) << " (+/- "
+			<< option.stdError() << "), " << res.resultSet.at(OptionResults::NUM_SCENARIOS) << " scenarios, "
+			<< statistics.stepsSimulated << " steps simulated, " << option.time() << " s" << endl;
+		for (std::size_t l = 0; l < statistics.levels.size(); ++l)
+		{
+			const RunStatistics::Level& level = statistics.levels[l];
+			cout << "    Level " << l << " (" << level.coarseSteps << " -> " << level.fineSteps << " steps):  "
+				<< level.scenarios << " scenarios, mean " << 7000.0 * level.mean << ", variance " << level.variance
+				<< ", " << level.wallTime << " s" << endl;
+		}
+		if (!statistics.levels.empty())
+		{
+			cout << "    Steps at 768 for the same error:  " << statistics.singleLevelSteps() << " (multilevel "
+				<< statistics.multilevelSteps() << ")" << endl;
+		}
+	}
+	cout << endl;
+}
+
+void termStructure()
+{
+	// A five-year down-and-out call, daily steps, on rates rising from 1% to 3.5% and vols falling
+	// from 26% to 18% a year at a time, against the flat 2.5% and 20% it is quoted at.  Vega and rho
+	// are then parallel shifts of the curves.  The fused and SIMD batch engines run off the same
+	// per-step tables.
+	cout << "Barrier on a rate and volatility term structure (1260 steps, 20000 scenarios): " << endl;
+	Date valueDate(2015, 10, 1);
+	Date expiryDate(2020, 9, 30);
+	Date settlementDate(expiryDate.addDays(1));
+	Act365 act365;
+	const std::shared_ptr<const TermStructure> curves = std::make_shared<const TermStructure>(
+		vector<double>{ 1.0, 2.0, 3.0, 4.0, 5.0 }, vector<double>{ 0.01, 0.015, 0.025, 0.03, 0.035 },
+		vector<double>{ 0.26, 0.23, 0.20, 0.19, 0.18 });
+
+	EngineSettings flat, fused, batch;
+	fused.termStructure = batch.termStructure = curves;
+	batch.pathEngine = PathEngine::SIMD_BATCH;
+	batch.greeksMethod = GreeksMethod::BUMP_AND_REPRICE;
+
+	const EngineSettings settings[] = { flat, fused, batch };
+	const char* names[] = { "Flat 2.5%, 20%", "Curves, fused, single pass", "Curves, SIMD batch, bump and reprice" };
+	for (int k = 0; k < 3; ++k)
+	{
+		BarrierOption option(80.0, 102.0, 100.0, 0.025, 0.20, 7000.0, Barrier::DOWN_AND_OUT, OptionType::CALL, valueDate,
+			expiryDate, settlementDate, 1260, 20000, true, -106, 0.01, act365, nullptr, settings[k]);
+		OptionResults res = option();
+		cout << "  " << names[k] << ":  price " << res.resultSet.at(OptionResults::PRICE) << " (+/- " << option.stdError()
+			<< "), delta " << res.resultSet.at(OptionResults::DELTA) << ", vega " << res.resultSet.at(OptionResults::VEGA)
+			<< ", rho " << res.resultSet.at(OptionResults::RHO) << ", " << option.time() << " s" << endl;
+	}
+	cout << endl;
+}
+
+void payoffPolicies()
+{
+	// All eight single-barrier contracts, each with a cash rebate of 3, by Monte Carlo on 252 daily
+	// monitoring dates (the fused engine, instantiated for each contract) against the closed form
+	// with the barrier shifted for the same 252 dates
+	cout << "Barrier and option types with a rebate (252 steps, 20000 scenarios): " << endl;
+	Date valueDate(2015, 10, 1);
+	Date expiryDate(2016, 9, 30);
+	Date settlementDate(expiryDate.addDays(2));
+	Act365 act365;
+
+	EngineSettings monteCarlo, analytic;
+	analytic.pricingMethod = PricingMethod::ANALYTIC;
+	analytic.monitoringDates = 252;
+
+	const Barrier barriers[] = { Barrier::UP_AND_OUT, Barrier::DOWN_AND_OUT, Barrier::UP_AND_IN, Barrier::DOWN_AND_IN };
+	const char* barrierNames[] = { "up-and-out", "down-and-out", "up-and-in", "down-and-in" };
+	for (int b = 0; b < 4; ++b)
+	{
+		const double barrierLevel = isUpBarrier(barriers[b]) ? 115.0 : 88.0;
+		for (OptionType optionType : { OptionType::CALL, OptionType::PUT })
+		{
+			BarrierOption mc(barrierLevel, 100.0, 100.0, 0.025, 0.20, 1.0, barriers[b], optionType, 3.0, valueDate,
+				expiryDate, settlementDate, 252, 20000, true, -106, 0.01, act365, nullptr, monteCarlo);
+			BarrierOption closedForm(barrierLevel, 100.0, 100.0, 0.025, 0.20, 1.0, barriers[b], optionType, 3.0, valueDate,
+				expiryDate, settlementDate, 252, 20000, true, -106, 0.01, act365, nullptr, analytic);
+			double price = mc(OptionResults::PRICE_ONLY).resultSet.at(OptionResults::PRICE);
+			cout << "  " << barrierNames[b] << ((optionType == OptionType::CALL) ? " call" : " put") << ":  MC "
+				<< price << " (+/- " << mc.stdError() << "), closed form "
+				<< closedForm(OptionResults::PRICE_ONLY).resultSet.at(OptionResults::PRICE) << endl;
+		}
+	}
+	cout << endl;
+}
+
+void doubleAndWindowBarriers()
+{
+	// A one-year double knock-out call on the corridor 85 to 120:  monitored daily, then continuously
+	// (the bridge weighting on 50 steps against plain monitoring on 5000).  Then a down-and-out call
+	// monitored only in its first three months, against the same barrier over the whole year.
+	cout << "Double and window barriers (20000 scenarios): " << endl;
+	Date valueDate(2015, 10, 1);
+	Date expiryDate(2016, 9, 30);
+	Date settlementDate(expiryDate.addDays(1));
+	Date windowEnd(2015, 12, 31);
+	Act365 act365;
+
+	EngineSettings discrete, bridge;
+	bridge.barrierMonitoring = BarrierMonitoring::BRIDGE_WEIGHT;
+	struct Run
+	{
+		const char* name;
+		unsigned numTimeSteps;
+		const EngineSettings& settings;
+	};
+	const Run runs[] = { { "daily monitoring, 252 steps", 252, discrete }, { "continuous, bridge on 50 steps", 50, bridge },
+		{ "continuous, plain on 5000 steps", 5000, discrete } };
+	for (const Run& run : runs)
+	{
+		BarrierOption option(85.0, 120.0, 100.0, 100.0, 0.025, 0.20, 1.0, false, OptionType::CALL, 0.0, valueDate,
+			expiryDate, valueDate, expiryDate, settlementDate, run.numTimeSteps, 20000, true, -106, 0.01, act365, nullptr,
+			run.settings);
+		OptionResults res = option();
+		cout << "  Double knock-out call, " << run.name << ":  price " << res.resultSet.at(OptionResults::PRICE)
+			<< " (+/- " << option.stdError() << "), delta " << res.resultSet.at(OptionResults::DELTA) << ", "
+			<< option.time() << " s" << endl;
+	}
+
+	const Date windowEnds[] = { windowEnd, expiryDate };
+	const char* windowNames[] = { "first three months", "whole year" };
+	for (int w = 0; w < 2; ++w)
+	{
+		BarrierOption option(92.0, std::numeric_limits<double>::infinity(), 100.0, 100.0, 0.025, 0.20, 1.0, false,
+			OptionType::CALL, 0.0, valueDate, windowEnds[w], valueDate, expiryDate, settlementDate, 252, 20000, true, -106,
+			0.01, act365);
+		OptionResults res = option();
+		cout << "  Down-and-out call at 92, monitored over the " << windowNames[w] << ":  price "
+			<< res.resultSet.at(OptionResults::PRICE) << " (+/- " << option.stdError() << "), "
+			<< option.time() << " s" << endl;
+	}
+	cout << endl;
+}
+
+void singlePrecision()
+{
+	// A one-year down-and-out call on 252 steps, by the fused engine and by the SIMD batch engine in
+	// double and in single precision.  The single-precision run reports how far its first 2048
+	// scenarios moved from double, against the standard error of the price.
+	cout << "Single-precision paths (252 steps, 50000 scenarios): " << endl;
+	Date valueDate(2015, 10, 1);
+	Date expiryDate(2016, 9, 30);
+	Date settlementDate(expiryDate.addDays(2));
+	Act365 act365;
+
+	const PathEngine engines[] = { PathEngine::FUSED, PathEngine::SIMD_BATCH, PathEngine::SIMD_BATCH };
+	const Precision precisions[] = { Precision::DOUBLE, Precision::DOUBLE, Precision::SINGLE };
+	const char* names[] = { "fused, double", "SIMD batch, double", "SIMD batch, single" };
+	for (int e = 0; e < 3; ++e)
+	{
+		EngineSettings settings;
+		settings.pathEngine = engines[e];
+		settings.precision = precisions[e];
+		BarrierOption option(88.0, 100.0, 100.0, 0.025, 0.20, 1.0, Barrier::DOWN_AND_OUT, OptionType::CALL, valueDate,
+			expiryDate, settlementDate, 252, 50000, false, -106, 0.01, act365, nullptr, settings);
+		OptionResults res = option(OptionResults::PRICE_ONLY);
+		cout << "  " << names[e] << ":  price " << res.resultSet.at(OptionResults::PRICE) << " (+/- " << option.stdError()
+			<< "), " << option.time() << " s";
+		if (precisions[e] == Precision::SINGLE)
+		{
+			cout << ", " << option.precisionDifference() << " from double";
+		}
+		cout << endl;
+	}
+	cout << endl;
+}
@@ -0,0 +1,266 @@
+// Regression tests:  each estimator against a reference it does not share code with.  A separate
+// executable from Main.cpp; build it from this file and every source file in the parent directory
+// except Main.cpp, eg
+//
+//   g++ -std=c++17 -O2 -pthread -I.. PricingTests.cpp $(ls ../*.cpp | grep -v Main.cpp)
+//
+// Usage:  PricingTests
+//
+// Every check prints PASS or FAIL with the figures it compared, and the exit status is the number
+// of checks that failed.  The Monte Carlo checks run on fixed seeds, so they pass or fail the same
+// way every time.
+
+#include "../BarrierOption.h"
+#include "../AnalyticBarrier.h"
+#include "../PortfolioPricer.h"
+#include "../NormalStore.h"
+#include "../RandomStreams.h"
+#include "../Date.h"
+#include "../DayCount.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <cmath>
+#include <cstdio>
+
+using std::vector;
+using std::string;
+using std::cout;
+using std::endl;
+
+namespace
+{
+	int failures = 0;
+
+	void check(bool passed, const string& what)
+	{
+		cout << (passed ? "PASS  " : "FAIL  ") << what << endl;
+		failures += passed ? 0 : 1;
+	}
+
+	// Whether actual is within tolerance of expected, relative to expected's size (absolute below 1)
+	bool near(double actual, double expected, double tolerance)
+	{
+		return std::abs(actual - expected) <= tolerance * std::max(1.0, std::abs(expected));
+	}
+
+	string compared(double actual, double expected)
+	{
+		return std::to_string(actual) + " against " + std::to_string(expected);
+	}
+
+	double normalCdf(double x)
+	{
+		return 0.5 * std::erfc(-x / std::sqrt(2.0));
+	}
+
+	// Ikeda and Kunitomo (1992), in the form given by Haug, 4.17.3:  a double knock-out call on the
+	// corridor (lower, upper), both barriers flat and monitored continuously, no dividends.  The
+	// series over n converges fast enough that |n| <= 5 is exact to rounding.
+	double ikedaKunitomoCall(double spot, double strike, double lower, double upper, double rate, double vol,
+		double t)
+	{
+		const double mu1 = 2.0 * rate / (vol * vol) + 1.0;
+		const double mu3 = mu1;
+		const double sigmaRootT = vol * std::sqrt(t);
+		const double drift = (rate + vol * vol / 2.0) * t;
+		double call = 0.0;
+		for (int n = -5; n <= 5; ++n)
+		{
+			const double ratio = std::pow(upper / lower, n);
+			const double mirror = std::pow(lower, n + 1.0) / (std::pow(upper, n) * spot);
+			const double d1 = (std::log(spot * ratio * ratio / strike) + drift) / sigmaRootT;
+			const double d2 = (std::log(spot * ratio * ratio / upper) + drift) / sigmaRootT;
+			const double d3 = (std::log(mirror * mirror * spot / strike) + drift) / sigmaRootT;
+			const double d4 = (std::log(mirror * mirror * spot / upper) + drift) / sigmaRootT;
+			call += spot * (std::pow(ratio, mu1) * (normalCdf(d1) - normalCdf(d2))
+				- std::pow(mirror, mu3) * (normalCdf(d3) - normalCdf(d4)));
+			call -= strike * std::exp(-rate * t) * (std::pow(ratio, mu1 - 2.0) * (normalCdf(d1 - sigmaRootT)
+				- normalCdf(d2 - sigmaRootT)) - std::pow(mirror, mu3 - 2.0) * (normalCdf(d3 - sigmaRootT)
+				- normalCdf(d4 - sigmaRootT)));
+		}
+		return call;
+	}
+
+	double blackScholesCall(double spot, double strike, double rate, double vol, double t)
+	{
+		const double d1 = (std::log(spot / strike) + (rate + vol * vol / 2.0) * t) / (vol * std::sqrt(t));
+		return spot * normalCdf(d1) - strike * std::exp(-rate * t) * normalCdf(d1 - vol * std::sqrt(t));
+	}
+}
+
+// AnalyticBarrier's single barriers are Ikeda-Kunitomo's corridor with the other barrier out of
+// reach, and the Monte Carlo corridor with the bridge weighting prices the continuous contract
+void closedFormAgainstIkedaKunitomo()
+{
+	const double spot = 100.0, strike = 102.0, rate = 0.025, vol = 0.20, t = 2.0;
+
+	const double downOut = AnalyticBarrier(Barrier::DOWN_AND_OUT, OptionType::CALL, 85.0, strike).price(spot, rate, vol, t, t);
+	const double downOutLimit = ikedaKunitomoCall(spot, strike, 85.0, 100.0 * spot, rate, vol, t);
+	check(near(downOut, downOutLimit, 1.0e-10), "Down-and-out call, closed form " + compared(downOut, downOutLimit));
+
+	const double upOut = AnalyticBarrier(Barrier::UP_AND_OUT, OptionType::CALL, 130.0, strike).price(spot, rate, vol, t, t);
+	const double upOutLimit = ikedaKunitomoCall(spot, strike, spot / 100.0, 130.0, rate, vol, t);
+	check(near(upOut, upOutLimit, 1.0e-10), "Up-and-out call, closed form " + compared(upOut, upOutLimit));
+
+	// In-out parity
+	const double downIn = AnalyticBarrier(Barrier::DOWN_AND_IN, OptionType::CALL, 85.0, strike).price(spot, rate, vol, t, t);
+	const double downInLimit = blackScholesCall(spot, strike, rate, vol, t) - downOutLimit;
+	check(near(downIn, downInLimit, 1.0e-10), "Down-and-in call, closed form " + compared(downIn, downInLimit));
+
+	// One year (365 days, Act365) on the corridor 85 to 120, settled at expiry
+	Date valueDate(2015, 10, 1);
+	Date expiryDate(2016, 9, 30);
+	Act365 act365;
+	EngineSettings bridge;
+	bridge.barrierMonitoring = BarrierMonitoring::BRIDGE_WEIGHT;
+	BarrierOption corridor(85.0, 120.0, strike, spot, rate, vol, 1.0, false, OptionType::CALL, 0.0, valueDate, expiryDate,
+		valueDate, expiryDate, expiryDate, 50, 20000, true, -106, 0.01, act365, nullptr, bridge);
+	const double monteCarlo = corridor(OptionResults::PRICE_ONLY).resultSet.at(OptionResults::PRICE);
+	const double corridorLimit = ikedaKunitomoCall(spot, strike, 85.0, 120.0, rate, vol, 1.0);
+	check(std::abs(monteCarlo - corridorLimit) <= 4.0 * corridor.stdError(), "Double knock-out call, bridge on 50 steps "
+		+ compared(monteCarlo, corridorLimit) + " (+/- " + std::to_string(corridor.stdError()) + ")");
+}
+
+// The SIMD batch kernel draws each scenario's Philox normals as the fused kernel does, so the
+// prices agree to rounding, for every barrier and option type
+void batchAgainstFused()
+{
+	Date valueDate(2015, 10, 1);
+	Date expiryDate(2016, 9, 30);
+	Date settlementDate(expiryDate.addDays(1));
+	Act365 act365;
+	EngineSettings fused, batch;
+	batch.pathEngine = PathEngine::SIMD_BATCH;
+
+	const Barrier barriers[] = { Barrier::UP_AND_OUT, Barrier::DOWN_AND_OUT, Barrier::UP_AND_IN, Barrier::DOWN_AND_IN };
+	const char* names[] = { "Up-and-out", "Down-and-out", "Up-and-in", "Down-and-in" };
+	for (int b = 0; b < 4; ++b)
+	{
+		for (OptionType optionType : { OptionType::CALL, OptionType::PUT })
+		{
+			const double barrierLevel = isUpBarrier(barriers[b]) ? 115.0 : 88.0;
+			double prices[2];
+			int k = 0;
+			for (const EngineSettings& settings : { fused, batch })
+			{
+				BarrierOption option(barrierLevel, 100.0, 100.0, 0.025, 0.20, 1.0, barriers[b], optionType, valueDate,
+					expiryDate, settlementDate, 252, 4000, true, -106, 0.01, act365, nullptr, settings);
+				prices[k++] = option(OptionResults::PRICE_ONLY).resultSet.at(OptionResults::PRICE);
+			}
+			check(near(prices[1], prices[0], 1.0e-9), string(names[b]) + (optionType == OptionType::CALL ? " call" : " put")
+				+ ", SIMD batch " + compared(prices[1], prices[0]) + " fused");
+		}
+	}
+}
+
+// PortfolioPricer's rows are the values of BarrierOptions with the same seed, to rounding
+void portfolioAgainstBarrierOption()
+{
+	Date valueDate(2015, 10, 1);
+	Date expiryDate(2017, 9, 30);
+	Date settlementDate(expiryDate.addDays(1));
+	Act365 act365;
+
+	const Barrier barriers[] = { Barrier::UP_AND_OUT, Barrier::DOWN_AND_OUT, Barrier::UP_AND_IN, Barrier::DOWN_AND_IN };
+	vector<BarrierTrade> trades;
+	for (unsigned i = 0; i < 8; ++i)
+	{
+		const Barrier barrier = barriers[i % 4];
+		trades.push_back(BarrierTrade(isUpBarrier(barrier) ? 103.0 + i : 97.0 - i, 95.0 + i, 100.0, 0.025, 0.06,
+			(i % 3 == 2) ? -7000.0 : 7000.0, barrier, (i < 4) ? OptionType::CALL : OptionType::PUT, valueDate,
+			expiryDate, settlementDate, 360));
+	}
+
+	const OptionResultTable rows = PortfolioPricer(5000, -106, 0.01, act365).table(trades);
+	const OptionResults::Value values[] = { OptionResults::PRICE, OptionResults::DELTA, OptionResults::VEGA,
+		OptionResults::RHO, OptionResults::STD_ERROR, OptionResults::NUM_SCENARIOS };
+	const char* names[] = { "price", "delta", "vega", "rho", "standard error", "scenarios" };
+	for (size_t i = 0; i < trades.size(); ++i)
+	{
+		const BarrierTrade& t = trades[i];
+		BarrierOption option(t.barrierLevel, t.strike, t.spot, t.riskFreeRate, t.volatility, t.quantity, t.barrierType,
+			t.optionType, t.valueDate, t.expiryDate, t.settlementDate, t.numTimeSteps, 5000, true, -106, 0.01, act365);
+		const OptionResults results = option();
+		string mismatches;
+		for (int v = 0; v < 6; ++v)
+		{
+			const double expected = results.resultSet.at(values[v]);
+			if (!near(rows(i, values[v]), expected, 1.0e-9))
+			{
+				mismatches += string(", ") + names[v] + " " + compared(rows(i, values[v]), expected);
+			}
+		}
+		check(mismatches.empty(), "Trade " + std::to_string(i) + ", portfolio row against BarrierOption (price "
+			+ compared(rows(i, OptionResults::PRICE), results.resultSet.at(OptionResults::PRICE)) + ")" + mismatches);
+	}
+}
+
+// A store holds the draws the stream would give, and a valuation that reads them gets the values
+// of one that draws them; a store built for another grid is refused
+void normalStoreRoundTrip()
+{
+	const char* fileName = "PricingTestsNormals.bin";
+	const unsigned numSteps = 64;
+	const size_t numSamples = 300;
+	NormalStore::build(fileName, RandomStream::PHILOX, -106, numSamples, numSteps);
+	{
+		const NormalStore store(fileName);
+		check(store.stream() == RandomStream::PHILOX && store.seed() == -106 && store.numSamples() == numSamples
+			&& store.numSteps() == numSteps, "Normal store header: " + store.description());
+
+		bool same = true;
+		for (size_t j : { size_t(0), size_t(1), numSamples - 1 })
+		{
+			PhiloxNormals normals(-106, j);
+			for (unsigned k = 0; k < numSteps; ++k)
+			{
+				same = same && store.sample(j)[k] == normals();
+			}
+		}
+		check(same, "Normal store samples equal the Philox draws");
+	}
+
+	Date valueDate(2015, 10, 1);
+	Date expiryDate(2016, 9, 30);
+	Date settlementDate(expiryDate.addDays(1));
+	Act365 act365;
+	EngineSettings drawn, stored;
+	stored.normalStore = fileName;
+	double prices[2], deltas[2];
+	int k = 0;
+	for (const EngineSettings& settings : { drawn, stored })
+	{
+		BarrierOption option(103.0, 102.0, 100.0, 0.025, 0.06, 7000.0, Barrier::UP_AND_OUT, valueDate, expiryDate,
+			settlementDate, numSteps, static_cast<unsigned>(numSamples), true, -106, 0.01, act365, nullptr, settings);
+		const OptionResults results = option();
+		prices[k] = results.resultSet.at(OptionResults::PRICE);
+		deltas[k++] = results.resultSet.at(OptionResults::DELTA);
+	}
+	check(prices[1] == prices[0] && deltas[1] == deltas[0], "Stored draws, price " + compared(prices[1], prices[0])
+		+ " drawn, delta " + compared(deltas[1], deltas[0]));
+
+	bool refused = false;
+	try
+	{
+		BarrierOption(103.0, 102.0, 100.0, 0.025, 0.06, 7000.0, Barrier::UP_AND_OUT, valueDate, expiryDate,
+			settlementDate, 2 * numSteps, static_cast<unsigned>(numSamples), true, -106, 0.01, act365, nullptr, stored)();
+	}
+	catch (const std::runtime_error&)
+	{
+		refused = true;
+	}
+	check(refused, "Normal store refused for another number of steps");
+	std::remove(fileName);
+}
+
+int main()
+{
+	closedFormAgainstIkedaKunitomo();
+	batchAgainstFused();
+	portfolioAgainstBarrierOption();
+	normalStoreRoundTrip();
+	cout << (failures == 0 ? "All checks passed" : std::to_string(failures) + " checks failed") << endl;
+	return failures;
+}
@@ -0,0 +1,91 @@
+// Builds a file of precomputed normal draws (see NormalStore.h) for BarrierOption and
+// PortfolioPricer to read through EngineSettings::normalStore.  A separate executable from
+// Main.cpp; build it from this file and every source file in the parent directory except
+// Main.cpp, eg
+//
+//   g++ -std=c++17 -O2 -pthread -I.. BuildNormalStore.cpp $(ls ../*.cpp | grep -v Main.cpp)
+//
+// Usage:  BuildNormalStore <file> <PHILOX | MT19937 | SOBOL> <seed> <samples> <steps> [<replications>]
+//         BuildNormalStore --info <file>
+//
+// samples is the number of scenarios (antithetic pairs, with EngineSettings::antithetic), steps
+// the trade's numTimeSteps, and replications the EngineSettings::qmcReplications of a SOBOL run.
+// --info prints a store's header, after the same version and size checks a pricer makes.
+
+#include "../NormalStore.h"
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+#include <stdexcept>
+
+using std::cout;
+using std::cerr;
+using std::endl;
+using std::string;
+
+namespace
+{
+	int usage()
+	{
+		cerr << "Usage:  BuildNormalStore <file> <PHILOX | MT19937 | SOBOL> <seed> <samples> <steps> [<replications>]" << endl;
+		cerr << "        BuildNormalStore --info <file>" << endl;
+		return 2;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	try
+	{
+		if (argc == 3 && string(argv[1]) == "--info")
+		{
+			NormalStore store(argv[2]);
+			cout << argv[2] << ":  " << store.description() << endl;
+			return 0;
+		}
+		if (argc != 6 && argc != 7)
+		{
+			return usage();
+		}
+
+		RandomStream stream;
+		const string streamName = argv[2];
+		if (streamName == "PHILOX")
+		{
+			stream = RandomStream::PHILOX;
+		}
+		else if (streamName == "MT19937")
+		{
+			stream = RandomStream::MT19937_PER_SCENARIO;
+		}
+		else if (streamName == "SOBOL")
+		{
+			stream = RandomStream::SOBOL;
+		}
+		else
+		{
+			return usage();
+		}
+		const int seed = std::atoi(argv[3]);
+		const long long numSamples = std::atoll(argv[4]);
+		const long numSteps = std::atol(argv[5]);
+		const long numReplications = (argc == 7) ? std::atol(argv[6]) : EngineSettings().qmcReplications;
+		if (numSamples <= 0 || numSteps <= 0 || numReplications <= 0)
+		{
+			return usage();
+		}
+
+		const auto begin = std::chrono::steady_clock::now();
+		NormalStore::build(argv[1], stream, seed, static_cast<std::size_t>(numSamples), static_cast<unsigned>(numSteps),
+			static_cast<unsigned>(numReplications));
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+		cout << argv[1] << ":  " << NormalStore(argv[1]).description() << " (" << elapsed.count() << " s)" << endl;
+		return 0;
+	}
+	catch (const std::exception& e)
+	{
+		cerr << e.what() << endl;
+		return 1;
+	}
+}